@@ -6,6 +6,10 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <cassert>
+#include <type_traits>
+#include "ast_arena.h"
+#include "identifier_table.h"
 
 // 前向声明
 class ASTNode;
@@ -17,16 +21,76 @@ class CompUnitAST;
 
 // ==================== 基础节点 ====================
 
+// 节点类型标签：配合 classof 实现 isa/cast/dyn_cast 与 switch 分发，代替 dynamic_cast。
+// 同一抽象基类的子类连续排列，基类用 First/Last 区间判断
+enum class ASTKind {
+    // 表达式
+    IntConstExpr,
+    FloatConstExpr,
+    LValExpr,
+    BinaryExpr,
+    UnaryExpr,
+    CallExpr,
+    StringLiteralExpr,
+    FirstExpr = IntConstExpr,
+    LastExpr = StringLiteralExpr,
+    
+    Type,
+    
+    // 初始化值
+    ExprInitVal,
+    ListInitVal,
+    FirstInitVal = ExprInitVal,
+    LastInitVal = ListInitVal,
+    
+    // 声明
+    VarDecl,
+    ConstDecl,
+    FirstDecl = VarDecl,
+    LastDecl = ConstDecl,
+    VarDef,
+    ConstDef,
+    
+    // 语句
+    AssignStmt,
+    ExprStmt,
+    ReturnStmt,
+    IfStmt,
+    WhileStmt,
+    BreakStmt,
+    ContinueStmt,
+    Block,
+    FirstStmt = AssignStmt,
+    LastStmt = Block,
+    
+    // 块项
+    DeclBlockItem,
+    StmtBlockItem,
+    FirstBlockItem = DeclBlockItem,
+    LastBlockItem = StmtBlockItem,
+    
+    FuncFParam,
+    Function,
+    CompUnit
+};
+
 // AST 基类
 class ASTNode {
 private:
+    const ASTKind nodeKind;
     int lineNumber; // 行号信息
 protected:
      bool marked_for_deletion = false;  // 用于死代码消除
 
 public:
-    ASTNode(int line = -1) : lineNumber(line) {}
+    explicit ASTNode(ASTKind kind, int line = -1) : nodeKind(kind), lineNumber(line) {}
     virtual ~ASTNode() = default;
+    
+    ASTKind getNodeKind() const { return nodeKind; }
+    
+    // 节点从当前线程的 ASTArena 分配（见 ast_arena.h）
+    static void* operator new(size_t size) { return ASTArena::allocateNode(size); }
+    static void operator delete(void* ptr) { ASTArena::deallocateNode(ptr); }
     virtual void print(int indent = 0) const = 0;
     
     // 克隆方法，用于函数内联等优化
@@ -49,11 +113,40 @@ protected:
     }
 };
 
+// ==================== 类型判断与转换 ====================
+
+// 用法同 LLVM 的 isa/cast/dyn_cast：依据 getNodeKind() 与各类的 classof 判断，不依赖 RTTI。
+// 与 LLVM 不同，isa/dyn_cast 接受空指针（分别返回 false/nullptr）。
+template <typename To, typename From>
+using ASTCastResult = typename std::conditional<std::is_const<From>::value, const To*, To*>::type;
+
+template <typename To, typename From>
+inline bool isa(From* node) {
+    static_assert(std::is_base_of<ASTNode, typename std::remove_const<From>::type>::value,
+                  "isa<> is only for AST nodes");
+    return node && To::classof(node);
+}
+
+template <typename To, typename From>
+inline ASTCastResult<To, From> cast(From* node) {
+    assert(isa<To>(node) && "cast<>() argument of incompatible type");
+    return static_cast<ASTCastResult<To, From>>(node);
+}
+
+template <typename To, typename From>
+inline ASTCastResult<To, From> dyn_cast(From* node) {
+    return isa<To>(node) ? static_cast<ASTCastResult<To, From>>(node) : nullptr;
+}
+
 // ==================== 表达式节点 ====================
 
 class ExprAST : public ASTNode {
 public:
-    ExprAST(int line = -1) : ASTNode(line) {}
+    static bool classof(const ASTNode* node) {
+        return node->getNodeKind() >= ASTKind::FirstExpr && node->getNodeKind() <= ASTKind::LastExpr;
+    }
+    
+    explicit ExprAST(ASTKind kind, int line = -1) : ASTNode(kind, line) {}
     virtual ~ExprAST() = default;
     
     // 判断是否为常量表达式
@@ -68,6 +161,8 @@ public:
 
 class TypeAST : public ASTNode {
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::Type; }
+    
     enum class Kind {
         INT,
         FLOAT,
@@ -81,9 +176,9 @@ private:
     std::unique_ptr<ExprAST> vectorSizeExpr;
     
 public:
-    TypeAST(Kind k) : kind(k), vectorElementKind(Kind::INT) {}
+    TypeAST(Kind k) : ASTNode(ASTKind::Type), kind(k), vectorElementKind(Kind::INT) {}
     TypeAST(Kind elemKind, std::unique_ptr<ExprAST> sizeExpr)
-        : kind(Kind::VECTOR), vectorElementKind(elemKind), vectorSizeExpr(std::move(sizeExpr)) {}
+        : ASTNode(ASTKind::Type), kind(Kind::VECTOR), vectorElementKind(elemKind), vectorSizeExpr(std::move(sizeExpr)) {}
     
     Kind getKind() const { return kind; }
     bool isVector() const { return kind == Kind::VECTOR; }
@@ -139,7 +234,9 @@ class IntConstExprAST : public ExprAST {
     int value;
     
 public:
-    IntConstExprAST(int val, int line = -1) : ExprAST(line), value(val) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::IntConstExpr; }
+    
+    IntConstExprAST(int val, int line = -1) : ExprAST(ASTKind::IntConstExpr, line), value(val) {}
     
     int getValue() const { return value; }
     
@@ -161,7 +258,9 @@ class FloatConstExprAST : public ExprAST {
     float value;
     
 public:
-    FloatConstExprAST(float val, int line = -1) : ExprAST(line), value(val) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::FloatConstExpr; }
+    
+    FloatConstExprAST(float val, int line = -1) : ExprAST(ASTKind::FloatConstExpr, line), value(val) {}
     
     float getValue() const { return value; }
     
@@ -180,22 +279,35 @@ public:
 
 // 左值表达式（变量/数组访问）
 class LValExprAST : public ExprAST {
-    std::string name;
+    Identifier name;
     std::vector<std::unique_ptr<ExprAST>> indices;  // 数组下标
     
 public:
-    LValExprAST(const std::string& n, int line = -1) : ExprAST(line), name(n) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::LValExpr; }
+    
+    LValExprAST(Identifier n, int line = -1) : ExprAST(ASTKind::LValExpr, line), name(n) {}
+    LValExprAST(const std::string& n, int line = -1) : LValExprAST(IdentifierTable::current().get(n), line) {}
     
     void addIndex(std::unique_ptr<ExprAST> idx) {
         indices.push_back(std::move(idx));
     }
     
-    const std::string& getName() const { return name; }
+    // 替换第 i 个下标
+    void setIndex(size_t i, std::unique_ptr<ExprAST> idx) {
+        indices[i] = std::move(idx);
+    }
+    
+    // 重命名（函数内联时避免名字捕获）
+    void setName(const std::string& n) { name = IdentifierTable::current().get(n); }
+    
+    const std::string& getName() const { return name->getName(); }
+    Identifier getIdentifier() const { return name; }
     const std::vector<std::unique_ptr<ExprAST>>& getIndices() const { return indices; }
+    std::vector<std::unique_ptr<ExprAST>>& getMutableIndices() { return indices; }
     
     void print(int indent = 0) const override {
         printIndent(indent);
-        std::cout << "LVal: " << name;
+        std::cout << "LVal: " << name->getName();
         if (!indices.empty()) {
             std::cout << " [" << indices.size() << " dimensions]";
         }
@@ -218,6 +330,8 @@ public:
 // 二元运算表达式
 class BinaryExprAST : public ExprAST {
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::BinaryExpr; }
+    
     enum Operator {
         ADD, SUB, MUL, DIV, MOD,           // 算术运算
         LT, GT, LE, GE,                     // 关系运算
@@ -235,7 +349,7 @@ public:
                   std::unique_ptr<ExprAST> left, 
                   std::unique_ptr<ExprAST> right, 
                   int line = -1)
-        : ExprAST(line), op(oper), lhs(std::move(left)), rhs(std::move(right)) {}
+        : ExprAST(ASTKind::BinaryExpr, line), op(oper), lhs(std::move(left)), rhs(std::move(right)) {}
 
     Operator getOp() const { return op; }
     ExprAST* getLHS() const { return lhs.get(); }
@@ -284,6 +398,8 @@ public:
 // 一元运算表达式
 class UnaryExprAST : public ExprAST {
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::UnaryExpr; }
+    
     enum Operator {
         PLUS,
         MINUS,
@@ -296,7 +412,7 @@ private:
 
 public:
     UnaryExprAST(Operator oper, std::unique_ptr<ExprAST> expr, int line = -1)
-        : ExprAST(line), op(oper), operand(std::move(expr)) {}
+        : ExprAST(ASTKind::UnaryExpr, line), op(oper), operand(std::move(expr)) {}
 
     Operator getOp() const { return op; }
     ExprAST* getOperand() const { return operand.get(); }
@@ -326,22 +442,31 @@ public:
 
 // 函数调用表达式
 class CallExprAST : public ExprAST {
-    std::string callee;
+    Identifier callee;
     std::vector<std::unique_ptr<ExprAST>> args;
     
 public:
-    CallExprAST(const std::string& func, int line = -1) : ExprAST(line), callee(func) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::CallExpr; }
+    
+    CallExprAST(Identifier func, int line = -1) : ExprAST(ASTKind::CallExpr, line), callee(func) {}
+    CallExprAST(const std::string& func, int line = -1) : CallExprAST(IdentifierTable::current().get(func), line) {}
     
     void addArg(std::unique_ptr<ExprAST> arg) {
         args.push_back(std::move(arg));
     }
     
-    const std::string& getCallee() const { return callee; }
+    // 替换第 i 个实参
+    void setArg(size_t i, std::unique_ptr<ExprAST> arg) {
+        args[i] = std::move(arg);
+    }
+    
+    const std::string& getCallee() const { return callee->getName(); }
+    Identifier getCalleeIdentifier() const { return callee; }
     const std::vector<std::unique_ptr<ExprAST>>& getArgs() const { return args; }
     
     void print(int indent = 0) const override {
         printIndent(indent);
-        std::cout << "CallExpr: " << callee << " (" << args.size() << " args)" << std::endl;
+        std::cout << "CallExpr: " << callee->getName() << " (" << args.size() << " args)" << std::endl;
         for (const auto& arg : args) {
             arg->print(indent + 1);
         }
@@ -362,7 +487,9 @@ class StringLiteralExprAST : public ExprAST {
     std::string value;
     
 public:
-    StringLiteralExprAST(const std::string& val, int line = -1) : ExprAST(line), value(val) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::StringLiteralExpr; }
+    
+    StringLiteralExprAST(const std::string& val, int line = -1) : ExprAST(ASTKind::StringLiteralExpr, line), value(val) {}
     
     const std::string& getValue() const { return value; }
     
@@ -380,6 +507,11 @@ public:
 
 class InitValAST : public ASTNode {
 public:
+    static bool classof(const ASTNode* node) {
+        return node->getNodeKind() >= ASTKind::FirstInitVal && node->getNodeKind() <= ASTKind::LastInitVal;
+    }
+    
+    explicit InitValAST(ASTKind kind) : ASTNode(kind) {}
     virtual ~InitValAST() = default;
     virtual std::unique_ptr<ASTNode> clone() const = 0;
 };
@@ -389,7 +521,9 @@ class ExprInitValAST : public InitValAST {
     std::unique_ptr<ExprAST> expr;
     
 public:
-    ExprInitValAST(std::unique_ptr<ExprAST> e) : expr(std::move(e)) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::ExprInitVal; }
+    
+    ExprInitValAST(std::unique_ptr<ExprAST> e) : InitValAST(ASTKind::ExprInitVal), expr(std::move(e)) {}
     
     ExprAST* getExpr() const { return expr.get(); }
     
@@ -415,6 +549,10 @@ class ListInitValAST : public InitValAST {
     std::vector<std::unique_ptr<InitValAST>> initVals;
     
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::ListInitVal; }
+    
+    ListInitValAST() : InitValAST(ASTKind::ListInitVal) {}
+    
     void addInitVal(std::unique_ptr<InitValAST> val) {
         initVals.push_back(std::move(val));
     }
@@ -450,18 +588,26 @@ public:
 
 class DeclAST : public ASTNode {
 public:
+    static bool classof(const ASTNode* node) {
+        return node->getNodeKind() >= ASTKind::FirstDecl && node->getNodeKind() <= ASTKind::LastDecl;
+    }
+    
+    explicit DeclAST(ASTKind kind) : ASTNode(kind) {}
     virtual ~DeclAST() = default;
     virtual std::unique_ptr<ASTNode> clone() const = 0;
 };
 
 // 变量定义
 class VarDefAST : public ASTNode {
-    std::string name;
+    Identifier name;
     std::vector<std::unique_ptr<ExprAST>> arraySizes;  // 数组维度
     std::unique_ptr<InitValAST> initVal;
     
 public:
-    VarDefAST(const std::string& n) : name(n) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::VarDef; }
+    
+    VarDefAST(Identifier n) : ASTNode(ASTKind::VarDef), name(n) {}
+    VarDefAST(const std::string& n) : VarDefAST(IdentifierTable::current().get(n)) {}
     
     void addArraySize(std::unique_ptr<ExprAST> size) {
         arraySizes.push_back(std::move(size));
@@ -471,13 +617,16 @@ public:
         initVal = std::move(val);
     }
     
-    const std::string& getName() const { return name; }
+    void setName(const std::string& n) { name = IdentifierTable::current().get(n); }
+    
+    const std::string& getName() const { return name->getName(); }
+    Identifier getIdentifier() const { return name; }
     const std::vector<std::unique_ptr<ExprAST>>& getArraySizes() const { return arraySizes; }
     InitValAST* getInitVal() const { return initVal.get(); }
     
     void print(int indent = 0) const override {
         printIndent(indent);
-        std::cout << "VarDef: " << name;
+        std::cout << "VarDef: " << name->getName();
         if (!arraySizes.empty()) {
             std::cout << " [array]";
         }
@@ -514,7 +663,9 @@ class VarDeclAST : public DeclAST {
     std::vector<std::unique_ptr<VarDefAST>> varDefs;
     
 public:
-    VarDeclAST(std::unique_ptr<TypeAST> t) : type(std::move(t)) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::VarDecl; }
+    
+    VarDeclAST(std::unique_ptr<TypeAST> t) : DeclAST(ASTKind::VarDecl), type(std::move(t)) {}
     
     void addVarDef(std::unique_ptr<VarDefAST> varDef) {
         varDefs.push_back(std::move(varDef));
@@ -545,12 +696,15 @@ public:
 
 // 常量定义
 class ConstDefAST : public ASTNode {
-    std::string name;
+    Identifier name;
     std::vector<std::unique_ptr<ExprAST>> arraySizes;
     std::unique_ptr<InitValAST> initVal;
     
 public:
-    ConstDefAST(const std::string& n) : name(n) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::ConstDef; }
+    
+    ConstDefAST(Identifier n) : ASTNode(ASTKind::ConstDef), name(n) {}
+    ConstDefAST(const std::string& n) : ConstDefAST(IdentifierTable::current().get(n)) {}
     
     void addArraySize(std::unique_ptr<ExprAST> size) {
         arraySizes.push_back(std::move(size));
@@ -560,13 +714,16 @@ public:
         initVal = std::move(val);
     }
     
-    const std::string& getName() const { return name; }
+    void setName(const std::string& n) { name = IdentifierTable::current().get(n); }
+    
+    const std::string& getName() const { return name->getName(); }
+    Identifier getIdentifier() const { return name; }
     const std::vector<std::unique_ptr<ExprAST>>& getArraySizes() const { return arraySizes; }
     InitValAST* getInitVal() const { return initVal.get(); }
     
     void print(int indent = 0) const override {
         printIndent(indent);
-        std::cout << "ConstDef: " << name << std::endl;
+        std::cout << "ConstDef: " << name->getName() << std::endl;
         for (const auto& size : arraySizes) {
             size->print(indent + 1);
         }
@@ -595,7 +752,9 @@ class ConstDeclAST : public DeclAST {
     std::vector<std::unique_ptr<ConstDefAST>> constDefs;
     
 public:
-    ConstDeclAST(std::unique_ptr<TypeAST> t) : type(std::move(t)) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::ConstDecl; }
+    
+    ConstDeclAST(std::unique_ptr<TypeAST> t) : DeclAST(ASTKind::ConstDecl), type(std::move(t)) {}
     
     void addConstDef(std::unique_ptr<ConstDefAST> constDef) {
         constDefs.push_back(std::move(constDef));
@@ -628,6 +787,11 @@ public:
 
 class StmtAST : public ASTNode {
 public:
+    static bool classof(const ASTNode* node) {
+        return node->getNodeKind() >= ASTKind::FirstStmt && node->getNodeKind() <= ASTKind::LastStmt;
+    }
+    
+    explicit StmtAST(ASTKind kind) : ASTNode(kind) {}
     virtual ~StmtAST() = default;
     virtual std::unique_ptr<ASTNode> clone() const = 0;
 };
@@ -638,8 +802,10 @@ class AssignStmtAST : public StmtAST {
     std::unique_ptr<ExprAST> expr;
     
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::AssignStmt; }
+    
     AssignStmtAST(std::unique_ptr<LValExprAST> lv, std::unique_ptr<ExprAST> e)
-        : lval(std::move(lv)), expr(std::move(e)) {}
+        : StmtAST(ASTKind::AssignStmt), lval(std::move(lv)), expr(std::move(e)) {}
     
     LValExprAST* getLVal() const { return lval.get(); }
     ExprAST* getExpr() const { return expr.get(); }
@@ -668,7 +834,9 @@ class ExprStmtAST : public StmtAST {
     std::unique_ptr<ExprAST> expr;  // 可能为空
     
 public:
-    ExprStmtAST(std::unique_ptr<ExprAST> e = nullptr) : expr(std::move(e)) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::ExprStmt; }
+    
+    ExprStmtAST(std::unique_ptr<ExprAST> e = nullptr) : StmtAST(ASTKind::ExprStmt), expr(std::move(e)) {}
     
     ExprAST* getExpr() const { return expr.get(); }
     
@@ -699,8 +867,10 @@ class ReturnStmtAST : public StmtAST {
     std::unique_ptr<ExprAST> returnValue;  // 可能为空（void函数）
     
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::ReturnStmt; }
+    
     ReturnStmtAST(std::unique_ptr<ExprAST> expr = nullptr) 
-        : returnValue(std::move(expr)) {}
+        : StmtAST(ASTKind::ReturnStmt), returnValue(std::move(expr)) {}
     
     ExprAST* getReturnValue() const { return returnValue.get(); }
     
@@ -733,10 +903,12 @@ class IfStmtAST : public StmtAST {
     std::unique_ptr<StmtAST> elseStmt;  // 可能为空
     
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::IfStmt; }
+    
     IfStmtAST(std::unique_ptr<ExprAST> cond,
               std::unique_ptr<StmtAST> thenS,
               std::unique_ptr<StmtAST> elseS = nullptr)
-        : condition(std::move(cond)), thenStmt(std::move(thenS)), elseStmt(std::move(elseS)) {}
+        : StmtAST(ASTKind::IfStmt), condition(std::move(cond)), thenStmt(std::move(thenS)), elseStmt(std::move(elseS)) {}
     
     ExprAST* getCondition() const { return condition.get(); }
     StmtAST* getThenStmt() const { return thenStmt.get(); }
@@ -788,10 +960,13 @@ public:
 class WhileStmtAST : public StmtAST {
     std::unique_ptr<ExprAST> condition;
     std::unique_ptr<StmtAST> body;
+    bool noUnroll = false;  // 展开产生的循环不再展开
     
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::WhileStmt; }
+    
     WhileStmtAST(std::unique_ptr<ExprAST> cond, std::unique_ptr<StmtAST> b)
-        : condition(std::move(cond)), body(std::move(b)) {}
+        : StmtAST(ASTKind::WhileStmt), condition(std::move(cond)), body(std::move(b)) {}
     
     ExprAST* getCondition() const { return condition.get(); }
     StmtAST* getBody() const { return body.get(); }
@@ -806,6 +981,9 @@ public:
         body = std::move(newBody);
     }
     
+    void setNoUnroll(bool value) { noUnroll = value; }
+    bool isNoUnroll() const { return noUnroll; }
+    
     void print(int indent = 0) const override {
         printIndent(indent);
         std::cout << "WhileStmt:" << std::endl;
@@ -820,13 +998,19 @@ public:
     std::unique_ptr<ASTNode> clone() const override {
         auto condClone = std::unique_ptr<ExprAST>(static_cast<ExprAST*>(condition->clone().release()));
         auto bodyClone = std::unique_ptr<StmtAST>(static_cast<StmtAST*>(body->clone().release()));
-        return std::make_unique<WhileStmtAST>(std::move(condClone), std::move(bodyClone));
+        auto clone = std::make_unique<WhileStmtAST>(std::move(condClone), std::move(bodyClone));
+        clone->setNoUnroll(noUnroll);
+        return clone;
     }
 };
 
 // Break 语句
 class BreakStmtAST : public StmtAST {
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::BreakStmt; }
+    
+    BreakStmtAST() : StmtAST(ASTKind::BreakStmt) {}
+    
     void print(int indent = 0) const override {
         printIndent(indent);
         std::cout << "BreakStmt" << std::endl;
@@ -840,6 +1024,10 @@ public:
 // Continue 语句
 class ContinueStmtAST : public StmtAST {
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::ContinueStmt; }
+    
+    ContinueStmtAST() : StmtAST(ASTKind::ContinueStmt) {}
+    
     void print(int indent = 0) const override {
         printIndent(indent);
         std::cout << "ContinueStmt" << std::endl;
@@ -854,6 +1042,11 @@ public:
 
 class BlockItemAST : public ASTNode {
 public:
+    static bool classof(const ASTNode* node) {
+        return node->getNodeKind() >= ASTKind::FirstBlockItem && node->getNodeKind() <= ASTKind::LastBlockItem;
+    }
+    
+    explicit BlockItemAST(ASTKind kind) : ASTNode(kind) {}
     virtual ~BlockItemAST() = default;
     virtual std::unique_ptr<ASTNode> clone() const = 0;
 };
@@ -863,7 +1056,9 @@ class DeclBlockItemAST : public BlockItemAST {
     std::unique_ptr<DeclAST> decl;
     
 public:
-    DeclBlockItemAST(std::unique_ptr<DeclAST> d) : decl(std::move(d)) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::DeclBlockItem; }
+    
+    DeclBlockItemAST(std::unique_ptr<DeclAST> d) : BlockItemAST(ASTKind::DeclBlockItem), decl(std::move(d)) {}
     
     DeclAST* getDecl() const { return decl.get(); }
     
@@ -882,7 +1077,9 @@ class StmtBlockItemAST : public BlockItemAST {
     std::unique_ptr<StmtAST> stmt;
     
 public:
-    StmtBlockItemAST(std::unique_ptr<StmtAST> s) : stmt(std::move(s)) {}
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::StmtBlockItem; }
+    
+    StmtBlockItemAST(std::unique_ptr<StmtAST> s) : BlockItemAST(ASTKind::StmtBlockItem), stmt(std::move(s)) {}
     
     StmtAST* getStmt() const { return stmt.get(); }
     
@@ -901,7 +1098,9 @@ class BlockAST : public StmtAST {
     std::vector<std::unique_ptr<BlockItemAST>> items;
     
 public:
-    BlockAST() = default;
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::Block; }
+    
+    BlockAST() : StmtAST(ASTKind::Block) {}
     
     void addItem(std::unique_ptr<BlockItemAST> item) {
         items.push_back(std::move(item));
@@ -911,6 +1110,10 @@ public:
         return items;
     }
     
+    std::vector<std::unique_ptr<BlockItemAST>>& getMutableItems() {
+        return items;
+    }
+    
     void print(int indent = 0) const override {
         printIndent(indent);
         std::cout << "Block: (" << items.size() << " items)" << std::endl;
@@ -933,26 +1136,31 @@ public:
 
 class FuncFParamAST : public ASTNode {
     std::unique_ptr<TypeAST> type;
-    std::string name;
+    Identifier name;
     bool isArray;
     std::vector<std::unique_ptr<ExprAST>> arraySizes;  // 第一维为空，后续维度有大小
     
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::FuncFParam; }
+    
+    FuncFParamAST(std::unique_ptr<TypeAST> t, Identifier n, bool arr = false)
+        : ASTNode(ASTKind::FuncFParam), type(std::move(t)), name(n), isArray(arr) {}
     FuncFParamAST(std::unique_ptr<TypeAST> t, const std::string& n, bool arr = false)
-        : type(std::move(t)), name(n), isArray(arr) {}
+        : FuncFParamAST(std::move(t), IdentifierTable::current().get(n), arr) {}
     
     void addArraySize(std::unique_ptr<ExprAST> size) {
         arraySizes.push_back(std::move(size));
     }
     
     TypeAST* getType() const { return type.get(); }
-    const std::string& getName() const { return name; }
+    const std::string& getName() const { return name->getName(); }
+    Identifier getIdentifier() const { return name; }
     bool getIsArray() const { return isArray; }
     const std::vector<std::unique_ptr<ExprAST>>& getArraySizes() const { return arraySizes; }
     
     void print(int indent = 0) const override {
         printIndent(indent);
-        std::cout << "FuncFParam: " << name;
+        std::cout << "FuncFParam: " << name->getName();
         if (isArray) {
             std::cout << " [array]";
         }
@@ -978,30 +1186,38 @@ public:
 
 class FunctionAST : public ASTNode {
     std::unique_ptr<TypeAST> returnType;
-    std::string name;
+    Identifier name;
     std::vector<std::unique_ptr<FuncFParamAST>> params;
     std::unique_ptr<BlockAST> body;
     
 public:
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::Function; }
+    
     FunctionAST(std::unique_ptr<TypeAST> retType, 
-                const std::string& funcName,
+                Identifier funcName,
                 std::unique_ptr<BlockAST> funcBody)
-        : returnType(std::move(retType)),
+        : ASTNode(ASTKind::Function),
+          returnType(std::move(retType)),
           name(funcName),
           body(std::move(funcBody)) {}
+    FunctionAST(std::unique_ptr<TypeAST> retType, 
+                const std::string& funcName,
+                std::unique_ptr<BlockAST> funcBody)
+        : FunctionAST(std::move(retType), IdentifierTable::current().get(funcName), std::move(funcBody)) {}
     
     void addParam(std::unique_ptr<FuncFParamAST> param) {
         params.push_back(std::move(param));
     }
     
-    const std::string& getName() const { return name; }
+    const std::string& getName() const { return name->getName(); }
+    Identifier getIdentifier() const { return name; }
     TypeAST* getReturnType() const { return returnType.get(); }
     const std::vector<std::unique_ptr<FuncFParamAST>>& getParams() const { return params; }
     BlockAST* getBody() const { return body.get(); }
     
     void print(int indent = 0) const override {
         printIndent(indent);
-        std::cout << "Function: " << name << " (" << params.size() << " params)" << std::endl;
+        std::cout << "Function: " << name->getName() << " (" << params.size() << " params)" << std::endl;
         
         printIndent(indent + 1);
         std::cout << "ReturnType:" << std::endl;
@@ -1039,7 +1255,9 @@ class CompUnitAST : public ASTNode {
     std::vector<std::unique_ptr<FunctionAST>> functions;
     
 public:
-    CompUnitAST() = default;
+    static bool classof(const ASTNode* node) { return node->getNodeKind() == ASTKind::CompUnit; }
+    
+    CompUnitAST() : ASTNode(ASTKind::CompUnit) {}
     
     void addDecl(std::unique_ptr<DeclAST> decl) {
         decls.push_back(std::move(decl));
@@ -1051,6 +1269,7 @@ public:
     
     const std::vector<std::unique_ptr<DeclAST>>& getDecls() const { return decls; }
     const std::vector<std::unique_ptr<FunctionAST>>& getFunctions() const { return functions; }
+    std::vector<std::unique_ptr<FunctionAST>>& getMutableFunctions() { return functions; }
     
     void print(int indent = 0) const override {
         printIndent(indent);
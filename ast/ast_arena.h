@@ -0,0 +1,104 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// AST 节点的 bump-pointer 内存池。
+//
+// 一次编译创建一个 ASTArena 并用 ASTArena::Scope 设为当前线程的 arena，
+// 此后所有 AST 节点（ASTBuilder 的 new、优化时的 make_unique 与 clone）都从它分配；
+// 节点仍由 unique_ptr 持有，delete 时只运行析构函数，内存随 arena 整块释放。
+// 没有当前 arena 时节点照常从全局堆分配。
+class ASTArena {
+private:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    // 每个节点前的头部，记录节点所属的 arena（全局堆分配时为空），保持 16 字节对齐
+    static constexpr size_t NODE_HEADER = 16;
+
+    std::vector<char*> chunks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t bytesAllocated = 0;
+    size_t nodeCount = 0;
+
+    static ASTArena*& currentSlot() {
+        static thread_local ASTArena* current = nullptr;
+        return current;
+    }
+
+public:
+    ASTArena() = default;
+    ~ASTArena() {
+        for (char* chunk : chunks) {
+            ::operator delete(chunk);
+        }
+    }
+
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+
+    // 分配 size 字节（按 16 字节对齐）；放不下时开新块，超大请求单独占一块
+    void* allocate(size_t size) {
+        size = (size + NODE_HEADER - 1) & ~(NODE_HEADER - 1);
+        if (size > static_cast<size_t>(limit - cursor)) {
+            size_t chunkSize = std::max(CHUNK_SIZE, size);
+            cursor = static_cast<char*>(::operator new(chunkSize));
+            limit = cursor + chunkSize;
+            chunks.push_back(cursor);
+        }
+        void* result = cursor;
+        cursor += size;
+        bytesAllocated += size;
+        return result;
+    }
+
+    size_t getBytesAllocated() const { return bytesAllocated; }
+    size_t getNodeCount() const { return nodeCount; }
+    size_t getChunkCount() const { return chunks.size(); }
+
+    // 当前线程正在使用的 arena（可能为空）
+    static ASTArena* current() { return currentSlot(); }
+
+    // 在作用域内把 arena 设为当前线程的 arena，退出时恢复之前的设置
+    class Scope {
+    private:
+        ASTArena* previous;
+
+    public:
+        explicit Scope(ASTArena* arena) : previous(currentSlot()) { currentSlot() = arena; }
+        ~Scope() { currentSlot() = previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // 供 ASTNode::operator new/delete 使用
+    static void* allocateNode(size_t size) {
+        ASTArena* arena = current();
+        char* base;
+        if (arena) {
+            base = static_cast<char*>(arena->allocate(size + NODE_HEADER));
+            arena->nodeCount++;
+        } else {
+            base = static_cast<char*>(::operator new(size + NODE_HEADER));
+        }
+        *reinterpret_cast<ASTArena**>(base) = arena;
+        return base + NODE_HEADER;
+    }
+
+    static void deallocateNode(void* ptr) {
+        if (!ptr) {
+            return;
+        }
+        char* base = static_cast<char*>(ptr) - NODE_HEADER;
+        // arena 中的节点不单独释放
+        if (!*reinterpret_cast<ASTArena**>(base)) {
+            ::operator delete(base);
+        }
+    }
+};
+
+#endif // AST_ARENA_H
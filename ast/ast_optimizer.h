@@ -3,28 +3,50 @@
 
 #include "ast.h"
 #include "constant_folding.h"
+#include "function_inlining.h"
 
 #include "loop_optimization.h"
+#include "../support/time_report.h"
 
 class ASTOptimizer {
 private:
     ConstantFolder constantFolder;
     
+    FunctionInliner functionInliner;
+    
     LoopOptimizer loopOptimizer;
     
     bool verbose;
     int passCount;  // 优化轮数
+    TimeReport* timeReport = nullptr;  // 非空时记录每个 pass 的耗时
     
 public:
     ASTOptimizer(bool verbose = false) 
         : verbose(verbose), passCount(0) {}
     
+    // 设置内联预算（0 关闭函数内联）
+    void setInlineBudget(int budget) { functionInliner.setBudget(budget); }
+    
+    // 设置循环部分展开因子（0 关闭循环展开，1 只做完全展开）
+    void setUnrollFactor(int factor) { loopOptimizer.setUnrollFactor(factor); }
+    
+    // 记录各 pass 耗时（多轮中同名 pass 累加）
+    void setTimeReport(TimeReport* report) { timeReport = report; }
+    
     // 执行所有优化
     void optimize(CompUnitAST* ast) {
         if (verbose) {
             std::cout << "Starting AST optimization..." << std::endl;
         }
         
+        // 函数内联只做一次，展开后的代码再参与后续各轮优化
+        TimeReport::Scope inlineTimer(timeReport, "ast-pass", "inline");
+        bool inlined = functionInliner.inlineCalls(ast);
+        inlineTimer.stop();
+        if (inlined && verbose) {
+            std::cout << "Inlined " << functionInliner.getInlinedCount() << " call sites" << std::endl;
+        }
+        
         // 多轮优化直到不再变化
         bool changed = true;
         while (changed && passCount < 8) {  // 最多8轮
@@ -36,11 +58,16 @@ public:
             }
             
             // 1. 常量折叠
-            changed |= constantFolder.fold(ast);
+            {
+                TimeReport::Scope timer(timeReport, "ast-pass", "constant-fold");
+                changed |= constantFolder.fold(ast);
+            }
             
-           
-            // 2. 循环优化
-            // changed |= loopOptimizer.optimize(ast);
+            // 2. 循环不变量外提与循环展开
+            {
+                TimeReport::Scope timer(timeReport, "ast-pass", "loop-optimize");
+                changed |= loopOptimizer.optimize(ast);
+            }
             
           
         }
@@ -0,0 +1,134 @@
+#ifndef AST_VISITOR_H
+#define AST_VISITOR_H
+
+#include "ast.h"
+
+// 基于 CRTP 的 AST 访问器：visit() 按 getNodeKind() 用 switch 分发到派生类的 visitXxx，
+// 调用在编译期确定，没有虚函数和 dynamic_cast 的开销。
+//
+// 派生类只需实现关心的 visitXxx；未实现的具体节点依次退回到所属类别
+// （visitExpr / visitInitVal / visitDecl / visitStmt / visitBlockItem），最后到 visitNode，
+// 默认返回 RetTy()。遍历子节点由派生类在 visitXxx 中自行调用 visit() 完成。
+//
+//   class Counter : public ASTVisitor<Counter, int> {
+//   public:
+//       int visitCallExpr(CallExprAST* call) { ... }
+//   };
+template <typename Derived, typename RetTy = void>
+class ASTVisitor {
+public:
+    // 空节点直接返回 RetTy()
+    RetTy visit(ASTNode* node) {
+        if (!node) {
+            return RetTy();
+        }
+        switch (node->getNodeKind()) {
+            case ASTKind::IntConstExpr:
+                return derived().visitIntConstExpr(static_cast<IntConstExprAST*>(node));
+            case ASTKind::FloatConstExpr:
+                return derived().visitFloatConstExpr(static_cast<FloatConstExprAST*>(node));
+            case ASTKind::LValExpr:
+                return derived().visitLValExpr(static_cast<LValExprAST*>(node));
+            case ASTKind::BinaryExpr:
+                return derived().visitBinaryExpr(static_cast<BinaryExprAST*>(node));
+            case ASTKind::UnaryExpr:
+                return derived().visitUnaryExpr(static_cast<UnaryExprAST*>(node));
+            case ASTKind::CallExpr:
+                return derived().visitCallExpr(static_cast<CallExprAST*>(node));
+            case ASTKind::StringLiteralExpr:
+                return derived().visitStringLiteralExpr(static_cast<StringLiteralExprAST*>(node));
+            case ASTKind::Type:
+                return derived().visitType(static_cast<TypeAST*>(node));
+            case ASTKind::ExprInitVal:
+                return derived().visitExprInitVal(static_cast<ExprInitValAST*>(node));
+            case ASTKind::ListInitVal:
+                return derived().visitListInitVal(static_cast<ListInitValAST*>(node));
+            case ASTKind::VarDecl:
+                return derived().visitVarDecl(static_cast<VarDeclAST*>(node));
+            case ASTKind::ConstDecl:
+                return derived().visitConstDecl(static_cast<ConstDeclAST*>(node));
+            case ASTKind::VarDef:
+                return derived().visitVarDef(static_cast<VarDefAST*>(node));
+            case ASTKind::ConstDef:
+                return derived().visitConstDef(static_cast<ConstDefAST*>(node));
+            case ASTKind::AssignStmt:
+                return derived().visitAssignStmt(static_cast<AssignStmtAST*>(node));
+            case ASTKind::ExprStmt:
+                return derived().visitExprStmt(static_cast<ExprStmtAST*>(node));
+            case ASTKind::ReturnStmt:
+                return derived().visitReturnStmt(static_cast<ReturnStmtAST*>(node));
+            case ASTKind::IfStmt:
+                return derived().visitIfStmt(static_cast<IfStmtAST*>(node));
+            case ASTKind::WhileStmt:
+                return derived().visitWhileStmt(static_cast<WhileStmtAST*>(node));
+            case ASTKind::BreakStmt:
+                return derived().visitBreakStmt(static_cast<BreakStmtAST*>(node));
+            case ASTKind::ContinueStmt:
+                return derived().visitContinueStmt(static_cast<ContinueStmtAST*>(node));
+            case ASTKind::Block:
+                return derived().visitBlock(static_cast<BlockAST*>(node));
+            case ASTKind::DeclBlockItem:
+                return derived().visitDeclBlockItem(static_cast<DeclBlockItemAST*>(node));
+            case ASTKind::StmtBlockItem:
+                return derived().visitStmtBlockItem(static_cast<StmtBlockItemAST*>(node));
+            case ASTKind::FuncFParam:
+                return derived().visitFuncFParam(static_cast<FuncFParamAST*>(node));
+            case ASTKind::Function:
+                return derived().visitFunction(static_cast<FunctionAST*>(node));
+            case ASTKind::CompUnit:
+                return derived().visitCompUnit(static_cast<CompUnitAST*>(node));
+        }
+        assert(false && "Unknown AST node kind");
+        return RetTy();
+    }
+
+    // ---------- 具体节点的默认实现：退回到所属类别 ----------
+
+    RetTy visitIntConstExpr(IntConstExprAST* expr) { return derived().visitExpr(expr); }
+    RetTy visitFloatConstExpr(FloatConstExprAST* expr) { return derived().visitExpr(expr); }
+    RetTy visitLValExpr(LValExprAST* expr) { return derived().visitExpr(expr); }
+    RetTy visitBinaryExpr(BinaryExprAST* expr) { return derived().visitExpr(expr); }
+    RetTy visitUnaryExpr(UnaryExprAST* expr) { return derived().visitExpr(expr); }
+    RetTy visitCallExpr(CallExprAST* expr) { return derived().visitExpr(expr); }
+    RetTy visitStringLiteralExpr(StringLiteralExprAST* expr) { return derived().visitExpr(expr); }
+
+    RetTy visitExprInitVal(ExprInitValAST* initVal) { return derived().visitInitVal(initVal); }
+    RetTy visitListInitVal(ListInitValAST* initVal) { return derived().visitInitVal(initVal); }
+
+    RetTy visitVarDecl(VarDeclAST* decl) { return derived().visitDecl(decl); }
+    RetTy visitConstDecl(ConstDeclAST* decl) { return derived().visitDecl(decl); }
+
+    RetTy visitAssignStmt(AssignStmtAST* stmt) { return derived().visitStmt(stmt); }
+    RetTy visitExprStmt(ExprStmtAST* stmt) { return derived().visitStmt(stmt); }
+    RetTy visitReturnStmt(ReturnStmtAST* stmt) { return derived().visitStmt(stmt); }
+    RetTy visitIfStmt(IfStmtAST* stmt) { return derived().visitStmt(stmt); }
+    RetTy visitWhileStmt(WhileStmtAST* stmt) { return derived().visitStmt(stmt); }
+    RetTy visitBreakStmt(BreakStmtAST* stmt) { return derived().visitStmt(stmt); }
+    RetTy visitContinueStmt(ContinueStmtAST* stmt) { return derived().visitStmt(stmt); }
+    RetTy visitBlock(BlockAST* stmt) { return derived().visitStmt(stmt); }
+
+    RetTy visitDeclBlockItem(DeclBlockItemAST* item) { return derived().visitBlockItem(item); }
+    RetTy visitStmtBlockItem(StmtBlockItemAST* item) { return derived().visitBlockItem(item); }
+
+    RetTy visitType(TypeAST* type) { return derived().visitNode(type); }
+    RetTy visitVarDef(VarDefAST* def) { return derived().visitNode(def); }
+    RetTy visitConstDef(ConstDefAST* def) { return derived().visitNode(def); }
+    RetTy visitFuncFParam(FuncFParamAST* param) { return derived().visitNode(param); }
+    RetTy visitFunction(FunctionAST* func) { return derived().visitNode(func); }
+    RetTy visitCompUnit(CompUnitAST* unit) { return derived().visitNode(unit); }
+
+    // ---------- 类别的默认实现 ----------
+
+    RetTy visitExpr(ExprAST* expr) { return derived().visitNode(expr); }
+    RetTy visitInitVal(InitValAST* initVal) { return derived().visitNode(initVal); }
+    RetTy visitDecl(DeclAST* decl) { return derived().visitNode(decl); }
+    RetTy visitStmt(StmtAST* stmt) { return derived().visitNode(stmt); }
+    RetTy visitBlockItem(BlockItemAST* item) { return derived().visitNode(item); }
+
+    RetTy visitNode(ASTNode*) { return RetTy(); }
+
+private:
+    Derived& derived() { return *static_cast<Derived*>(this); }
+};
+
+#endif // AST_VISITOR_H
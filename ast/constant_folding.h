@@ -2,17 +2,19 @@
 #define CONSTANT_FOLDING_H
 
 #include "ast.h"
+#include "ast_visitor.h"
+
+// 语句经 ASTVisitor 按节点类型分发，各 visitXxx 返回是否发生了改写
+class ConstantFolder : public ASTVisitor<ConstantFolder, bool> {
+    friend class ASTVisitor<ConstantFolder, bool>;
 
-class ConstantFolder {
 public:
     bool fold(CompUnitAST* ast) {
         bool changed = false;
         
         // 处理全局声明
         for (auto& decl : ast->getDecls()) {
-            if (auto declItem = dynamic_cast<DeclAST*>(decl.get())) {
-                changed |= foldDecl(declItem);
-            }
+            changed |= foldDecl(decl.get());
         }
         
         // 遍历所有函数
@@ -25,260 +27,265 @@ public:
     
 private:
     bool foldFunction(FunctionAST* func) {
-        return foldBlock(func->getBody());
+        return visit(func->getBody());
     }
     
-    bool foldBlock(BlockAST* block) {
+    bool foldDecl(DeclAST* decl) {
         bool changed = false;
         
-        for (auto& item : block->getItems()) {
-            if (auto stmtItem = dynamic_cast<StmtBlockItemAST*>(item.get())) {
-                changed |= foldStmt(stmtItem->getStmt());
-            }
-            else if (auto declItem = dynamic_cast<DeclBlockItemAST*>(item.get())) {
-                changed |= foldDecl(declItem->getDecl());
-            }
+        switch (decl->getNodeKind()) {
+            // 处理变量声明
+            case ASTKind::VarDecl:
+                for (auto& varDef : cast<VarDeclAST>(decl)->getVarDefs()) {
+                    if (varDef->getInitVal()) {
+                        changed |= foldInitVal(varDef->getInitVal());
+                    }
+                }
+                break;
+            // 处理常量声明
+            case ASTKind::ConstDecl:
+                for (auto& constDef : cast<ConstDeclAST>(decl)->getConstDefs()) {
+                    if (constDef->getInitVal()) {
+                        changed |= foldInitVal(constDef->getInitVal());
+                    }
+                }
+                break;
+            default:
+                break;
         }
         
         return changed;
     }
     
-    bool foldDecl(DeclAST* decl) {
+    bool foldInitVal(InitValAST* initVal) {
         bool changed = false;
         
-        // 处理变量声明
-        if (auto varDecl = dynamic_cast<VarDeclAST*>(decl)) {
-            for (auto& varDef : varDecl->getVarDefs()) {
-                if (varDef->getInitVal()) {
-                    changed |= foldInitVal(varDef->getInitVal());
+        switch (initVal->getNodeKind()) {
+            // 处理表达式初始化值
+            case ASTKind::ExprInitVal: {
+                auto exprInit = cast<ExprInitValAST>(initVal);
+                if (auto folded = foldExpr(exprInit->getExpr(), changed)) {
+                    exprInit->setExpr(std::move(folded));
+                    changed = true;
                 }
+                break;
             }
-        }
-        // 处理常量声明
-        else if (auto constDecl = dynamic_cast<ConstDeclAST*>(decl)) {
-            for (auto& constDef : constDecl->getConstDefs()) {
-                if (constDef->getInitVal()) {
-                    changed |= foldInitVal(constDef->getInitVal());
+            // 处理列表初始化值（数组）
+            case ASTKind::ListInitVal: {
+                // 获取可修改的初始化值列表
+                auto& initVals = cast<ListInitValAST>(initVal)->getMutableInitVals();
+                
+                // 遍历并折叠每个初始化值
+                for (size_t i = 0; i < initVals.size(); ++i) {
+                    if (foldInitVal(initVals[i].get())) {
+                        changed = true;
+                    }
                 }
+                break;
             }
+            default:
+                break;
         }
         
         return changed;
     }
     
-    bool foldInitVal(InitValAST* initVal) {
+    // ---------- 语句（由 visit() 分发） ----------
+    
+    bool visitBlock(BlockAST* block) {
         bool changed = false;
         
-        // 处理表达式初始化值
-        if (auto exprInit = dynamic_cast<ExprInitValAST*>(initVal)) {
-            auto foldedExpr = foldAndReplaceExpr(exprInit->getExpr());
-            if (foldedExpr.get() != exprInit->getExpr()) {
-                exprInit->setExpr(std::move(foldedExpr));
-                changed = true;
-            }
-        }
-        // 处理列表初始化值（数组）
-        else if (auto listInit = dynamic_cast<ListInitValAST*>(initVal)) {
-            // 获取可修改的初始化值列表
-            auto& initVals = listInit->getMutableInitVals();
-            
-            // 遍历并折叠每个初始化值
-            for (size_t i = 0; i < initVals.size(); ++i) {
-                if (foldInitVal(initVals[i].get())) {
-                    changed = true;
-                }
-            }
+        for (auto& item : block->getItems()) {
+            changed |= visit(item.get());
         }
         
         return changed;
     }
     
-    bool foldStmt(StmtAST* stmt) {
+    bool visitStmtBlockItem(StmtBlockItemAST* item) {
+        return visit(item->getStmt());
+    }
+    
+    bool visitDeclBlockItem(DeclBlockItemAST* item) {
+        return foldDecl(item->getDecl());
+    }
+    
+    bool visitAssignStmt(AssignStmtAST* assignStmt) {
         bool changed = false;
         
-        // 递归处理不同类型的语句
-        if (auto assignStmt = dynamic_cast<AssignStmtAST*>(stmt)) {
-            // 折叠赋值语句的表达式
-            auto foldedExpr = foldAndReplaceExpr(assignStmt->getExpr());
-            if (foldedExpr.get() != assignStmt->getExpr()) {
-                // 替换为折叠后的表达式
-                assignStmt->setExpr(std::move(foldedExpr));
-                changed = true;
-            }
-        }
-        else if (auto ifStmt = dynamic_cast<IfStmtAST*>(stmt)) {
-            // 折叠条件表达式
-            auto foldedCond = foldAndReplaceExpr(ifStmt->getCondition());
-            if (foldedCond.get() != ifStmt->getCondition()) {
-                ifStmt->setCondition(std::move(foldedCond));
-                changed = true;
-            }
-            
-            // 递归折叠分支语句
-            changed |= foldStmt(ifStmt->getThenStmt());
-            if (ifStmt->getElseStmt()) {
-                changed |= foldStmt(ifStmt->getElseStmt());
-            }
-            
-            // 如果条件是常量，可以直接简化
-            if (auto constCond = dynamic_cast<IntConstExprAST*>(ifStmt->getCondition())) {
-                
-                changed = true;
-            }
-        }
-        else if (auto whileStmt = dynamic_cast<WhileStmtAST*>(stmt)) {
-            // 折叠条件表达式
-            auto foldedCond = foldAndReplaceExpr(whileStmt->getCondition());
-            if (foldedCond.get() != whileStmt->getCondition()) {
-                whileStmt->setCondition(std::move(foldedCond));
-                changed = true;
-            }
-            
-            // 递归折叠循环体
-            changed |= foldStmt(whileStmt->getBody());
-        }
-        else if (auto block = dynamic_cast<BlockAST*>(stmt)) {
-            changed |= foldBlock(block);
-        }
-        else if (auto exprStmt = dynamic_cast<ExprStmtAST*>(stmt)) {
-            if (exprStmt->getExpr()) {
-                auto foldedExpr = foldAndReplaceExpr(exprStmt->getExpr());
-                if (foldedExpr.get() != exprStmt->getExpr()) {
-                    exprStmt->setExpr(std::move(foldedExpr));
-                    changed = true;
-                }
-            }
+        // 折叠左值下标（左值本身不会被替换）
+        foldExpr(assignStmt->getLVal(), changed);
+        
+        // 折叠赋值语句的表达式
+        if (auto folded = foldExpr(assignStmt->getExpr(), changed)) {
+            assignStmt->setExpr(std::move(folded));
+            changed = true;
         }
-        else if (auto returnStmt = dynamic_cast<ReturnStmtAST*>(stmt)) {
-            if (returnStmt->getReturnValue()) {
-                auto foldedExpr = foldAndReplaceExpr(returnStmt->getReturnValue());
-                if (foldedExpr.get() != returnStmt->getReturnValue()) {
-                    returnStmt->setReturnValue(std::move(foldedExpr));
-                    changed = true;
-                }
-            }
+        return changed;
+    }
+    
+    bool visitIfStmt(IfStmtAST* ifStmt) {
+        bool changed = false;
+        
+        // 折叠条件表达式
+        if (auto folded = foldExpr(ifStmt->getCondition(), changed)) {
+            ifStmt->setCondition(std::move(folded));
+            changed = true;
         }
         
+        // 递归折叠分支语句（else 分支为空时 visit 返回 false）
+        changed |= visit(ifStmt->getThenStmt());
+        changed |= visit(ifStmt->getElseStmt());
         return changed;
     }
     
-    // 核心：折叠表达式
-    // 返回是否发生了折叠
-    bool foldExpr(ExprAST* expr) {
-        if (!expr) {
-            return false;
+    bool visitWhileStmt(WhileStmtAST* whileStmt) {
+        bool changed = false;
+        
+        // 折叠条件表达式
+        if (auto folded = foldExpr(whileStmt->getCondition(), changed)) {
+            whileStmt->setCondition(std::move(folded));
+            changed = true;
         }
         
+        // 递归折叠循环体
+        changed |= visit(whileStmt->getBody());
+        return changed;
+    }
+    
+    bool visitExprStmt(ExprStmtAST* exprStmt) {
         bool changed = false;
-        
+        if (exprStmt->getExpr()) {
+            if (auto folded = foldExpr(exprStmt->getExpr(), changed)) {
+                exprStmt->setExpr(std::move(folded));
+                changed = true;
+            }
+        }
         return changed;
     }
     
-    // 折叠表达式并返回折叠后的新表达式
-    std::unique_ptr<ExprAST> foldAndReplaceExpr(ExprAST* expr) {
-        if (!expr) {
-            return nullptr;
+    bool visitReturnStmt(ReturnStmtAST* returnStmt) {
+        bool changed = false;
+        if (returnStmt->getReturnValue()) {
+            if (auto folded = foldExpr(returnStmt->getReturnValue(), changed)) {
+                returnStmt->setReturnValue(std::move(folded));
+                changed = true;
+            }
         }
-        
-        // 如果已经是常量表达式，直接返回克隆
-        if (expr->isConstant()) {
-            return std::unique_ptr<ExprAST>(static_cast<ExprAST*>(expr->clone().release()));
+        return changed;
+    }
+    
+    // 核心：就地折叠表达式
+    // 子表达式直接在原节点上替换；只有 expr 自身能折叠为常量时才分配新节点并返回，
+    // 由调用方替换到父节点中，否则返回 nullptr。发生任何改写时置 changed 为 true
+    std::unique_ptr<ExprAST> foldExpr(ExprAST* expr, bool& changed) {
+        if (!expr || expr->isConstant()) {
+            return nullptr;
         }
         
-        // 先处理二元表达式
-        if (auto binExpr = dynamic_cast<BinaryExprAST*>(expr)) {
-            // 递归折叠子表达式
-            auto lhs = foldAndReplaceExpr(binExpr->getLHS());
-            auto rhs = foldAndReplaceExpr(binExpr->getRHS());
+        switch (expr->getNodeKind()) {
+            // 处理二元表达式
+            case ASTKind::BinaryExpr: {
+                auto binExpr = cast<BinaryExprAST>(expr);
+                // 递归折叠子表达式
+                if (auto lhs = foldExpr(binExpr->getLHS(), changed)) {
+                    binExpr->setLHS(std::move(lhs));
+                    changed = true;
+                }
+                if (auto rhs = foldExpr(binExpr->getRHS(), changed)) {
+                    binExpr->setRHS(std::move(rhs));
+                    changed = true;
+                }
             
-            // 检查折叠后的子表达式是否都是整数常量
-            auto lhsIntConst = dynamic_cast<IntConstExprAST*>(lhs.get());
-            auto rhsIntConst = dynamic_cast<IntConstExprAST*>(rhs.get());
+                // 检查子表达式是否都是整数常量
+                auto lhsIntConst = dyn_cast<IntConstExprAST>(binExpr->getLHS());
+                auto rhsIntConst = dyn_cast<IntConstExprAST>(binExpr->getRHS());
             
-            // 检查折叠后的子表达式是否都是浮点数常量
-            auto lhsFloatConst = dynamic_cast<FloatConstExprAST*>(lhs.get());
-            auto rhsFloatConst = dynamic_cast<FloatConstExprAST*>(rhs.get());
+                // 检查子表达式是否都是浮点数常量
+                auto lhsFloatConst = dyn_cast<FloatConstExprAST>(binExpr->getLHS());
+                auto rhsFloatConst = dyn_cast<FloatConstExprAST>(binExpr->getRHS());
             
-            if (lhsIntConst && rhsIntConst) {
-                // 计算整数常量结果
-                int result = evaluateBinaryOp(
-                    binExpr->getOp(), 
-                    lhsIntConst->getValue(), 
-                    rhsIntConst->getValue()
-                );
+                if (lhsIntConst && rhsIntConst) {
+                    // 计算整数常量结果
+                    int result = evaluateBinaryOp(
+                        binExpr->getOp(), 
+                        lhsIntConst->getValue(), 
+                        rhsIntConst->getValue()
+                    );
                 
-                // 返回整数常量表达式
-                return std::make_unique<IntConstExprAST>(result, binExpr->getLineNumber());
-            }
-            else if (lhsFloatConst && rhsFloatConst) {
-                // 计算浮点数常量结果
-                float result = evaluateBinaryOp(
-                    binExpr->getOp(), 
-                    lhsFloatConst->getValue(), 
-                    rhsFloatConst->getValue()
-                );
+                    // 返回整数常量表达式
+                    return std::make_unique<IntConstExprAST>(result, binExpr->getLineNumber());
+                }
+                else if (lhsFloatConst && rhsFloatConst) {
+                    // 计算浮点数常量结果
+                    float result = evaluateBinaryOp(
+                        binExpr->getOp(), 
+                        lhsFloatConst->getValue(), 
+                        rhsFloatConst->getValue()
+                    );
                 
-                // 返回浮点数常量表达式
-                return std::make_unique<FloatConstExprAST>(result, binExpr->getLineNumber());
+                    // 返回浮点数常量表达式
+                    return std::make_unique<FloatConstExprAST>(result, binExpr->getLineNumber());
+                }
+                break;
             }
+            // 处理一元表达式
+            case ASTKind::UnaryExpr: {
+                auto unaryExpr = cast<UnaryExprAST>(expr);
+                // 递归折叠子表达式
+                if (auto operand = foldExpr(unaryExpr->getOperand(), changed)) {
+                    unaryExpr->setOperand(std::move(operand));
+                    changed = true;
+                }
             
-            // 如果不是常量表达式，返回新的二元表达式
-            return std::make_unique<BinaryExprAST>(
-                binExpr->getOp(), 
-                std::move(lhs), 
-                std::move(rhs), 
-                binExpr->getLineNumber()
-            );
-        }
-        // 处理一元表达式
-        else if (auto unaryExpr = dynamic_cast<UnaryExprAST*>(expr)) {
-            // 递归折叠子表达式
-            auto operand = foldAndReplaceExpr(unaryExpr->getOperand());
-            
-            // 检查折叠后的操作数是否是整数常量
-            if (auto intConstOperand = dynamic_cast<IntConstExprAST*>(operand.get())) {
-                // 计算整数常量结果
-                int result = evaluateUnaryOp(unaryExpr->getOp(), intConstOperand->getValue());
+                // 检查操作数是否是整数常量
+                if (auto intConstOperand = dyn_cast<IntConstExprAST>(unaryExpr->getOperand())) {
+                    // 计算整数常量结果
+                    int result = evaluateUnaryOp(unaryExpr->getOp(), intConstOperand->getValue());
                 
-                // 返回整数常量表达式
-                return std::make_unique<IntConstExprAST>(result, unaryExpr->getLineNumber());
-            }
-            // 检查折叠后的操作数是否是浮点数常量
-            else if (auto floatConstOperand = dynamic_cast<FloatConstExprAST*>(operand.get())) {
-                // 计算浮点数常量结果
-                float result = evaluateUnaryOp(unaryExpr->getOp(), floatConstOperand->getValue());
+                    // 返回整数常量表达式
+                    return std::make_unique<IntConstExprAST>(result, unaryExpr->getLineNumber());
+                }
+                // 检查操作数是否是浮点数常量
+                else if (auto floatConstOperand = dyn_cast<FloatConstExprAST>(unaryExpr->getOperand())) {
+                    // 计算浮点数常量结果
+                    float result = evaluateUnaryOp(unaryExpr->getOp(), floatConstOperand->getValue());
                 
-                // 返回浮点数常量表达式
-                return std::make_unique<FloatConstExprAST>(result, unaryExpr->getLineNumber());
+                    // 返回浮点数常量表达式
+                    return std::make_unique<FloatConstExprAST>(result, unaryExpr->getLineNumber());
+                }
+                break;
             }
-            
-            // 如果不是常量表达式，返回新的一元表达式
-            return std::make_unique<UnaryExprAST>(
-                unaryExpr->getOp(), 
-                std::move(operand), 
-                unaryExpr->getLineNumber()
-            );
-        }
-        // 处理函数调用表达式
-        else if (auto callExpr = dynamic_cast<CallExprAST*>(expr)) {
-            // 递归折叠参数表达式
-            auto newCall = std::make_unique<CallExprAST>(callExpr->getCallee(), callExpr->getLineNumber());
-            for (auto& arg : callExpr->getArgs()) {
-                newCall->addArg(foldAndReplaceExpr(arg.get()));
+            // 处理函数调用表达式：逐个折叠实参
+            case ASTKind::CallExpr: {
+                auto callExpr = cast<CallExprAST>(expr);
+                const auto& args = callExpr->getArgs();
+                for (size_t i = 0; i < args.size(); ++i) {
+                    if (auto arg = foldExpr(args[i].get(), changed)) {
+                        callExpr->setArg(i, std::move(arg));
+                        changed = true;
+                    }
+                }
+                break;
             }
-            return newCall;
-        }
-        // 处理左值表达式
-        else if (auto lvalExpr = dynamic_cast<LValExprAST*>(expr)) {
-            // 递归折叠数组下标
-            auto newLVal = std::make_unique<LValExprAST>(lvalExpr->getName(), lvalExpr->getLineNumber());
-            for (auto& idx : lvalExpr->getIndices()) {
-                newLVal->addIndex(foldAndReplaceExpr(idx.get()));
+            // 处理左值表达式：逐个折叠数组下标
+            case ASTKind::LValExpr: {
+                auto lvalExpr = cast<LValExprAST>(expr);
+                const auto& indices = lvalExpr->getIndices();
+                for (size_t i = 0; i < indices.size(); ++i) {
+                    if (auto idx = foldExpr(indices[i].get(), changed)) {
+                        lvalExpr->setIndex(i, std::move(idx));
+                        changed = true;
+                    }
+                }
+                break;
             }
-            return newLVal;
+            default:
+                break;
         }
-        // 如果是其他类型的表达式，返回原表达式的克隆
-        return std::unique_ptr<ExprAST>(static_cast<ExprAST*>(expr->clone().release()));
+        
+        // 其他类型的表达式保持不变
+        return nullptr;
     }
     
     // 整数版本的二元运算
@@ -0,0 +1,1018 @@
+#ifndef FUNCTION_INLINING_H
+#define FUNCTION_INLINING_H
+
+#include "ast.h"
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// 函数内联：把小函数和只有一个调用点的函数在 AST 上展开到调用处
+// 展开代码插在调用所在语句之前：先声明返回值变量，再放一个块，块内用声明绑定形参，
+// 然后是克隆的函数体。被调函数的局部变量统一加 __inlN 后缀避免名字捕获；
+// return 改写为给返回值变量赋值并跳出 while (1) { ...; break; } 包装，
+// 唯一的 return 恰好是函数体最后一条语句时直接改成赋值，不加包装。
+class FunctionInliner {
+public:
+    explicit FunctionInliner(int budget = 60) : budget(budget) {}
+
+    // 内联预算：被调函数体的 AST 节点数上限，0 表示关闭内联
+    // 只有一个调用点的函数不受预算限制
+    void setBudget(int b) { budget = b; }
+    int getBudget() const { return budget; }
+
+    // 已展开的调用点数
+    int getInlinedCount() const { return inlineCounter; }
+
+    bool inlineCalls(CompUnitAST* ast) {
+        if (budget <= 0) {
+            return false;
+        }
+
+        functions.clear();
+        globals.clear();
+        callCounts.clear();
+        recursive.clear();
+        impure.clear();
+        inlinedCallees.clear();
+
+        for (const auto& decl : ast->getDecls()) {
+            declareNames(decl.get(), globals);
+        }
+        for (const auto& func : ast->getFunctions()) {
+            functions[func->getName()] = func.get();
+        }
+
+        // 调用次数与直接调用关系
+        std::map<std::string, FunctionInfo> infos;
+        for (const auto& func : ast->getFunctions()) {
+            infos[func->getName()] = analyzeFunction(func.get());
+            forEachCall(func->getBody(), [&](CallExprAST* call) {
+                callCounts[call->getCallee()]++;
+            });
+        }
+
+        // 有副作用的函数：写全局变量或数组形参、调用库函数、调用有副作用的函数
+        bool grew = true;
+        while (grew) {
+            grew = false;
+            for (const auto& [name, info] : infos) {
+                if (impure.count(name)) {
+                    continue;
+                }
+                bool effects = info.writesMemory || info.callsLibrary;
+                for (const auto& callee : info.callees) {
+                    effects |= impure.count(callee) > 0;
+                }
+                if (effects) {
+                    impure.insert(name);
+                    grew = true;
+                }
+            }
+        }
+
+        // 能沿调用图回到自身的函数不内联
+        for (const auto& [name, info] : infos) {
+            std::set<std::string> visited;
+            std::vector<std::string> worklist(info.callees.begin(), info.callees.end());
+            while (!worklist.empty()) {
+                std::string current = worklist.back();
+                worklist.pop_back();
+                if (current == name) {
+                    recursive.insert(name);
+                    break;
+                }
+                if (!infos.count(current) || !visited.insert(current).second) {
+                    continue;
+                }
+                for (const auto& callee : infos[current].callees) {
+                    worklist.push_back(callee);
+                }
+            }
+        }
+
+        // 按调用图后序处理：被调函数先完成内联，再展开到调用者中
+        std::vector<FunctionAST*> order;
+        std::set<std::string> visited;
+        std::function<void(const std::string&)> visit = [&](const std::string& name) {
+            if (!functions.count(name) || !visited.insert(name).second) {
+                return;
+            }
+            for (const auto& callee : infos[name].callees) {
+                visit(callee);
+            }
+            order.push_back(functions[name]);
+        };
+        for (const auto& func : ast->getFunctions()) {
+            visit(func->getName());
+        }
+
+        bool changed = false;
+        for (auto func : order) {
+            changed |= inlineInFunction(func);
+        }
+
+        if (changed) {
+            removeDeadFunctions(ast);
+        }
+        return changed;
+    }
+
+private:
+    enum class VarKind { Scalar, Array, ArrayParam };
+    using Scope = std::map<std::string, VarKind>;
+    using ScopeStack = std::vector<Scope>;
+
+    // 函数体的名字引用与副作用摘要
+    struct FunctionInfo {
+        std::set<std::string> freeNames;  // 引用的全局名字
+        std::set<std::string> callees;    // 直接调用的函数
+        bool writesMemory = false;        // 写全局变量或数组形参
+        bool callsLibrary = false;        // 调用库函数
+    };
+
+    // 展开时的名字映射：局部变量和标量形参改名，数组形参替换为实参（带常量下标前缀）
+    struct Alias {
+        std::string name;
+        const LValExprAST* arrayArg = nullptr;
+    };
+    using AliasStack = std::vector<std::map<std::string, Alias>>;
+
+    // 语句中可以提出调用的表达式位置，set 用于把调用替换为返回值变量
+    struct ExprSlot {
+        ExprAST* expr;
+        std::function<void(std::unique_ptr<ExprAST>)> set;
+    };
+
+    // 调用点之前已求值部分的效果
+    struct EffectScan {
+        const ExprAST* target = nullptr;
+        bool reached = false;
+        bool impureCall = false;
+        bool readsMemory = false;
+    };
+
+    int budget;
+    int inlineCounter = 0;
+    std::map<std::string, FunctionAST*> functions;
+    Scope globals;
+    std::map<std::string, int> callCounts;
+    std::set<std::string> recursive;
+    std::set<std::string> impure;
+    std::set<std::string> inlinedCallees;
+
+    // 当前调用者的作用域栈
+    std::string currentCaller;
+    ScopeStack callerScopes;
+
+    template <typename T>
+    static std::unique_ptr<T> cloneNode(const ASTNode* node) {
+        return std::unique_ptr<T>(static_cast<T*>(node->clone().release()));
+    }
+
+    // ==================== 遍历辅助 ====================
+
+    static void forEachExpr(ExprAST* expr, const std::function<void(ExprAST*)>& fn) {
+        if (!expr) {
+            return;
+        }
+        fn(expr);
+        switch (expr->getNodeKind()) {
+            case ASTKind::BinaryExpr: {
+                auto binExpr = cast<BinaryExprAST>(expr);
+                forEachExpr(binExpr->getLHS(), fn);
+                forEachExpr(binExpr->getRHS(), fn);
+                break;
+            }
+            case ASTKind::UnaryExpr: {
+                auto unaryExpr = cast<UnaryExprAST>(expr);
+                forEachExpr(unaryExpr->getOperand(), fn);
+                break;
+            }
+            case ASTKind::CallExpr: {
+                auto callExpr = cast<CallExprAST>(expr);
+                for (const auto& arg : callExpr->getArgs()) {
+                    forEachExpr(arg.get(), fn);
+                }
+                break;
+            }
+            case ASTKind::LValExpr: {
+                auto lval = cast<LValExprAST>(expr);
+                for (const auto& idx : lval->getIndices()) {
+                    forEachExpr(idx.get(), fn);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    static void forEachInitExpr(InitValAST* initVal, const std::function<void(ExprAST*)>& fn) {
+        if (auto exprInit = dyn_cast<ExprInitValAST>(initVal)) {
+            forEachExpr(exprInit->getExpr(), fn);
+        } else if (auto listInit = dyn_cast<ListInitValAST>(initVal)) {
+            for (const auto& val : listInit->getInitVals()) {
+                forEachInitExpr(val.get(), fn);
+            }
+        }
+    }
+
+    static void forEachDeclExpr(DeclAST* decl, const std::function<void(ExprAST*)>& fn) {
+        if (auto varDecl = dyn_cast<VarDeclAST>(decl)) {
+            for (const auto& def : varDecl->getVarDefs()) {
+                for (const auto& size : def->getArraySizes()) {
+                    forEachExpr(size.get(), fn);
+                }
+                forEachInitExpr(def->getInitVal(), fn);
+            }
+        } else if (auto constDecl = dyn_cast<ConstDeclAST>(decl)) {
+            for (const auto& def : constDecl->getConstDefs()) {
+                for (const auto& size : def->getArraySizes()) {
+                    forEachExpr(size.get(), fn);
+                }
+                forEachInitExpr(def->getInitVal(), fn);
+            }
+        }
+    }
+
+    // 遍历语句树中的所有语句和表达式（含声明中的维度与初值）
+    static void forEachNode(StmtAST* stmt,
+                            const std::function<void(StmtAST*)>& onStmt,
+                            const std::function<void(ExprAST*)>& onExpr) {
+        if (!stmt) {
+            return;
+        }
+        onStmt(stmt);
+        switch (stmt->getNodeKind()) {
+            case ASTKind::Block: {
+                auto block = cast<BlockAST>(stmt);
+                for (const auto& item : block->getItems()) {
+                    if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                        forEachDeclExpr(declItem->getDecl(), onExpr);
+                    } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                        forEachNode(stmtItem->getStmt(), onStmt, onExpr);
+                    }
+                }
+                break;
+            }
+            case ASTKind::AssignStmt: {
+                auto assignStmt = cast<AssignStmtAST>(stmt);
+                forEachExpr(assignStmt->getLVal(), onExpr);
+                forEachExpr(assignStmt->getExpr(), onExpr);
+                break;
+            }
+            case ASTKind::ExprStmt: {
+                auto exprStmt = cast<ExprStmtAST>(stmt);
+                forEachExpr(exprStmt->getExpr(), onExpr);
+                break;
+            }
+            case ASTKind::ReturnStmt: {
+                auto returnStmt = cast<ReturnStmtAST>(stmt);
+                forEachExpr(returnStmt->getReturnValue(), onExpr);
+                break;
+            }
+            case ASTKind::IfStmt: {
+                auto ifStmt = cast<IfStmtAST>(stmt);
+                forEachExpr(ifStmt->getCondition(), onExpr);
+                forEachNode(ifStmt->getThenStmt(), onStmt, onExpr);
+                forEachNode(ifStmt->getElseStmt(), onStmt, onExpr);
+                break;
+            }
+            case ASTKind::WhileStmt: {
+                auto whileStmt = cast<WhileStmtAST>(stmt);
+                forEachExpr(whileStmt->getCondition(), onExpr);
+                forEachNode(whileStmt->getBody(), onStmt, onExpr);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    static void forEachCall(StmtAST* stmt, const std::function<void(CallExprAST*)>& fn) {
+        forEachNode(stmt, [](StmtAST*) {}, [&](ExprAST* expr) {
+            if (auto callExpr = dyn_cast<CallExprAST>(expr)) {
+                fn(callExpr);
+            }
+        });
+    }
+
+    static int countNodes(StmtAST* stmt) {
+        int count = 0;
+        forEachNode(stmt, [&](StmtAST*) { count++; }, [&](ExprAST*) { count++; });
+        return count;
+    }
+
+    static int countReturns(StmtAST* stmt) {
+        int count = 0;
+        forEachNode(stmt, [&](StmtAST* s) {
+            if (dyn_cast<ReturnStmtAST>(s)) {
+                count++;
+            }
+        }, [](ExprAST*) {});
+        return count;
+    }
+
+    // 循环中的 return 需要跳出多层循环，这种函数不内联
+    static bool hasReturnInLoop(StmtAST* stmt) {
+        bool found = false;
+        forEachNode(stmt, [&](StmtAST* s) {
+            if (auto whileStmt = dyn_cast<WhileStmtAST>(s)) {
+                found |= countReturns(whileStmt->getBody()) > 0;
+            }
+        }, [](ExprAST*) {});
+        return found;
+    }
+
+    static bool containsCall(StmtAST* stmt) {
+        bool found = false;
+        forEachCall(stmt, [&](CallExprAST*) { found = true; });
+        return found;
+    }
+
+    static bool containsCall(ExprAST* expr) {
+        bool found = false;
+        forEachExpr(expr, [&](ExprAST* e) {
+            found |= dyn_cast<CallExprAST>(e) != nullptr;
+        });
+        return found;
+    }
+
+    // ==================== 作用域与函数摘要 ====================
+
+    static void declareNames(DeclAST* decl, Scope& scope) {
+        if (auto varDecl = dyn_cast<VarDeclAST>(decl)) {
+            for (const auto& def : varDecl->getVarDefs()) {
+                scope[def->getName()] = def->getArraySizes().empty() ? VarKind::Scalar : VarKind::Array;
+            }
+        } else if (auto constDecl = dyn_cast<ConstDeclAST>(decl)) {
+            for (const auto& def : constDecl->getConstDefs()) {
+                scope[def->getName()] = def->getArraySizes().empty() ? VarKind::Scalar : VarKind::Array;
+            }
+        }
+    }
+
+    static const VarKind* lookup(const ScopeStack& scopes, const std::string& name) {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) {
+                return &found->second;
+            }
+        }
+        return nullptr;
+    }
+
+    FunctionInfo analyzeFunction(FunctionAST* func) const {
+        FunctionInfo info;
+        ScopeStack scopes(1);
+        for (const auto& param : func->getParams()) {
+            scopes[0][param->getName()] = param->getIsArray() ? VarKind::ArrayParam : VarKind::Scalar;
+        }
+        analyzeStmt(func->getBody(), scopes, info);
+        return info;
+    }
+
+    void analyzeStmt(StmtAST* stmt, ScopeStack& scopes, FunctionInfo& info) const {
+        if (!stmt) {
+            return;
+        }
+        auto analyzeExpr = [&](ExprAST* expr) {
+            forEachExpr(expr, [&](ExprAST* e) {
+                if (auto lval = dyn_cast<LValExprAST>(e)) {
+                    if (!lookup(scopes, lval->getName())) {
+                        info.freeNames.insert(lval->getName());
+                    }
+                } else if (auto callExpr = dyn_cast<CallExprAST>(e)) {
+                    info.callees.insert(callExpr->getCallee());
+                    if (!functions.count(callExpr->getCallee())) {
+                        info.callsLibrary = true;
+                    }
+                }
+            });
+        };
+
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            scopes.emplace_back();
+            for (const auto& item : block->getItems()) {
+                if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                    // 初值在定义本身加入作用域之前求值
+                    forEachDeclExpr(declItem->getDecl(), analyzeExpr);
+                    declareNames(declItem->getDecl(), scopes.back());
+                } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    analyzeStmt(stmtItem->getStmt(), scopes, info);
+                }
+            }
+            scopes.pop_back();
+        } else if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            const VarKind* kind = lookup(scopes, assignStmt->getLVal()->getName());
+            if (!kind || *kind == VarKind::ArrayParam) {
+                info.writesMemory = true;
+            }
+            analyzeExpr(assignStmt->getLVal());
+            analyzeExpr(assignStmt->getExpr());
+        } else if (auto exprStmt = dyn_cast<ExprStmtAST>(stmt)) {
+            analyzeExpr(exprStmt->getExpr());
+        } else if (auto returnStmt = dyn_cast<ReturnStmtAST>(stmt)) {
+            analyzeExpr(returnStmt->getReturnValue());
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            analyzeExpr(ifStmt->getCondition());
+            analyzeStmt(ifStmt->getThenStmt(), scopes, info);
+            analyzeStmt(ifStmt->getElseStmt(), scopes, info);
+        } else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            analyzeExpr(whileStmt->getCondition());
+            analyzeStmt(whileStmt->getBody(), scopes, info);
+        }
+    }
+
+    bool isImpureCall(const CallExprAST* call) const {
+        return !functions.count(call->getCallee()) || impure.count(call->getCallee());
+    }
+
+    // 调用者中的名字是否指向标量局部变量（被调函数无法修改它）
+    bool isCallerLocalScalar(const std::string& name) const {
+        const VarKind* kind = lookup(callerScopes, name);
+        return kind && *kind == VarKind::Scalar;
+    }
+
+    // ==================== 调用者遍历 ====================
+
+    bool inlineInFunction(FunctionAST* func) {
+        currentCaller = func->getName();
+        callerScopes.clear();
+        callerScopes.emplace_back();
+        for (const auto& param : func->getParams()) {
+            callerScopes[0][param->getName()] = param->getIsArray() ? VarKind::ArrayParam : VarKind::Scalar;
+        }
+        bool changed = inlineInBlock(func->getBody());
+        callerScopes.clear();
+        return changed;
+    }
+
+    bool inlineInBlock(BlockAST* block) {
+        bool changed = false;
+        callerScopes.emplace_back();
+        auto& items = block->getMutableItems();
+        for (size_t i = 0; i < items.size();) {
+            std::vector<std::unique_ptr<BlockItemAST>> prefix;
+            if (inlineOneCall(items[i].get(), prefix)) {
+                // 展开代码插在语句之前且不再扫描，继续处理同一语句中的其余调用
+                size_t count = prefix.size();
+                items.insert(items.begin() + i,
+                             std::make_move_iterator(prefix.begin()),
+                             std::make_move_iterator(prefix.end()));
+                i += count;
+                changed = true;
+                continue;
+            }
+            if (auto declItem = dyn_cast<DeclBlockItemAST>(items[i].get())) {
+                declareNames(declItem->getDecl(), callerScopes.back());
+            } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(items[i].get())) {
+                changed |= inlineInNested(stmtItem->getStmt());
+            }
+            i++;
+        }
+        callerScopes.pop_back();
+        return changed;
+    }
+
+    bool inlineInNested(StmtAST* stmt) {
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            return inlineInBlock(block);
+        }
+        if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            bool changed = inlineInBranch(ifStmt->getThenStmt(), [&](std::unique_ptr<StmtAST> s) {
+                ifStmt->setThenStmt(std::move(s));
+            });
+            changed |= inlineInBranch(ifStmt->getElseStmt(), [&](std::unique_ptr<StmtAST> s) {
+                ifStmt->setElseStmt(std::move(s));
+            });
+            return changed;
+        }
+        if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            return inlineInBranch(whileStmt->getBody(), [&](std::unique_ptr<StmtAST> s) {
+                whileStmt->setBody(std::move(s));
+            });
+        }
+        return false;
+    }
+
+    // 非块的分支或循环体含调用时先包成块，展开代码才有插入位置
+    bool inlineInBranch(StmtAST* stmt, const std::function<void(std::unique_ptr<StmtAST>)>& setStmt) {
+        if (!stmt) {
+            return false;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            return inlineInBlock(block);
+        }
+        if (!containsCall(stmt)) {
+            return false;
+        }
+        auto block = std::make_unique<BlockAST>();
+        block->addItem(std::make_unique<StmtBlockItemAST>(cloneNode<StmtAST>(stmt)));
+        BlockAST* blockPtr = block.get();
+        setStmt(std::move(block));
+        return inlineInBlock(blockPtr);
+    }
+
+    // 按求值顺序收集语句中无条件求值位置上的表达式；while 条件每轮都要求值，不提出
+    static std::vector<ExprSlot> collectSlots(BlockItemAST* item, ExprStmtAST*& exprStmtOut) {
+        std::vector<ExprSlot> slots;
+        exprStmtOut = nullptr;
+        if (auto declItem = dyn_cast<DeclBlockItemAST>(item)) {
+            auto varDecl = dyn_cast<VarDeclAST>(declItem->getDecl());
+            if (!varDecl || varDecl->getVarDefs().empty()) {
+                return slots;
+            }
+            VarDefAST* def = varDecl->getVarDefs()[0].get();
+            auto exprInit = dyn_cast<ExprInitValAST>(def->getInitVal());
+            if (def->getArraySizes().empty() && exprInit) {
+                slots.push_back({exprInit->getExpr(), [exprInit](std::unique_ptr<ExprAST> e) {
+                    exprInit->setExpr(std::move(e));
+                }});
+            }
+            return slots;
+        }
+        auto stmtItem = dyn_cast<StmtBlockItemAST>(item);
+        if (!stmtItem) {
+            return slots;
+        }
+        StmtAST* stmt = stmtItem->getStmt();
+        if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            LValExprAST* lval = assignStmt->getLVal();
+            for (size_t i = 0; i < lval->getIndices().size(); i++) {
+                slots.push_back({lval->getIndices()[i].get(), [lval, i](std::unique_ptr<ExprAST> e) {
+                    lval->setIndex(i, std::move(e));
+                }});
+            }
+            slots.push_back({assignStmt->getExpr(), [assignStmt](std::unique_ptr<ExprAST> e) {
+                assignStmt->setExpr(std::move(e));
+            }});
+        } else if (auto exprStmt = dyn_cast<ExprStmtAST>(stmt)) {
+            if (exprStmt->getExpr()) {
+                exprStmtOut = exprStmt;
+                slots.push_back({exprStmt->getExpr(), [exprStmt](std::unique_ptr<ExprAST> e) {
+                    exprStmt->setExpr(std::move(e));
+                }});
+            }
+        } else if (auto returnStmt = dyn_cast<ReturnStmtAST>(stmt)) {
+            if (returnStmt->getReturnValue()) {
+                slots.push_back({returnStmt->getReturnValue(), [returnStmt](std::unique_ptr<ExprAST> e) {
+                    returnStmt->setReturnValue(std::move(e));
+                }});
+            }
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            slots.push_back({ifStmt->getCondition(), [ifStmt](std::unique_ptr<ExprAST> e) {
+                ifStmt->setCondition(std::move(e));
+            }});
+        }
+        return slots;
+    }
+
+    // 按求值顺序（实参先于调用本身）收集调用，这样嵌套调用的实参会先被展开；
+    // && 和 || 的右操作数是条件求值的，跳过
+    static void collectCandidates(ExprAST* expr, std::vector<CallExprAST*>& out) {
+        if (auto callExpr = dyn_cast<CallExprAST>(expr)) {
+            for (const auto& arg : callExpr->getArgs()) {
+                collectCandidates(arg.get(), out);
+            }
+            out.push_back(callExpr);
+        } else if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            collectCandidates(binExpr->getLHS(), out);
+            if (binExpr->getOp() != BinaryExprAST::Operator::AND &&
+                binExpr->getOp() != BinaryExprAST::Operator::OR) {
+                collectCandidates(binExpr->getRHS(), out);
+            }
+        } else if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            collectCandidates(unaryExpr->getOperand(), out);
+        } else if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            for (const auto& idx : lval->getIndices()) {
+                collectCandidates(idx.get(), out);
+            }
+        }
+    }
+
+    // 按求值顺序扫描目标调用之前的部分
+    void scanBefore(ExprAST* expr, EffectScan& scan) const {
+        if (!expr || scan.reached) {
+            return;
+        }
+        if (expr == scan.target) {
+            scan.reached = true;
+            return;
+        }
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            scanBefore(binExpr->getLHS(), scan);
+            scanBefore(binExpr->getRHS(), scan);
+        } else if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            scanBefore(unaryExpr->getOperand(), scan);
+        } else if (auto callExpr = dyn_cast<CallExprAST>(expr)) {
+            for (const auto& arg : callExpr->getArgs()) {
+                scanBefore(arg.get(), scan);
+            }
+            if (!scan.reached) {
+                scan.readsMemory = true;
+                scan.impureCall |= isImpureCall(callExpr);
+            }
+        } else if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            for (const auto& idx : lval->getIndices()) {
+                scanBefore(idx.get(), scan);
+            }
+            if (!scan.reached && !isCallerLocalScalar(lval->getName())) {
+                scan.readsMemory = true;
+            }
+        }
+    }
+
+    bool canInline(CallExprAST* call, FunctionAST* callee) const {
+        const std::string& name = callee->getName();
+        if (name == currentCaller || recursive.count(name)) {
+            return false;
+        }
+        if (call->getArgs().size() != callee->getParams().size()) {
+            return false;
+        }
+        auto countIt = callCounts.find(name);
+        bool singleCallSite = countIt != callCounts.end() && countIt->second == 1;
+        if (!singleCallSite && countNodes(callee->getBody()) > budget) {
+            return false;
+        }
+        if (hasReturnInLoop(callee->getBody())) {
+            return false;
+        }
+
+        // 数组实参只支持常量下标的数组名，展开时直接替换形参
+        for (size_t i = 0; i < call->getArgs().size(); i++) {
+            if (!callee->getParams()[i]->getIsArray()) {
+                continue;
+            }
+            auto lval = dyn_cast<LValExprAST>(call->getArgs()[i].get());
+            if (!lval) {
+                return false;
+            }
+            const VarKind* kind = lookup(callerScopes, lval->getName());
+            if (!kind) {
+                auto globalIt = globals.find(lval->getName());
+                kind = globalIt == globals.end() ? nullptr : &globalIt->second;
+            }
+            if (!kind || *kind == VarKind::Scalar) {
+                return false;
+            }
+            for (const auto& idx : lval->getIndices()) {
+                if (!dyn_cast<IntConstExprAST>(idx.get())) {
+                    return false;
+                }
+            }
+        }
+
+        // 被调函数引用的全局名字被调用者的局部变量遮蔽时无法展开
+        FunctionInfo info = analyzeFunction(callee);
+        for (const auto& freeName : info.freeNames) {
+            if (lookup(callerScopes, freeName)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool inlineOneCall(BlockItemAST* item, std::vector<std::unique_ptr<BlockItemAST>>& prefix) {
+        ExprStmtAST* exprStmt = nullptr;
+        std::vector<ExprSlot> slots = collectSlots(item, exprStmt);
+
+        for (size_t s = 0; s < slots.size(); s++) {
+            std::vector<CallExprAST*> candidates;
+            collectCandidates(slots[s].expr, candidates);
+
+            for (auto call : candidates) {
+                auto funcIt = functions.find(call->getCallee());
+                if (funcIt == functions.end()) {
+                    continue;
+                }
+                FunctionAST* callee = funcIt->second;
+                bool wholeStmt = exprStmt && exprStmt->getExpr() == call;
+                bool isVoid = callee->getReturnType()->getKind() == TypeAST::Kind::VOID;
+                if ((isVoid && !wholeStmt) || !canInline(call, callee)) {
+                    continue;
+                }
+
+                // 把调用提到语句之前：先求值的部分不能有副作用调用；
+                // 调用本身有副作用时，先求值的部分也不能读内存
+                EffectScan scan;
+                scan.target = call;
+                for (size_t k = 0; k <= s && !scan.reached; k++) {
+                    scanBefore(slots[k].expr, scan);
+                }
+                bool unitEffects = impure.count(callee->getName()) > 0;
+                for (const auto& arg : call->getArgs()) {
+                    forEachExpr(arg.get(), [&](ExprAST* e) {
+                        if (auto argCall = dyn_cast<CallExprAST>(e)) {
+                            unitEffects |= isImpureCall(argCall);
+                        }
+                    });
+                }
+                if (scan.impureCall || (unitEffects && scan.readsMemory)) {
+                    continue;
+                }
+
+                bool needResult = !isVoid && !wholeStmt;
+                std::string retName = expandCall(call, callee, needResult, prefix);
+                if (wholeStmt) {
+                    exprStmt->setExpr(nullptr);
+                } else if (slots[s].expr == call) {
+                    slots[s].set(std::make_unique<LValExprAST>(retName, call->getLineNumber()));
+                } else {
+                    std::unique_ptr<ExprAST> replacement =
+                        std::make_unique<LValExprAST>(retName, call->getLineNumber());
+                    replaceChild(slots[s].expr, call, replacement);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool replaceChild(ExprAST* expr, const ExprAST* target, std::unique_ptr<ExprAST>& replacement) {
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            if (binExpr->getLHS() == target) {
+                binExpr->setLHS(std::move(replacement));
+                return true;
+            }
+            if (binExpr->getRHS() == target) {
+                binExpr->setRHS(std::move(replacement));
+                return true;
+            }
+            return replaceChild(binExpr->getLHS(), target, replacement) ||
+                   replaceChild(binExpr->getRHS(), target, replacement);
+        }
+        if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            if (unaryExpr->getOperand() == target) {
+                unaryExpr->setOperand(std::move(replacement));
+                return true;
+            }
+            return replaceChild(unaryExpr->getOperand(), target, replacement);
+        }
+        if (auto callExpr = dyn_cast<CallExprAST>(expr)) {
+            for (size_t i = 0; i < callExpr->getArgs().size(); i++) {
+                if (callExpr->getArgs()[i].get() == target) {
+                    callExpr->setArg(i, std::move(replacement));
+                    return true;
+                }
+                if (replaceChild(callExpr->getArgs()[i].get(), target, replacement)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            for (size_t i = 0; i < lval->getIndices().size(); i++) {
+                if (lval->getIndices()[i].get() == target) {
+                    lval->setIndex(i, std::move(replacement));
+                    return true;
+                }
+                if (replaceChild(lval->getIndices()[i].get(), target, replacement)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // ==================== 展开 ====================
+
+    // 生成展开代码追加到 prefix，返回保存结果的变量名
+    std::string expandCall(CallExprAST* call, FunctionAST* callee, bool needResult,
+                           std::vector<std::unique_ptr<BlockItemAST>>& prefix) {
+        std::string suffix = "__inl" + std::to_string(++inlineCounter);
+        std::string retName = callee->getName() + "__ret" + suffix;
+
+        if (needResult) {
+            auto retDecl = std::make_unique<VarDeclAST>(cloneNode<TypeAST>(callee->getReturnType()));
+            retDecl->addVarDef(std::make_unique<VarDefAST>(retName));
+            prefix.push_back(std::make_unique<DeclBlockItemAST>(std::move(retDecl)));
+            callerScopes.back()[retName] = VarKind::Scalar;
+        }
+
+        // 形参绑定：标量形参声明为带初值的局部变量，数组形参直接用实参替换
+        auto inlined = std::make_unique<BlockAST>();
+        AliasStack aliases(1);
+        for (size_t i = 0; i < callee->getParams().size(); i++) {
+            FuncFParamAST* param = callee->getParams()[i].get();
+            ExprAST* arg = call->getArgs()[i].get();
+            if (param->getIsArray()) {
+                aliases[0][param->getName()] = Alias{"", static_cast<LValExprAST*>(arg)};
+                continue;
+            }
+            std::string paramName = param->getName() + suffix;
+            auto paramDecl = std::make_unique<VarDeclAST>(cloneNode<TypeAST>(param->getType()));
+            auto paramDef = std::make_unique<VarDefAST>(paramName);
+            paramDef->setInitVal(std::make_unique<ExprInitValAST>(cloneNode<ExprAST>(arg)));
+            paramDecl->addVarDef(std::move(paramDef));
+            inlined->addItem(std::make_unique<DeclBlockItemAST>(std::move(paramDecl)));
+            aliases[0][param->getName()] = Alias{paramName, nullptr};
+        }
+
+        auto body = cloneNode<BlockAST>(callee->getBody());
+        renameBlock(body.get(), aliases, suffix);
+
+        callCounts[callee->getName()]--;
+        forEachCall(body.get(), [&](CallExprAST* inner) {
+            callCounts[inner->getCallee()]++;
+        });
+        inlinedCallees.insert(callee->getName());
+
+        auto& items = body->getMutableItems();
+        int returns = countReturns(body.get());
+        bool tailReturn = returns == 1 && !items.empty() && returnOf(items.back().get());
+        if (returns == 0 || tailReturn) {
+            if (tailReturn) {
+                auto replacement = rewriteReturn(returnOf(items.back().get()), needResult, retName, false);
+                if (replacement) {
+                    items.back() = std::make_unique<StmtBlockItemAST>(std::move(replacement));
+                } else {
+                    items.pop_back();
+                }
+            }
+            inlined->addItem(std::make_unique<StmtBlockItemAST>(std::move(body)));
+        } else {
+            rewriteReturns(body.get(), needResult, retName);
+            auto loopBody = std::make_unique<BlockAST>();
+            loopBody->addItem(std::make_unique<StmtBlockItemAST>(std::move(body)));
+            loopBody->addItem(std::make_unique<StmtBlockItemAST>(std::make_unique<BreakStmtAST>()));
+            auto loop = std::make_unique<WhileStmtAST>(std::make_unique<IntConstExprAST>(1), std::move(loopBody));
+            inlined->addItem(std::make_unique<StmtBlockItemAST>(std::move(loop)));
+        }
+
+        prefix.push_back(std::make_unique<StmtBlockItemAST>(std::move(inlined)));
+        return retName;
+    }
+
+    static ReturnStmtAST* returnOf(BlockItemAST* item) {
+        auto stmtItem = dyn_cast<StmtBlockItemAST>(item);
+        return stmtItem ? dyn_cast<ReturnStmtAST>(stmtItem->getStmt()) : nullptr;
+    }
+
+    // return e 改写为 ret = e（结果不用时保留有调用的表达式），需要时再跟 break
+    static std::unique_ptr<StmtAST> rewriteReturn(ReturnStmtAST* ret, bool needResult,
+                                                  const std::string& retName, bool withBreak) {
+        std::unique_ptr<StmtAST> action;
+        if (ExprAST* value = ret->getReturnValue()) {
+            if (needResult) {
+                action = std::make_unique<AssignStmtAST>(std::make_unique<LValExprAST>(retName),
+                                                         cloneNode<ExprAST>(value));
+            } else if (containsCall(value)) {
+                action = std::make_unique<ExprStmtAST>(cloneNode<ExprAST>(value));
+            }
+        }
+        if (!withBreak) {
+            return action;
+        }
+        auto block = std::make_unique<BlockAST>();
+        if (action) {
+            block->addItem(std::make_unique<StmtBlockItemAST>(std::move(action)));
+        }
+        block->addItem(std::make_unique<StmtBlockItemAST>(std::make_unique<BreakStmtAST>()));
+        return block;
+    }
+
+    static void rewriteReturns(StmtAST* stmt, bool needResult, const std::string& retName) {
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            for (auto& item : block->getMutableItems()) {
+                if (auto ret = returnOf(item.get())) {
+                    item = std::make_unique<StmtBlockItemAST>(rewriteReturn(ret, needResult, retName, true));
+                } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    rewriteReturns(stmtItem->getStmt(), needResult, retName);
+                }
+            }
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            if (auto ret = dyn_cast<ReturnStmtAST>(ifStmt->getThenStmt())) {
+                ifStmt->setThenStmt(rewriteReturn(ret, needResult, retName, true));
+            } else {
+                rewriteReturns(ifStmt->getThenStmt(), needResult, retName);
+            }
+            if (auto ret = dyn_cast<ReturnStmtAST>(ifStmt->getElseStmt())) {
+                ifStmt->setElseStmt(rewriteReturn(ret, needResult, retName, true));
+            } else if (ifStmt->getElseStmt()) {
+                rewriteReturns(ifStmt->getElseStmt(), needResult, retName);
+            }
+        }
+    }
+
+    // 按作用域重命名克隆出的函数体
+    static void renameBlock(BlockAST* block, AliasStack& aliases, const std::string& suffix) {
+        aliases.emplace_back();
+        for (const auto& item : block->getItems()) {
+            if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                // 维度和初值按定义加入作用域之前的名字解析
+                if (auto varDecl = dyn_cast<VarDeclAST>(declItem->getDecl())) {
+                    for (const auto& def : varDecl->getVarDefs()) {
+                        renameDef(def.get(), aliases, suffix);
+                    }
+                } else if (auto constDecl = dyn_cast<ConstDeclAST>(declItem->getDecl())) {
+                    for (const auto& def : constDecl->getConstDefs()) {
+                        renameDef(def.get(), aliases, suffix);
+                    }
+                }
+            } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                renameStmt(stmtItem->getStmt(), aliases, suffix);
+            }
+        }
+        aliases.pop_back();
+    }
+
+    template <typename Def>
+    static void renameDef(Def* def, AliasStack& aliases, const std::string& suffix) {
+        for (const auto& size : def->getArraySizes()) {
+            renameExpr(size.get(), aliases);
+        }
+        forEachInitExpr(def->getInitVal(), [&](ExprAST* e) {
+            if (auto lval = dyn_cast<LValExprAST>(e)) {
+                renameLVal(lval, aliases);
+            }
+        });
+        std::string newName = def->getName() + suffix;
+        aliases.back()[def->getName()] = Alias{newName, nullptr};
+        def->setName(newName);
+    }
+
+    static void renameStmt(StmtAST* stmt, AliasStack& aliases, const std::string& suffix) {
+        if (!stmt) {
+            return;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            renameBlock(block, aliases, suffix);
+        } else if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            renameExpr(assignStmt->getLVal(), aliases);
+            renameExpr(assignStmt->getExpr(), aliases);
+        } else if (auto exprStmt = dyn_cast<ExprStmtAST>(stmt)) {
+            renameExpr(exprStmt->getExpr(), aliases);
+        } else if (auto returnStmt = dyn_cast<ReturnStmtAST>(stmt)) {
+            renameExpr(returnStmt->getReturnValue(), aliases);
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            renameExpr(ifStmt->getCondition(), aliases);
+            renameStmt(ifStmt->getThenStmt(), aliases, suffix);
+            renameStmt(ifStmt->getElseStmt(), aliases, suffix);
+        } else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            renameExpr(whileStmt->getCondition(), aliases);
+            renameStmt(whileStmt->getBody(), aliases, suffix);
+        }
+    }
+
+    static void renameExpr(ExprAST* expr, AliasStack& aliases) {
+        forEachExpr(expr, [&](ExprAST* e) {
+            if (auto lval = dyn_cast<LValExprAST>(e)) {
+                renameLVal(lval, aliases);
+            }
+        });
+    }
+
+    // 下标中的 LVal 由外层遍历单独处理，这里只改名字本身
+    static void renameLVal(LValExprAST* lval, const AliasStack& aliases) {
+        for (auto it = aliases.rbegin(); it != aliases.rend(); ++it) {
+            auto found = it->find(lval->getName());
+            if (found == it->end()) {
+                continue;
+            }
+            const Alias& alias = found->second;
+            if (alias.arrayArg) {
+                auto& indices = lval->getMutableIndices();
+                std::vector<std::unique_ptr<ExprAST>> prefixIndices;
+                for (const auto& idx : alias.arrayArg->getIndices()) {
+                    prefixIndices.push_back(cloneNode<ExprAST>(idx.get()));
+                }
+                indices.insert(indices.begin(),
+                               std::make_move_iterator(prefixIndices.begin()),
+                               std::make_move_iterator(prefixIndices.end()));
+                lval->setName(alias.arrayArg->getName());
+            } else {
+                lval->setName(alias.name);
+            }
+            return;
+        }
+    }
+
+    // 删除所有调用点都已展开的函数
+    void removeDeadFunctions(CompUnitAST* ast) {
+        auto& funcs = ast->getMutableFunctions();
+        bool removed = true;
+        while (removed) {
+            removed = false;
+            for (auto it = funcs.begin(); it != funcs.end(); ++it) {
+                const std::string name = (*it)->getName();
+                if (name == "main" || !inlinedCallees.count(name) || callCounts[name] > 0) {
+                    continue;
+                }
+                forEachCall((*it)->getBody(), [&](CallExprAST* call) {
+                    callCounts[call->getCallee()]--;
+                });
+                functions.erase(name);
+                funcs.erase(it);
+                removed = true;
+                break;
+            }
+        }
+    }
+};
+
+#endif // FUNCTION_INLINING_H
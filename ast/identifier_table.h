@@ -0,0 +1,84 @@
+#ifndef IDENTIFIER_TABLE_H
+#define IDENTIFIER_TABLE_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 驻留后的标识符：名字只保存一份，编号在所属 IdentifierTable 内从 0 开始连续分配，
+// 可以直接作为数组下标（见 IRGenerator 的符号表）
+class IdentifierInfo {
+private:
+    std::string name;
+    unsigned id;
+
+public:
+    IdentifierInfo(std::string name, unsigned id) : name(std::move(name)), id(id) {}
+
+    const std::string& getName() const { return name; }
+    unsigned getID() const { return id; }
+};
+
+// AST 中保存的标识符句柄：同名标识符指向同一个 IdentifierInfo，比较只需比较指针
+using Identifier = const IdentifierInfo*;
+
+// 标识符驻留表。
+//
+// 与 ASTArena 一样，一次编译创建一个 IdentifierTable 并用 IdentifierTable::Scope 设为
+// 当前线程的表，ASTBuilder 建树和优化时改名都从它取得 Identifier；表必须比 AST 活得久。
+// 没有设置当前表时使用线程自带的后备表。
+class IdentifierTable {
+private:
+    std::deque<IdentifierInfo> identifiers;                      // deque 扩容时元素地址不变
+    std::unordered_map<std::string_view, IdentifierInfo*> index; // 键指向 identifiers 中的名字
+
+    static IdentifierTable*& currentSlot() {
+        static thread_local IdentifierTable* current = nullptr;
+        return current;
+    }
+
+public:
+    IdentifierTable() = default;
+
+    IdentifierTable(const IdentifierTable&) = delete;
+    IdentifierTable& operator=(const IdentifierTable&) = delete;
+
+    // 取得 name 对应的标识符，首次出现时分配新编号
+    Identifier get(std::string_view name) {
+        auto it = index.find(name);
+        if (it != index.end()) {
+            return it->second;
+        }
+        IdentifierInfo& info = identifiers.emplace_back(std::string(name), static_cast<unsigned>(identifiers.size()));
+        index.emplace(info.getName(), &info);
+        return &info;
+    }
+
+    // 已分配的编号数（所有编号都小于它）
+    size_t size() const { return identifiers.size(); }
+
+    // 当前线程正在使用的表
+    static IdentifierTable& current() {
+        if (IdentifierTable* table = currentSlot()) {
+            return *table;
+        }
+        static thread_local IdentifierTable fallback;
+        return fallback;
+    }
+
+    // 在作用域内把 table 设为当前线程的表，退出时恢复之前的设置
+    class Scope {
+    private:
+        IdentifierTable* previous;
+
+    public:
+        explicit Scope(IdentifierTable* table) : previous(currentSlot()) { currentSlot() = table; }
+        ~Scope() { currentSlot() = previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+#endif // IDENTIFIER_TABLE_H
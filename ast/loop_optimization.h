@@ -2,64 +2,1202 @@
 #define LOOP_OPTIMIZATION_H
 
 #include "ast.h"
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
 
+// 循环不变量外提（LICM）
+// 对每个 while 循环统计循环内写过的变量和数组，把只依赖循环外不变值的最大子表达式
+// （含数组下标中的子表达式和下标不变的数组元素读取）提到循环前的 __licm_N 临时变量中。
+// 外层循环先处理，提出的代码放在循环所在块中循环语句之前。
+// 可能出错的表达式（整数除法/取模、数组读取）只从循环体中每轮必然执行的位置提出，
+// 并用 if (循环条件) 保护，保证循环一次都不执行时也不会提前出错；循环自身的条件中的这类表达式不外提。
+//
+// 循环展开：识别 init / i op bound / 末尾 i = i ± c 的规范归纳变量循环。
+// 初值和边界都是常量且展开后规模不大时完全展开，每份循环体中 i 替换为常量；
+// 否则按展开因子部分展开：主循环每轮执行 factor 份循环体，原循环作为余数循环。
+// 含 continue 的循环不展开；含 break 的循环只完全展开（包在 while (1) 中保持 break 语义）。
 class LoopOptimizer {
 public:
+    // 部分展开因子：0 关闭所有展开，1 只做完全展开
+    void setUnrollFactor(int factor) { unrollFactor = factor; }
+    int getUnrollFactor() const { return unrollFactor; }
+
     bool optimize(CompUnitAST* ast) {
         bool changed = false;
-        
+
+        globals.clear();
+        for (auto& decl : ast->getDecls()) {
+            declareNames(decl.get(), globals, true);
+        }
+
         // 遍历所有函数，对每个函数进行循环优化
         for (auto& func : ast->getFunctions()) {
             changed |= optimizeInFunction(func.get());
+            if (unrollFactor > 0) {
+                changed |= unrollInFunction(func.get());
+            }
         }
-        
+
         return changed;
     }
-    
+
 private:
+    // 变量的类型与存储信息
+    struct VarInfo {
+        bool isFloat = false;
+        bool isVector = false;
+        bool isConst = false;
+        bool isGlobal = false;
+        bool isParam = false;
+        size_t dims = 0;  // 数组维数，0 表示标量
+    };
+    using Scope = std::map<std::string, VarInfo>;
+
+    // 单个循环的读写摘要
+    struct LoopInfo {
+        std::set<std::string> variantNames;   // 循环内赋值或声明的名字
+        std::set<std::string> writtenArrays;  // 循环内写过的数组
+        bool writesGlobalArray = false;       // 写了全局数组（可能与数组形参别名）
+        bool writesParamArray = false;        // 写了数组形参（可能与任何全局数组或形参别名）
+        bool hasCall = false;                 // 调用可能读写任意内存
+    };
+
+    // 一次外提的上下文
+    struct HoistContext {
+        LoopInfo info;
+        std::map<std::string, std::string> temps;  // 表达式 -> 临时变量名
+        std::vector<std::unique_ptr<BlockItemAST>> decls;
+        std::unique_ptr<BlockAST> guarded;         // 需要 if (条件) 保护的赋值
+        bool canGuard = false;                     // 条件无调用，可以重复求值
+        bool condAlwaysTrue = false;               // while (1) 之类无需保护
+    };
+
+    // 完全展开的上限：迭代次数和展开后的循环体节点数
+    static constexpr long long kFullUnrollMaxTrips = 16;
+    static constexpr long long kFullUnrollMaxNodes = 512;
+    // 部分展开后主循环体的节点数上限
+    static constexpr int kPartialUnrollMaxNodes = 256;
+
+    Scope globals;
+    std::vector<Scope> scopes;
+    int tempCounter = 0;
+    int unrollFactor = 4;
+
+    template <typename T>
+    static std::unique_ptr<T> cloneNode(const ASTNode* node) {
+        return std::unique_ptr<T>(static_cast<T*>(node->clone().release()));
+    }
+
+    static void declareNames(DeclAST* decl, Scope& scope, bool isGlobal) {
+        if (auto varDecl = dyn_cast<VarDeclAST>(decl)) {
+            for (auto& varDef : varDecl->getVarDefs()) {
+                VarInfo info;
+                info.isFloat = varDecl->getType()->getKind() == TypeAST::Kind::FLOAT;
+                info.isVector = varDecl->getType()->isVector();
+                info.isGlobal = isGlobal;
+                info.dims = varDef->getArraySizes().size();
+                scope[varDef->getName()] = info;
+            }
+        } else if (auto constDecl = dyn_cast<ConstDeclAST>(decl)) {
+            for (auto& constDef : constDecl->getConstDefs()) {
+                VarInfo info;
+                info.isFloat = constDecl->getType()->getKind() == TypeAST::Kind::FLOAT;
+                info.isVector = constDecl->getType()->isVector();
+                info.isConst = true;
+                info.isGlobal = isGlobal;
+                info.dims = constDef->getArraySizes().size();
+                scope[constDef->getName()] = info;
+            }
+        }
+    }
+
+    const VarInfo* lookupVar(const std::string& name) const {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) {
+                return &found->second;
+            }
+        }
+        auto found = globals.find(name);
+        return found == globals.end() ? nullptr : &found->second;
+    }
+
+    void enterFunction(FunctionAST* func) {
+        scopes.clear();
+        scopes.emplace_back();
+        for (auto& param : func->getParams()) {
+            VarInfo info;
+            info.isFloat = param->getType()->getKind() == TypeAST::Kind::FLOAT;
+            info.isVector = param->getType()->isVector();
+            info.isParam = true;
+            info.dims = param->getIsArray() ? param->getArraySizes().size() + 1 : 0;
+            scopes.back()[param->getName()] = info;
+        }
+    }
+
     bool optimizeInFunction(FunctionAST* func) {
+        enterFunction(func);
+
         // 在函数体中查找并优化循环
-        return optimizeInBlock(func->getBody());
+        bool changed = optimizeInBlock(func->getBody());
+        scopes.clear();
+        return changed;
     }
-    
+
     bool optimizeInBlock(BlockAST* block) {
         bool changed = false;
-        
+        scopes.emplace_back();
+
         // 遍历块中的所有语句，查找WhileStmtAST
-        for (auto& item : block->getItems()) {
-            if (auto stmtItem = dynamic_cast<StmtBlockItemAST*>(item.get())) {
-                auto stmt = stmtItem->getStmt();
-                
-                // 递归处理嵌套块
-                if (auto nestedBlock = dynamic_cast<BlockAST*>(stmt)) {
-                    changed |= optimizeInBlock(nestedBlock);
-                }
-                // 处理if语句的分支
-                else if (auto ifStmt = dynamic_cast<IfStmtAST*>(stmt)) {
-                    if (auto thenBlock = dynamic_cast<BlockAST*>(ifStmt->getThenStmt())) {
-                        changed |= optimizeInBlock(thenBlock);
+        auto& items = block->getMutableItems();
+        for (size_t i = 0; i < items.size(); i++) {
+            if (auto declItem = dyn_cast<DeclBlockItemAST>(items[i].get())) {
+                declareNames(declItem->getDecl(), scopes.back(), false);
+                continue;
+            }
+            auto stmtItem = dyn_cast<StmtBlockItemAST>(items[i].get());
+            if (!stmtItem) {
+                continue;
+            }
+            auto stmt = stmtItem->getStmt();
+
+            // 递归处理嵌套块
+            if (auto nestedBlock = dyn_cast<BlockAST>(stmt)) {
+                changed |= optimizeInBlock(nestedBlock);
+            }
+            // 处理if语句的分支
+            else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+                changed |= optimizeInBranch(ifStmt->getThenStmt(), [&](std::unique_ptr<StmtAST> s) {
+                    ifStmt->setThenStmt(std::move(s));
+                });
+                changed |= optimizeInBranch(ifStmt->getElseStmt(), [&](std::unique_ptr<StmtAST> s) {
+                    ifStmt->setElseStmt(std::move(s));
+                });
+            }
+            // 处理循环：先外提到循环之前，再处理内层循环
+            else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+                std::vector<std::unique_ptr<BlockItemAST>> hoisted;
+                if (optimizeLoop(whileStmt, hoisted)) {
+                    for (auto& item : hoisted) {
+                        if (auto hoistedDecl = dyn_cast<DeclBlockItemAST>(item.get())) {
+                            declareNames(hoistedDecl->getDecl(), scopes.back(), false);
+                        }
                     }
-                    if (auto elseStmt = ifStmt->getElseStmt()) {
-                        if (auto elseBlock = dynamic_cast<BlockAST*>(elseStmt)) {
-                            changed |= optimizeInBlock(elseBlock);
+                    size_t count = hoisted.size();
+                    items.insert(items.begin() + i,
+                                 std::make_move_iterator(hoisted.begin()),
+                                 std::make_move_iterator(hoisted.end()));
+                    i += count;
+                    changed = true;
+                }
+                changed |= optimizeInBranch(whileStmt->getBody(), [&](std::unique_ptr<StmtAST> s) {
+                    whileStmt->setBody(std::move(s));
+                });
+            }
+        }
+
+        scopes.pop_back();
+        return changed;
+    }
+
+    // 非块分支中有循环时包成块，外提的代码才有插入位置
+    using BlockHandler = bool (LoopOptimizer::*)(BlockAST*);
+
+    bool optimizeInBranch(StmtAST* stmt, const std::function<void(std::unique_ptr<StmtAST>)>& setStmt,
+                          BlockHandler handler = &LoopOptimizer::optimizeInBlock) {
+        if (!stmt) {
+            return false;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            return (this->*handler)(block);
+        }
+        if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            bool changed = optimizeInBranch(ifStmt->getThenStmt(), [&](std::unique_ptr<StmtAST> s) {
+                ifStmt->setThenStmt(std::move(s));
+            }, handler);
+            changed |= optimizeInBranch(ifStmt->getElseStmt(), [&](std::unique_ptr<StmtAST> s) {
+                ifStmt->setElseStmt(std::move(s));
+            }, handler);
+            return changed;
+        }
+        if (!dyn_cast<WhileStmtAST>(stmt)) {
+            return false;
+        }
+        auto block = std::make_unique<BlockAST>();
+        block->addItem(std::make_unique<StmtBlockItemAST>(cloneNode<StmtAST>(stmt)));
+        BlockAST* blockPtr = block.get();
+        setStmt(std::move(block));
+        return (this->*handler)(blockPtr);
+    }
+
+    bool optimizeLoop(WhileStmtAST* loop, std::vector<std::unique_ptr<BlockItemAST>>& hoisted) {
+        HoistContext ctx;
+        analyzeStmt(loop, ctx.info);
+        ctx.canGuard = !containsCall(loop->getCondition());
+        if (auto condConst = dyn_cast<IntConstExprAST>(loop->getCondition())) {
+            ctx.condAlwaysTrue = condConst->getValue() != 0;
+        }
+        ctx.guarded = std::make_unique<BlockAST>();
+
+        // 条件中可能出错的表达式不外提：保护条件为假时临时变量没有赋值，
+        // 而循环条件仍要读它；只外提条件中不会出错、可以直接初始化的部分
+        hoistInExpr(loop->getCondition(), [&](std::unique_ptr<ExprAST> e) {
+            loop->setCondition(std::move(e));
+        }, false, ctx);
+        hoistInStmt(loop->getBody(), true, ctx);
+
+        if (ctx.decls.empty()) {
+            return false;
+        }
+        for (auto& decl : ctx.decls) {
+            hoisted.push_back(std::move(decl));
+        }
+        if (!ctx.guarded->getItems().empty()) {
+            auto guard = std::make_unique<IfStmtAST>(cloneNode<ExprAST>(loop->getCondition()),
+                                                     std::move(ctx.guarded));
+            hoisted.push_back(std::make_unique<StmtBlockItemAST>(std::move(guard)));
+        }
+        return true;
+    }
+
+    // ==================== 循环读写摘要 ====================
+
+    void analyzeStmt(StmtAST* stmt, LoopInfo& info) const {
+        if (!stmt) {
+            return;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            for (auto& item : block->getItems()) {
+                if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                    Scope declared;
+                    declareNames(declItem->getDecl(), declared, false);
+                    for (auto& entry : declared) {
+                        info.variantNames.insert(entry.first);
+                    }
+                    forEachDeclExpr(declItem->getDecl(), [&](ExprAST* e) { analyzeExpr(e, info); });
+                } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    analyzeStmt(stmtItem->getStmt(), info);
+                }
+            }
+        } else if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            auto lval = assignStmt->getLVal();
+            if (lval->getIndices().empty()) {
+                info.variantNames.insert(lval->getName());
+            } else {
+                info.writtenArrays.insert(lval->getName());
+                const VarInfo* var = lookupVar(lval->getName());
+                info.writesGlobalArray |= !var || var->isGlobal;
+                info.writesParamArray |= !var || var->isParam;
+            }
+            analyzeExpr(lval, info);
+            analyzeExpr(assignStmt->getExpr(), info);
+        } else if (auto exprStmt = dyn_cast<ExprStmtAST>(stmt)) {
+            analyzeExpr(exprStmt->getExpr(), info);
+        } else if (auto returnStmt = dyn_cast<ReturnStmtAST>(stmt)) {
+            analyzeExpr(returnStmt->getReturnValue(), info);
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            analyzeExpr(ifStmt->getCondition(), info);
+            analyzeStmt(ifStmt->getThenStmt(), info);
+            analyzeStmt(ifStmt->getElseStmt(), info);
+        } else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            analyzeExpr(whileStmt->getCondition(), info);
+            analyzeStmt(whileStmt->getBody(), info);
+        }
+    }
+
+    static void analyzeExpr(ExprAST* expr, LoopInfo& info) {
+        forEachExpr(expr, [&](ExprAST* e) {
+            if (dyn_cast<CallExprAST>(e)) {
+                info.hasCall = true;
+            }
+        });
+    }
+
+    static void forEachExpr(ExprAST* expr, const std::function<void(ExprAST*)>& fn) {
+        if (!expr) {
+            return;
+        }
+        fn(expr);
+        switch (expr->getNodeKind()) {
+            case ASTKind::BinaryExpr: {
+                auto binExpr = cast<BinaryExprAST>(expr);
+                forEachExpr(binExpr->getLHS(), fn);
+                forEachExpr(binExpr->getRHS(), fn);
+                break;
+            }
+            case ASTKind::UnaryExpr: {
+                auto unaryExpr = cast<UnaryExprAST>(expr);
+                forEachExpr(unaryExpr->getOperand(), fn);
+                break;
+            }
+            case ASTKind::CallExpr: {
+                auto callExpr = cast<CallExprAST>(expr);
+                for (auto& arg : callExpr->getArgs()) {
+                    forEachExpr(arg.get(), fn);
+                }
+                break;
+            }
+            case ASTKind::LValExpr: {
+                auto lval = cast<LValExprAST>(expr);
+                for (auto& idx : lval->getIndices()) {
+                    forEachExpr(idx.get(), fn);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    static void forEachInitExpr(InitValAST* initVal, const std::function<void(ExprAST*)>& fn) {
+        if (auto exprInit = dyn_cast<ExprInitValAST>(initVal)) {
+            forEachExpr(exprInit->getExpr(), fn);
+        } else if (auto listInit = dyn_cast<ListInitValAST>(initVal)) {
+            for (auto& val : listInit->getInitVals()) {
+                forEachInitExpr(val.get(), fn);
+            }
+        }
+    }
+
+    static void forEachDeclExpr(DeclAST* decl, const std::function<void(ExprAST*)>& fn) {
+        if (auto varDecl = dyn_cast<VarDeclAST>(decl)) {
+            for (auto& varDef : varDecl->getVarDefs()) {
+                forEachInitExpr(varDef->getInitVal(), fn);
+            }
+        } else if (auto constDecl = dyn_cast<ConstDeclAST>(decl)) {
+            for (auto& constDef : constDecl->getConstDefs()) {
+                forEachInitExpr(constDef->getInitVal(), fn);
+            }
+        }
+    }
+
+    static bool containsCall(ExprAST* expr) {
+        bool found = false;
+        forEachExpr(expr, [&](ExprAST* e) {
+            found |= dyn_cast<CallExprAST>(e) != nullptr;
+        });
+        return found;
+    }
+
+    // 语句执行后本轮剩余部分是否可能不再执行（跳转、调用或内层循环）
+    static bool mayLeaveIteration(StmtAST* stmt) {
+        if (!stmt) {
+            return false;
+        }
+        if (dyn_cast<BreakStmtAST>(stmt) || dyn_cast<ContinueStmtAST>(stmt) ||
+            dyn_cast<ReturnStmtAST>(stmt) || dyn_cast<WhileStmtAST>(stmt)) {
+            return true;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            for (auto& item : block->getItems()) {
+                if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    if (mayLeaveIteration(stmtItem->getStmt())) {
+                        return true;
+                    }
+                } else if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                    bool call = false;
+                    forEachDeclExpr(declItem->getDecl(), [&](ExprAST* e) {
+                        call |= dyn_cast<CallExprAST>(e) != nullptr;
+                    });
+                    if (call) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+        if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            return containsCall(assignStmt->getLVal()) || containsCall(assignStmt->getExpr());
+        }
+        if (auto exprStmt = dyn_cast<ExprStmtAST>(stmt)) {
+            return containsCall(exprStmt->getExpr());
+        }
+        if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            return containsCall(ifStmt->getCondition()) || mayLeaveIteration(ifStmt->getThenStmt()) ||
+                   mayLeaveIteration(ifStmt->getElseStmt());
+        }
+        return false;
+    }
+
+    // ==================== 不变量判断 ====================
+
+    bool isInvariant(ExprAST* expr, const LoopInfo& info) const {
+        if (dyn_cast<IntConstExprAST>(expr) || dyn_cast<FloatConstExprAST>(expr)) {
+            return true;
+        }
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            return isInvariant(binExpr->getLHS(), info) && isInvariant(binExpr->getRHS(), info);
+        }
+        if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            return isInvariant(unaryExpr->getOperand(), info);
+        }
+        auto lval = dyn_cast<LValExprAST>(expr);
+        if (!lval || info.variantNames.count(lval->getName())) {
+            return false;
+        }
+        const VarInfo* var = lookupVar(lval->getName());
+        if (!var || var->isVector || lval->getIndices().size() != var->dims) {
+            return false;
+        }
+        for (auto& idx : lval->getIndices()) {
+            if (!isInvariant(idx.get(), info)) {
+                return false;
+            }
+        }
+        if (var->isConst) {
+            return true;
+        }
+        if (var->dims == 0) {
+            // 局部标量只能被循环内的赋值修改；全局标量还可能被调用修改
+            return !(var->isGlobal && info.hasCall);
+        }
+        if (info.hasCall || info.writtenArrays.count(lval->getName())) {
+            return false;
+        }
+        // 数组形参可能指向任何全局数组或其他形参；不同的全局数组、局部数组互不别名
+        if (var->isParam) {
+            return !info.writesParamArray && !info.writesGlobalArray;
+        }
+        return !(var->isGlobal && info.writesParamArray);
+    }
+
+    // 只外提真正有计算的表达式；关系和逻辑运算的结果是 i1，留在原处
+    static bool worthHoisting(ExprAST* expr) {
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            return binExpr->getOp() <= BinaryExprAST::MOD;
+        }
+        if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            return unaryExpr->getOp() != UnaryExprAST::NOT && !unaryExpr->getOperand()->isConstant() &&
+                   worthHoisting(unaryExpr->getOperand());
+        }
+        if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            return !lval->getIndices().empty();
+        }
+        return false;
+    }
+
+    // 整数除法/取模（除数不是非零常量）和数组读取提前执行可能出错
+    static bool mayTrap(ExprAST* expr) {
+        bool trap = false;
+        forEachExpr(expr, [&](ExprAST* e) {
+            if (auto binExpr = dyn_cast<BinaryExprAST>(e)) {
+                if (binExpr->getOp() == BinaryExprAST::DIV || binExpr->getOp() == BinaryExprAST::MOD) {
+                    auto divisor = dyn_cast<IntConstExprAST>(binExpr->getRHS());
+                    auto floatDivisor = dyn_cast<FloatConstExprAST>(binExpr->getRHS());
+                    trap |= !floatDivisor && !(divisor && divisor->getValue() != 0);
+                }
+            } else if (auto lval = dyn_cast<LValExprAST>(e)) {
+                trap |= !lval->getIndices().empty();
+            }
+        });
+        return trap;
+    }
+
+    // 表达式类型：true 为 float
+    bool isFloatExpr(ExprAST* expr) const {
+        if (dyn_cast<FloatConstExprAST>(expr)) {
+            return true;
+        }
+        if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            const VarInfo* var = lookupVar(lval->getName());
+            return var && var->isFloat;
+        }
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            if (binExpr->getOp() > BinaryExprAST::MOD) {
+                return false;
+            }
+            return isFloatExpr(binExpr->getLHS()) || isFloatExpr(binExpr->getRHS());
+        }
+        if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            return unaryExpr->getOp() != UnaryExprAST::NOT && isFloatExpr(unaryExpr->getOperand());
+        }
+        return false;
+    }
+
+    // 结构相同的表达式共用一个临时变量
+    static std::string exprKey(ExprAST* expr) {
+        if (auto intConst = dyn_cast<IntConstExprAST>(expr)) {
+            return "i" + std::to_string(intConst->getValue());
+        }
+        if (auto floatConst = dyn_cast<FloatConstExprAST>(expr)) {
+            std::ostringstream os;
+            os << std::hexfloat << floatConst->getValue();
+            return "f" + os.str();
+        }
+        if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            std::string key = lval->getName();
+            for (auto& idx : lval->getIndices()) {
+                key += "[" + exprKey(idx.get()) + "]";
+            }
+            return key;
+        }
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            return "(" + exprKey(binExpr->getLHS()) + " " + std::to_string(binExpr->getOp()) + " " +
+                   exprKey(binExpr->getRHS()) + ")";
+        }
+        if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            return "(u" + std::to_string(unaryExpr->getOp()) + " " + exprKey(unaryExpr->getOperand()) + ")";
+        }
+        return "?";
+    }
+
+    // ==================== 外提 ====================
+
+    void hoistInStmt(StmtAST* stmt, bool always, HoistContext& ctx) {
+        if (!stmt) {
+            return;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            for (auto& item : block->getItems()) {
+                if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                    if (auto varDecl = dyn_cast<VarDeclAST>(declItem->getDecl())) {
+                        for (auto& varDef : varDecl->getVarDefs()) {
+                            auto exprInit = dyn_cast<ExprInitValAST>(varDef->getInitVal());
+                            if (exprInit && varDef->getArraySizes().empty()) {
+                                hoistInExpr(exprInit->getExpr(), [&](std::unique_ptr<ExprAST> e) {
+                                    exprInit->setExpr(std::move(e));
+                                }, always, ctx);
+                            }
                         }
                     }
+                    if (always) {
+                        bool call = false;
+                        forEachDeclExpr(declItem->getDecl(), [&](ExprAST* e) {
+                            call |= dyn_cast<CallExprAST>(e) != nullptr;
+                        });
+                        always = !call;
+                    }
+                } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    hoistInStmt(stmtItem->getStmt(), always, ctx);
+                    always = always && !mayLeaveIteration(stmtItem->getStmt());
                 }
-                // 处理循环
-                else if (auto whileStmt = dynamic_cast<WhileStmtAST*>(stmt)) {
-                    changed |= optimizeLoop(whileStmt);
+            }
+        } else if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            auto lval = assignStmt->getLVal();
+            for (size_t i = 0; i < lval->getIndices().size(); i++) {
+                hoistInExpr(lval->getIndices()[i].get(), [&](std::unique_ptr<ExprAST> e) {
+                    lval->setIndex(i, std::move(e));
+                }, always, ctx);
+            }
+            hoistInExpr(assignStmt->getExpr(), [&](std::unique_ptr<ExprAST> e) {
+                assignStmt->setExpr(std::move(e));
+            }, always, ctx);
+        } else if (auto exprStmt = dyn_cast<ExprStmtAST>(stmt)) {
+            hoistInExpr(exprStmt->getExpr(), [&](std::unique_ptr<ExprAST> e) {
+                exprStmt->setExpr(std::move(e));
+            }, always, ctx);
+        } else if (auto returnStmt = dyn_cast<ReturnStmtAST>(stmt)) {
+            hoistInExpr(returnStmt->getReturnValue(), [&](std::unique_ptr<ExprAST> e) {
+                returnStmt->setReturnValue(std::move(e));
+            }, always, ctx);
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            hoistInExpr(ifStmt->getCondition(), [&](std::unique_ptr<ExprAST> e) {
+                ifStmt->setCondition(std::move(e));
+            }, always, ctx);
+            hoistInStmt(ifStmt->getThenStmt(), false, ctx);
+            hoistInStmt(ifStmt->getElseStmt(), false, ctx);
+        } else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            hoistInExpr(whileStmt->getCondition(), [&](std::unique_ptr<ExprAST> e) {
+                whileStmt->setCondition(std::move(e));
+            }, always, ctx);
+            hoistInStmt(whileStmt->getBody(), false, ctx);
+        }
+    }
+
+    // 自顶向下寻找最大的不变子表达式，替换为临时变量
+    void hoistInExpr(ExprAST* expr, const std::function<void(std::unique_ptr<ExprAST>)>& setExpr,
+                     bool always, HoistContext& ctx) {
+        if (!expr) {
+            return;
+        }
+        if (worthHoisting(expr) && isInvariant(expr, ctx.info)) {
+            std::string key = exprKey(expr);
+            auto found = ctx.temps.find(key);
+            if (found != ctx.temps.end()) {
+                setExpr(std::make_unique<LValExprAST>(found->second, expr->getLineNumber()));
+                return;
+            }
+            bool trap = mayTrap(expr);
+            if (!trap || (always && (ctx.condAlwaysTrue || ctx.canGuard))) {
+                std::string name = "__licm_" + std::to_string(++tempCounter);
+                auto type = std::make_unique<TypeAST>(isFloatExpr(expr) ? TypeAST::Kind::FLOAT : TypeAST::Kind::INT);
+                auto decl = std::make_unique<VarDeclAST>(std::move(type));
+                auto def = std::make_unique<VarDefAST>(name);
+                if (trap && !ctx.condAlwaysTrue) {
+                    ctx.guarded->addItem(std::make_unique<StmtBlockItemAST>(std::make_unique<AssignStmtAST>(
+                        std::make_unique<LValExprAST>(name), cloneNode<ExprAST>(expr))));
+                } else {
+                    def->setInitVal(std::make_unique<ExprInitValAST>(cloneNode<ExprAST>(expr)));
                 }
+                decl->addVarDef(std::move(def));
+                ctx.decls.push_back(std::make_unique<DeclBlockItemAST>(std::move(decl)));
+                ctx.temps[key] = name;
+                setExpr(std::make_unique<LValExprAST>(name, expr->getLineNumber()));
+                return;
             }
         }
-        
+
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            bool shortCircuit = binExpr->getOp() == BinaryExprAST::AND || binExpr->getOp() == BinaryExprAST::OR;
+            hoistInExpr(binExpr->getLHS(), [&](std::unique_ptr<ExprAST> e) {
+                binExpr->setLHS(std::move(e));
+            }, always, ctx);
+            hoistInExpr(binExpr->getRHS(), [&](std::unique_ptr<ExprAST> e) {
+                binExpr->setRHS(std::move(e));
+            }, always && !shortCircuit, ctx);
+        } else if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            hoistInExpr(unaryExpr->getOperand(), [&](std::unique_ptr<ExprAST> e) {
+                unaryExpr->setOperand(std::move(e));
+            }, always, ctx);
+        } else if (auto callExpr = dyn_cast<CallExprAST>(expr)) {
+            for (size_t i = 0; i < callExpr->getArgs().size(); i++) {
+                hoistInExpr(callExpr->getArgs()[i].get(), [&](std::unique_ptr<ExprAST> e) {
+                    callExpr->setArg(i, std::move(e));
+                }, always, ctx);
+            }
+        } else if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            for (size_t i = 0; i < lval->getIndices().size(); i++) {
+                hoistInExpr(lval->getIndices()[i].get(), [&](std::unique_ptr<ExprAST> e) {
+                    lval->setIndex(i, std::move(e));
+                }, always, ctx);
+            }
+        }
+    }
+
+    // ==================== 循环展开 ====================
+
+    // 规范归纳变量循环：while (var op bound) { ...; var = var + step; }
+    struct InductionLoop {
+        std::string var;
+        BinaryExprAST::Operator op;
+        ExprAST* bound = nullptr;
+        int step = 0;
+    };
+
+    bool unrollInFunction(FunctionAST* func) {
+        enterFunction(func);
+        bool changed = unrollInBlock(func->getBody());
+        scopes.clear();
         return changed;
     }
-    
-    bool optimizeLoop(WhileStmtAST* loop) {
-        
-        
+
+    // 内层循环先展开
+    bool unrollInBlock(BlockAST* block) {
+        bool changed = false;
+        scopes.emplace_back();
+
+        auto& items = block->getMutableItems();
+        for (size_t i = 0; i < items.size(); i++) {
+            if (auto declItem = dyn_cast<DeclBlockItemAST>(items[i].get())) {
+                declareNames(declItem->getDecl(), scopes.back(), false);
+                continue;
+            }
+            auto stmtItem = dyn_cast<StmtBlockItemAST>(items[i].get());
+            if (!stmtItem) {
+                continue;
+            }
+            auto stmt = stmtItem->getStmt();
+
+            if (auto nestedBlock = dyn_cast<BlockAST>(stmt)) {
+                changed |= unrollInBlock(nestedBlock);
+            } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+                changed |= optimizeInBranch(ifStmt->getThenStmt(), [&](std::unique_ptr<StmtAST> s) {
+                    ifStmt->setThenStmt(std::move(s));
+                }, &LoopOptimizer::unrollInBlock);
+                changed |= optimizeInBranch(ifStmt->getElseStmt(), [&](std::unique_ptr<StmtAST> s) {
+                    ifStmt->setElseStmt(std::move(s));
+                }, &LoopOptimizer::unrollInBlock);
+            } else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+                changed |= optimizeInBranch(whileStmt->getBody(), [&](std::unique_ptr<StmtAST> s) {
+                    whileStmt->setBody(std::move(s));
+                }, &LoopOptimizer::unrollInBlock);
+
+                InductionLoop loop;
+                if (whileStmt->isNoUnroll() || !matchInductionLoop(whileStmt, loop)) {
+                    continue;
+                }
+                std::vector<std::unique_ptr<BlockItemAST>> unrolled;
+                if (fullyUnroll(whileStmt, loop, items, i, unrolled)) {
+                    // 用展开结果替换原循环
+                    items.erase(items.begin() + i);
+                    size_t count = unrolled.size();
+                    items.insert(items.begin() + i,
+                                 std::make_move_iterator(unrolled.begin()),
+                                 std::make_move_iterator(unrolled.end()));
+                    i = i + count - 1;
+                    changed = true;
+                } else if (auto mainLoop = partiallyUnroll(whileStmt, loop)) {
+                    // 主循环（可能带溢出保护）插在原循环之前，原循环处理剩余的迭代
+                    items.insert(items.begin() + i, std::make_unique<StmtBlockItemAST>(std::move(mainLoop)));
+                    i++;
+                    changed = true;
+                }
+            }
+        }
+
+        scopes.pop_back();
+        return changed;
+    }
+
+    bool matchInductionLoop(WhileStmtAST* whileStmt, InductionLoop& loop) const {
+        auto body = dyn_cast<BlockAST>(whileStmt->getBody());
+        if (!body || body->getItems().empty()) {
+            return false;
+        }
+
+        // 末尾语句：var = var + c / var = var - c / var = c + var
+        auto lastItem = dyn_cast<StmtBlockItemAST>(body->getItems().back().get());
+        auto increment = lastItem ? dyn_cast<AssignStmtAST>(lastItem->getStmt()) : nullptr;
+        if (!increment || !increment->getLVal()->getIndices().empty()) {
+            return false;
+        }
+        loop.var = increment->getLVal()->getName();
+        auto incExpr = dyn_cast<BinaryExprAST>(increment->getExpr());
+        if (!incExpr || (incExpr->getOp() != BinaryExprAST::ADD && incExpr->getOp() != BinaryExprAST::SUB)) {
+            return false;
+        }
+        auto stepConst = dyn_cast<IntConstExprAST>(incExpr->getRHS());
+        ExprAST* stepBase = incExpr->getLHS();
+        if (!stepConst && incExpr->getOp() == BinaryExprAST::ADD) {
+            stepConst = dyn_cast<IntConstExprAST>(incExpr->getLHS());
+            stepBase = incExpr->getRHS();
+        }
+        if (!stepConst || stepConst->getValue() == 0 || !isPlainVar(stepBase, loop.var)) {
+            return false;
+        }
+        loop.step = incExpr->getOp() == BinaryExprAST::ADD ? stepConst->getValue() : -stepConst->getValue();
+
+        // 条件：var op bound 或 bound op var
+        auto cond = dyn_cast<BinaryExprAST>(whileStmt->getCondition());
+        if (!cond) {
+            return false;
+        }
+        loop.op = cond->getOp();
+        if (loop.op != BinaryExprAST::LT && loop.op != BinaryExprAST::LE && loop.op != BinaryExprAST::GT &&
+            loop.op != BinaryExprAST::GE && loop.op != BinaryExprAST::NE) {
+            return false;
+        }
+        if (isPlainVar(cond->getLHS(), loop.var)) {
+            loop.bound = cond->getRHS();
+        } else if (isPlainVar(cond->getRHS(), loop.var)) {
+            loop.bound = cond->getLHS();
+            loop.op = swapComparison(loop.op);
+        } else {
+            return false;
+        }
+
+        // 归纳变量是局部 int 标量，循环内只在末尾修改一次
+        const VarInfo* var = lookupVar(loop.var);
+        if (!var || var->dims != 0 || var->isFloat || var->isVector || var->isGlobal || var->isConst) {
+            return false;
+        }
+        if (countAssignments(body, loop.var) != 1 || declaresName(body, loop.var)) {
+            return false;
+        }
+        LoopInfo info;
+        analyzeStmt(whileStmt, info);
+        if (!isInvariant(loop.bound, info) || isFloatExpr(loop.bound)) {
+            return false;
+        }
+        return !hasLoopLevel<ContinueStmtAST>(body);
+    }
+
+    static bool isPlainVar(ExprAST* expr, const std::string& name) {
+        auto lval = dyn_cast<LValExprAST>(expr);
+        return lval && lval->getName() == name && lval->getIndices().empty();
+    }
+
+    static BinaryExprAST::Operator swapComparison(BinaryExprAST::Operator op) {
+        switch (op) {
+            case BinaryExprAST::LT: return BinaryExprAST::GT;
+            case BinaryExprAST::GT: return BinaryExprAST::LT;
+            case BinaryExprAST::LE: return BinaryExprAST::GE;
+            case BinaryExprAST::GE: return BinaryExprAST::LE;
+            default: return op;
+        }
+    }
+
+    static int countAssignments(StmtAST* stmt, const std::string& name) {
+        if (!stmt) {
+            return 0;
+        }
+        if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            return assignStmt->getLVal()->getName() == name ? 1 : 0;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            int count = 0;
+            for (auto& item : block->getItems()) {
+                if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    count += countAssignments(stmtItem->getStmt(), name);
+                }
+            }
+            return count;
+        }
+        if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            return countAssignments(ifStmt->getThenStmt(), name) + countAssignments(ifStmt->getElseStmt(), name);
+        }
+        if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            return countAssignments(whileStmt->getBody(), name);
+        }
+        return 0;
+    }
+
+    static bool declaresName(StmtAST* stmt, const std::string& name) {
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            for (auto& item : block->getItems()) {
+                if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                    Scope declared;
+                    declareNames(declItem->getDecl(), declared, false);
+                    if (declared.count(name)) {
+                        return true;
+                    }
+                } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    if (declaresName(stmtItem->getStmt(), name)) {
+                        return true;
+                    }
+                }
+            }
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            return declaresName(ifStmt->getThenStmt(), name) || declaresName(ifStmt->getElseStmt(), name);
+        } else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            return declaresName(whileStmt->getBody(), name);
+        }
         return false;
     }
+
+    // 属于本层循环的 break/continue（不进入内层循环）
+    template <typename JumpStmt>
+    static bool hasLoopLevel(StmtAST* stmt) {
+        if (dyn_cast<JumpStmt>(stmt)) {
+            return true;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            for (auto& item : block->getItems()) {
+                auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get());
+                if (stmtItem && hasLoopLevel<JumpStmt>(stmtItem->getStmt())) {
+                    return true;
+                }
+            }
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            return hasLoopLevel<JumpStmt>(ifStmt->getThenStmt()) || hasLoopLevel<JumpStmt>(ifStmt->getElseStmt());
+        }
+        return false;
+    }
+
+    static int countNodes(StmtAST* stmt) {
+        int count = 0;
+        std::function<void(StmtAST*)> visit = [&](StmtAST* s) {
+            if (!s) {
+                return;
+            }
+            count++;
+            auto countExpr = [&](ExprAST* e) { forEachExpr(e, [&](ExprAST*) { count++; }); };
+            if (auto block = dyn_cast<BlockAST>(s)) {
+                for (auto& item : block->getItems()) {
+                    if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                        count++;
+                        forEachDeclExpr(declItem->getDecl(), [&](ExprAST*) { count++; });
+                    } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                        visit(stmtItem->getStmt());
+                    }
+                }
+            } else if (auto assignStmt = dyn_cast<AssignStmtAST>(s)) {
+                countExpr(assignStmt->getLVal());
+                countExpr(assignStmt->getExpr());
+            } else if (auto exprStmt = dyn_cast<ExprStmtAST>(s)) {
+                countExpr(exprStmt->getExpr());
+            } else if (auto returnStmt = dyn_cast<ReturnStmtAST>(s)) {
+                countExpr(returnStmt->getReturnValue());
+            } else if (auto ifStmt = dyn_cast<IfStmtAST>(s)) {
+                countExpr(ifStmt->getCondition());
+                visit(ifStmt->getThenStmt());
+                visit(ifStmt->getElseStmt());
+            } else if (auto whileStmt = dyn_cast<WhileStmtAST>(s)) {
+                countExpr(whileStmt->getCondition());
+                visit(whileStmt->getBody());
+            }
+        };
+        visit(stmt);
+        return count;
+    }
+
+    // 在循环之前的同块语句中寻找归纳变量的常量初值
+    static bool findConstantInit(const std::vector<std::unique_ptr<BlockItemAST>>& items, size_t loopIndex,
+                                 const std::string& name, int& init) {
+        for (size_t k = loopIndex; k-- > 0;) {
+            if (auto declItem = dyn_cast<DeclBlockItemAST>(items[k].get())) {
+                Scope declared;
+                declareNames(declItem->getDecl(), declared, false);
+                if (!declared.count(name)) {
+                    continue;
+                }
+                auto varDecl = dyn_cast<VarDeclAST>(declItem->getDecl());
+                if (!varDecl) {
+                    return false;
+                }
+                for (auto& varDef : varDecl->getVarDefs()) {
+                    if (varDef->getName() != name) {
+                        continue;
+                    }
+                    auto exprInit = dyn_cast<ExprInitValAST>(varDef->getInitVal());
+                    auto value = exprInit ? dyn_cast<IntConstExprAST>(exprInit->getExpr()) : nullptr;
+                    if (!value) {
+                        return false;
+                    }
+                    init = value->getValue();
+                    return true;
+                }
+                return false;
+            }
+            auto stmtItem = dyn_cast<StmtBlockItemAST>(items[k].get());
+            if (!stmtItem) {
+                continue;
+            }
+            if (auto assignStmt = dyn_cast<AssignStmtAST>(stmtItem->getStmt())) {
+                if (isPlainVar(assignStmt->getLVal(), name)) {
+                    auto value = dyn_cast<IntConstExprAST>(assignStmt->getExpr());
+                    if (!value) {
+                        return false;
+                    }
+                    init = value->getValue();
+                    return true;
+                }
+            }
+            if (countAssignments(stmtItem->getStmt(), name) > 0 || declaresName(stmtItem->getStmt(), name)) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // 常量初值与边界下的迭代次数，-1 表示无法确定或不终止
+    static long long tripCount(BinaryExprAST::Operator op, long long init, long long bound, long long step) {
+        switch (op) {
+            case BinaryExprAST::LT:
+                if (init >= bound) return 0;
+                return step > 0 ? (bound - init + step - 1) / step : -1;
+            case BinaryExprAST::LE:
+                if (init > bound) return 0;
+                return step > 0 ? (bound - init) / step + 1 : -1;
+            case BinaryExprAST::GT:
+                if (init <= bound) return 0;
+                return step < 0 ? (init - bound - step - 1) / -step : -1;
+            case BinaryExprAST::GE:
+                if (init < bound) return 0;
+                return step < 0 ? (init - bound) / -step + 1 : -1;
+            case BinaryExprAST::NE:
+                if ((bound - init) % step != 0 || (bound - init) / step < 0) return -1;
+                return (bound - init) / step;
+            default:
+                return -1;
+        }
+    }
+
+    // 在语句树的每个表达式位置自底向上应用替换（返回空表示保留原表达式）
+    using ExprRewriter = std::function<std::unique_ptr<ExprAST>(ExprAST*)>;
+
+    static void rewriteExpr(ExprAST* expr, const std::function<void(std::unique_ptr<ExprAST>)>& setExpr,
+                            const ExprRewriter& rewrite) {
+        if (!expr) {
+            return;
+        }
+        if (auto binExpr = dyn_cast<BinaryExprAST>(expr)) {
+            rewriteExpr(binExpr->getLHS(), [&](std::unique_ptr<ExprAST> e) { binExpr->setLHS(std::move(e)); }, rewrite);
+            rewriteExpr(binExpr->getRHS(), [&](std::unique_ptr<ExprAST> e) { binExpr->setRHS(std::move(e)); }, rewrite);
+        } else if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+            rewriteExpr(unaryExpr->getOperand(), [&](std::unique_ptr<ExprAST> e) {
+                unaryExpr->setOperand(std::move(e));
+            }, rewrite);
+        } else if (auto callExpr = dyn_cast<CallExprAST>(expr)) {
+            for (size_t i = 0; i < callExpr->getArgs().size(); i++) {
+                rewriteExpr(callExpr->getArgs()[i].get(), [&](std::unique_ptr<ExprAST> e) {
+                    callExpr->setArg(i, std::move(e));
+                }, rewrite);
+            }
+        } else if (auto lval = dyn_cast<LValExprAST>(expr)) {
+            rewriteIndices(lval, rewrite);
+        }
+        if (auto replacement = rewrite(expr)) {
+            setExpr(std::move(replacement));
+        }
+    }
+
+    static void rewriteIndices(LValExprAST* lval, const ExprRewriter& rewrite) {
+        for (size_t i = 0; i < lval->getIndices().size(); i++) {
+            rewriteExpr(lval->getIndices()[i].get(), [&](std::unique_ptr<ExprAST> e) {
+                lval->setIndex(i, std::move(e));
+            }, rewrite);
+        }
+    }
+
+    static void rewriteInitVal(InitValAST* initVal, const ExprRewriter& rewrite) {
+        if (auto exprInit = dyn_cast<ExprInitValAST>(initVal)) {
+            rewriteExpr(exprInit->getExpr(), [&](std::unique_ptr<ExprAST> e) {
+                exprInit->setExpr(std::move(e));
+            }, rewrite);
+        } else if (auto listInit = dyn_cast<ListInitValAST>(initVal)) {
+            for (auto& val : listInit->getInitVals()) {
+                rewriteInitVal(val.get(), rewrite);
+            }
+        }
+    }
+
+    static void rewriteStmt(StmtAST* stmt, const ExprRewriter& rewrite) {
+        if (!stmt) {
+            return;
+        }
+        if (auto block = dyn_cast<BlockAST>(stmt)) {
+            for (auto& item : block->getItems()) {
+                if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
+                    if (auto varDecl = dyn_cast<VarDeclAST>(declItem->getDecl())) {
+                        for (auto& varDef : varDecl->getVarDefs()) {
+                            rewriteInitVal(varDef->getInitVal(), rewrite);
+                        }
+                    }
+                } else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
+                    rewriteStmt(stmtItem->getStmt(), rewrite);
+                }
+            }
+        } else if (auto assignStmt = dyn_cast<AssignStmtAST>(stmt)) {
+            rewriteIndices(assignStmt->getLVal(), rewrite);
+            rewriteExpr(assignStmt->getExpr(), [&](std::unique_ptr<ExprAST> e) {
+                assignStmt->setExpr(std::move(e));
+            }, rewrite);
+        } else if (auto exprStmt = dyn_cast<ExprStmtAST>(stmt)) {
+            rewriteExpr(exprStmt->getExpr(), [&](std::unique_ptr<ExprAST> e) {
+                exprStmt->setExpr(std::move(e));
+            }, rewrite);
+        } else if (auto returnStmt = dyn_cast<ReturnStmtAST>(stmt)) {
+            rewriteExpr(returnStmt->getReturnValue(), [&](std::unique_ptr<ExprAST> e) {
+                returnStmt->setReturnValue(std::move(e));
+            }, rewrite);
+        } else if (auto ifStmt = dyn_cast<IfStmtAST>(stmt)) {
+            rewriteExpr(ifStmt->getCondition(), [&](std::unique_ptr<ExprAST> e) {
+                ifStmt->setCondition(std::move(e));
+            }, rewrite);
+            rewriteStmt(ifStmt->getThenStmt(), rewrite);
+            rewriteStmt(ifStmt->getElseStmt(), rewrite);
+        } else if (auto whileStmt = dyn_cast<WhileStmtAST>(stmt)) {
+            rewriteExpr(whileStmt->getCondition(), [&](std::unique_ptr<ExprAST> e) {
+                whileStmt->setCondition(std::move(e));
+            }, rewrite);
+            rewriteStmt(whileStmt->getBody(), rewrite);
+        }
+    }
+
+    static std::unique_ptr<StmtBlockItemAST> makeAssign(const std::string& name, long long value) {
+        return std::make_unique<StmtBlockItemAST>(std::make_unique<AssignStmtAST>(
+            std::make_unique<LValExprAST>(name), std::make_unique<IntConstExprAST>(static_cast<int>(value))));
+    }
+
+    // 完全展开：第 k 份循环体中归纳变量替换为 init + k * step
+    bool fullyUnroll(WhileStmtAST* whileStmt, const InductionLoop& loop,
+                     const std::vector<std::unique_ptr<BlockItemAST>>& items, size_t loopIndex,
+                     std::vector<std::unique_ptr<BlockItemAST>>& unrolled) const {
+        auto boundConst = dyn_cast<IntConstExprAST>(loop.bound);
+        int init = 0;
+        if (!boundConst || !findConstantInit(items, loopIndex, loop.var, init)) {
+            return false;
+        }
+        long long trips = tripCount(loop.op, init, boundConst->getValue(), loop.step);
+        if (trips < 0 || trips > kFullUnrollMaxTrips) {
+            return false;
+        }
+        auto body = static_cast<BlockAST*>(whileStmt->getBody());
+        if (trips * countNodes(body) > kFullUnrollMaxNodes) {
+            return false;
+        }
+
+        // 有 break 时每份之后写回归纳变量，并包在 while (1) 中让 break 跳出全部副本
+        bool hasBreak = hasLoopLevel<BreakStmtAST>(body);
+        std::vector<std::unique_ptr<BlockItemAST>> copies;
+        for (long long k = 0; k < trips; k++) {
+            long long value = init + k * loop.step;
+            auto copy = cloneNode<BlockAST>(body);
+            copy->getMutableItems().pop_back();
+            rewriteStmt(copy.get(), [&](ExprAST* e) -> std::unique_ptr<ExprAST> {
+                if (isPlainVar(e, loop.var)) {
+                    return std::make_unique<IntConstExprAST>(static_cast<int>(value), e->getLineNumber());
+                }
+                return nullptr;
+            });
+            if (hasBreak) {
+                copy->addItem(makeAssign(loop.var, value + loop.step));
+            }
+            copies.push_back(std::make_unique<StmtBlockItemAST>(std::move(copy)));
+        }
+
+        if (!hasBreak) {
+            unrolled = std::move(copies);
+            if (trips > 0) {
+                unrolled.push_back(makeAssign(loop.var, init + trips * loop.step));
+            }
+            return true;
+        }
+        auto wrapperBody = std::make_unique<BlockAST>();
+        for (auto& copy : copies) {
+            wrapperBody->addItem(std::move(copy));
+        }
+        wrapperBody->addItem(std::make_unique<StmtBlockItemAST>(std::make_unique<BreakStmtAST>()));
+        auto wrapper = std::make_unique<WhileStmtAST>(std::make_unique<IntConstExprAST>(1), std::move(wrapperBody));
+        wrapper->setNoUnroll(true);
+        unrolled.push_back(std::make_unique<StmtBlockItemAST>(std::move(wrapper)));
+        return true;
+    }
+
+    // 部分展开：while (var op bound - (factor-1)*step) { body x factor }，原循环作为余数循环。
+    // 边界不是常量时主循环包在 if (bound >= INT_MIN + offset)（递减时 bound <= INT_MAX - offset）中，
+    // 边界调整会溢出时跳过主循环，全部迭代由余数循环执行
+    std::unique_ptr<StmtAST> partiallyUnroll(WhileStmtAST* whileStmt, const InductionLoop& loop) const {
+        if (unrollFactor < 2) {
+            return nullptr;
+        }
+        bool ascending = (loop.op == BinaryExprAST::LT || loop.op == BinaryExprAST::LE) && loop.step > 0;
+        bool descending = (loop.op == BinaryExprAST::GT || loop.op == BinaryExprAST::GE) && loop.step < 0;
+        auto body = static_cast<BlockAST*>(whileStmt->getBody());
+        if ((!ascending && !descending) || hasLoopLevel<BreakStmtAST>(body) ||
+            countNodes(body) * unrollFactor > kPartialUnrollMaxNodes) {
+            return nullptr;
+        }
+        long long offset = 1LL * (unrollFactor - 1) * (loop.step < 0 ? -loop.step : loop.step);
+        if (offset > INT32_MAX) {
+            return nullptr;
+        }
+        // 常量边界调整后会溢出时不展开
+        if (auto boundConst = dyn_cast<IntConstExprAST>(loop.bound)) {
+            long long adjustedBound = ascending ? boundConst->getValue() - offset : boundConst->getValue() + offset;
+            if (adjustedBound < INT32_MIN || adjustedBound > INT32_MAX) {
+                return nullptr;
+            }
+        }
+
+        auto adjusted = std::make_unique<BinaryExprAST>(ascending ? BinaryExprAST::SUB : BinaryExprAST::ADD,
+                                                        cloneNode<ExprAST>(loop.bound),
+                                                        std::make_unique<IntConstExprAST>(static_cast<int>(offset)));
+        auto cond = std::make_unique<BinaryExprAST>(loop.op, std::make_unique<LValExprAST>(loop.var),
+                                                    std::move(adjusted));
+        auto mainBody = std::make_unique<BlockAST>();
+        for (int k = 0; k < unrollFactor; k++) {
+            mainBody->addItem(std::make_unique<StmtBlockItemAST>(cloneNode<StmtAST>(body)));
+        }
+        auto mainLoop = std::make_unique<WhileStmtAST>(std::move(cond), std::move(mainBody));
+        mainLoop->setNoUnroll(true);
+        whileStmt->setNoUnroll(true);
+        if (dyn_cast<IntConstExprAST>(loop.bound)) {
+            return mainLoop;
+        }
+        long long limit = ascending ? INT32_MIN + offset : INT32_MAX - offset;
+        auto guard = std::make_unique<BinaryExprAST>(ascending ? BinaryExprAST::GE : BinaryExprAST::LE,
+                                                     cloneNode<ExprAST>(loop.bound),
+                                                     std::make_unique<IntConstExprAST>(static_cast<int>(limit)));
+        return std::make_unique<IfStmtAST>(std::move(guard), std::move(mainLoop));
+    }
 };
 
-#endif // LOOP_OPTIMIZATION_H
\ No newline at end of file
+#endif // LOOP_OPTIMIZATION_H
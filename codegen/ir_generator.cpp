@@ -1,6 +1,7 @@
 #include "ir_generator.h"
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/Support/raw_ostream.h>
 #include <stdexcept>
 #include <iostream>
@@ -10,44 +11,252 @@ IRGenerator::IRGenerator() : builder(context), currentFunction(nullptr) {
     // 构造函数中初始化 IRBuilder
 }
 
+// 清空符号表
+void IRGenerator::resetScopes() {
+    symbolBindings.clear();
+    scopeUndoLog.clear();
+    scopeMarks.clear();
+}
+
 // 进入新作用域
 void IRGenerator::pushScope() {
-    symbolTableStack.push_back(std::map<std::string, SymbolInfo>());
+    scopeMarks.push_back(scopeUndoLog.size());
 }
 
-// 退出当前作用域
+// 退出当前作用域：恢复本层绑定遮蔽掉的外层绑定
 void IRGenerator::popScope() {
-    if (symbolTableStack.empty()) {
+    if (scopeMarks.empty()) {
         throw std::runtime_error("Cannot pop scope: stack is empty");
     }
-    symbolTableStack.pop_back();
+    size_t mark = scopeMarks.back();
+    while (scopeUndoLog.size() > mark) {
+        ShadowedBinding& entry = scopeUndoLog.back();
+        symbolBindings[entry.id] = entry.previous;
+        scopeUndoLog.pop_back();
+    }
+    scopeMarks.pop_back();
 }
 
-// 查找符号（从内到外查找）
-std::optional<IRGenerator::SymbolInfo> IRGenerator::lookupSymbol(const std::string& name) {
-    // 从最内层作用域开始查找
-    
-    for (auto it = symbolTableStack.rbegin(); it != symbolTableStack.rend(); ++it) {
-        auto found = it->find(name);
-        if (found != it->end()) {
-            return found->second;  // 返回副本
-        }
+// 查找符号：直接取该标识符当前可见的绑定
+std::optional<IRGenerator::SymbolInfo> IRGenerator::lookupSymbol(Identifier name) const {
+    unsigned id = name->getID();
+    if (id < symbolBindings.size() && symbolBindings[id].depth >= 0) {
+        return symbolBindings[id].info;  // 返回副本
     }
     return std::nullopt;  // 未找到
 }
 
 // 在当前作用域添加符号
-void IRGenerator::addSymbol(const std::string& name, const SymbolInfo& info) {
-    if (symbolTableStack.empty()) {
+void IRGenerator::addSymbol(Identifier name, const SymbolInfo& info) {
+    if (scopeMarks.empty()) {
         throw std::runtime_error("Cannot add symbol: no scope available");
     }
+    unsigned id = name->getID();
+    if (id >= symbolBindings.size()) {
+        symbolBindings.resize(id + 1);
+    }
     // 检查当前作用域是否已存在同名符号
-    auto& currentScope = symbolTableStack.back();
-    if (currentScope.find(name) != currentScope.end()) {
-        throw std::runtime_error("Redeclaration of symbol '" + name + "'");
+    SymbolBinding& binding = symbolBindings[id];
+    int depth = static_cast<int>(scopeMarks.size());
+    if (binding.depth == depth) {
+        throw std::runtime_error("Redeclaration of symbol '" + name->getName() + "'");
+    }
+    // 记录被遮蔽的绑定（可能是未绑定），再绑定到最内层作用域
+    scopeUndoLog.push_back({id, binding});
+    binding.info = info;
+    binding.depth = depth;
+}
+
+// 获取符号存储的逻辑类型（栈槽/全局变量的值类型；稀疏全局数组使用登记的数组类型）
+llvm::Type* IRGenerator::getStorageType(const SymbolInfo& info) {
+    if (info.valueType) {
+        return info.valueType;
+    }
+    if (auto allocaInst = llvm::dyn_cast_or_null<llvm::AllocaInst>(info.value)) {
+        return allocaInst->getAllocatedType();
+    }
+    if (auto globalVar = llvm::dyn_cast_or_null<llvm::GlobalVariable>(info.value)) {
+        return globalVar->getValueType();
+    }
+    return nullptr;
+}
+
+// 在入口块分配栈槽（插在占位指令之前，保持所有 alloca 连续位于入口块开头）
+llvm::AllocaInst* IRGenerator::createEntryBlockAlloca(llvm::Type* type, const std::string& name) {
+    if (!allocaInsertPoint) {
+        throw std::runtime_error("Alloca requested outside of a function");
+    }
+    llvm::IRBuilder<> entryBuilder(allocaInsertPoint);
+    return entryBuilder.CreateAlloca(type, nullptr, name);
+}
+
+// 获取一个临时槽：优先复用同类型的空闲槽，槽在所属语句结束后归还
+llvm::AllocaInst* IRGenerator::acquireScratchSlot(llvm::Type* type, const std::string& name) {
+    llvm::AllocaInst* slot = nullptr;
+    auto& pool = freeScratchSlots[type];
+    if (!pool.empty()) {
+        slot = pool.back();
+        pool.pop_back();
+    } else {
+        slot = createEntryBlockAlloca(type, name);
+    }
+    usedScratchSlots.push_back(slot);
+    return slot;
+}
+
+// 归还 mark 之后占用的临时槽
+void IRGenerator::releaseScratchSlots(size_t mark) {
+    while (usedScratchSlots.size() > mark) {
+        llvm::AllocaInst* slot = usedScratchSlots.back();
+        usedScratchSlots.pop_back();
+        freeScratchSlots[slot->getAllocatedType()].push_back(slot);
+    }
+}
+
+// 直接 SSA 模式只处理 int/float 标量（SysY 中标量无法取地址）
+bool IRGenerator::isSSACandidate(llvm::Type* type) const {
+    return directSSA && (type->isIntegerTy(32) || type->isFloatTy());
+}
+
+// 登记一个 SSA 变量，返回其编号
+int IRGenerator::createSSAVariable(llvm::Type* type, const std::string& name) {
+    ssaVariables.push_back(SSAVariable{type, name});
+    return static_cast<int>(ssaVariables.size()) - 1;
+}
+
+// 记录变量在基本块中的当前定义
+void IRGenerator::writeVariable(int var, llvm::BasicBlock* block, llvm::Value* value) {
+    ssaCurrentDef[block][var] = value;
+}
+
+// 读取变量在基本块末尾的值：块内有定义直接返回，否则沿前驱查找
+llvm::Value* IRGenerator::readVariable(int var, llvm::BasicBlock* block) {
+    auto blockIt = ssaCurrentDef.find(block);
+    if (blockIt != ssaCurrentDef.end()) {
+        auto defIt = blockIt->second.find(var);
+        if (defIt != blockIt->second.end() && defIt->second) {
+            return defIt->second;
+        }
+    }
+    return readVariableRecursive(var, block);
+}
+
+llvm::Value* IRGenerator::readVariableRecursive(int var, llvm::BasicBlock* block) {
+    const SSAVariable& variable = ssaVariables[var];
+    auto createPhi = [&]() {
+        // PHI 必须位于块首，插在第一条非 PHI 指令之前
+        std::string phiName = variable.name + ".phi";
+        if (llvm::Instruction* first = block->getFirstNonPHI()) {
+            return llvm::PHINode::Create(variable.type, 0, phiName, first);
+        }
+        return llvm::PHINode::Create(variable.type, 0, phiName, block);
+    };
+
+    llvm::Value* value = nullptr;
+    if (!ssaSealedBlocks.count(block)) {
+        // 前驱尚不完整：先放一个空 PHI，封闭时再补操作数
+        llvm::PHINode* phi = createPhi();
+        ssaIncompletePhis[block][var] = phi;
+        value = phi;
+    } else if (llvm::BasicBlock* pred = block->getSinglePredecessor()) {
+        // 唯一前驱无需 PHI
+        value = readVariable(var, pred);
+    } else if (llvm::pred_empty(block)) {
+        // 入口块或不可达块中未定义的变量
+        value = llvm::UndefValue::get(variable.type);
+    } else {
+        // 先记录 PHI 打断循环中的递归查找
+        llvm::PHINode* phi = createPhi();
+        writeVariable(var, block, phi);
+        value = addPhiOperands(var, phi);
+    }
+    writeVariable(var, block, value);
+    return value;
+}
+
+// 为 PHI 补充每条前驱边上的操作数
+llvm::Value* IRGenerator::addPhiOperands(int var, llvm::PHINode* phi) {
+    for (llvm::BasicBlock* pred : llvm::predecessors(phi->getParent())) {
+        phi->addIncoming(readVariable(var, pred), pred);
     }
-    // 添加到最内层作用域
-    symbolTableStack.back()[name] = info;
+    return tryRemoveTrivialPhi(phi);
+}
+
+// 所有操作数都相同（或指向自身）的 PHI 是平凡的，用该操作数替换
+llvm::Value* IRGenerator::tryRemoveTrivialPhi(llvm::PHINode* phi) {
+    llvm::Value* same = nullptr;
+    for (llvm::Value* op : phi->incoming_values()) {
+        if (op == same || op == phi) {
+            continue;
+        }
+        if (same) {
+            return phi;
+        }
+        same = op;
+    }
+    if (!same) {
+        same = llvm::UndefValue::get(phi->getType());
+    }
+
+    // 替换后使用该 PHI 的其他 PHI 可能也变为平凡的
+    std::vector<llvm::WeakTrackingVH> phiUsers;
+    for (llvm::User* user : phi->users()) {
+        if (user != phi && llvm::isa<llvm::PHINode>(user)) {
+            phiUsers.emplace_back(user);
+        }
+    }
+    // 当前定义表中的句柄会随 RAUW 一起更新
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+
+    llvm::WeakTrackingVH result(same);
+    for (auto& user : phiUsers) {
+        if (auto userPhi = llvm::dyn_cast_or_null<llvm::PHINode>(user)) {
+            tryRemoveTrivialPhi(userPhi);
+        }
+    }
+    return result;
+}
+
+// 封闭基本块：其前驱已全部生成，补全块中未完成的 PHI
+void IRGenerator::sealBlock(llvm::BasicBlock* block) {
+    if (!directSSA) {
+        return;
+    }
+    ssaSealedBlocks.insert(block);
+    auto it = ssaIncompletePhis.find(block);
+    if (it == ssaIncompletePhis.end()) {
+        return;
+    }
+    auto pending = std::move(it->second);
+    ssaIncompletePhis.erase(it);
+    for (auto& [var, phi] : pending) {
+        addPhiOperands(var, phi);
+    }
+}
+
+// 函数生成结束后清空 SSA 构造状态
+void IRGenerator::resetSSAState() {
+    if (!ssaIncompletePhis.empty()) {
+        throw std::runtime_error("Unsealed block left after SSA construction");
+    }
+    ssaVariables.clear();
+    ssaCurrentDef.clear();
+    ssaSealedBlocks.clear();
+}
+
+// 标量 int/float 之间的隐式转换
+llvm::Value* IRGenerator::convertScalar(llvm::Value* value, llvm::Type* type) {
+    if (value->getType() == type) {
+        return value;
+    }
+    if (type->isIntegerTy() && value->getType()->isFloatTy()) {
+        return builder.CreateFPToSI(value, type, "fptosi");
+    }
+    if (type->isFloatTy() && value->getType()->isIntegerTy()) {
+        return builder.CreateSIToFP(value, type, "sitofp");
+    }
+    throw std::runtime_error("Type mismatch in scalar assignment");
 }
 
 // 将 AST 类型转换为 LLVM 类型
@@ -96,96 +305,107 @@ int IRGenerator::evaluateConstExpr(ExprAST* expr) {
         throw std::runtime_error("Expression is null");
     }
 
-    // 处理整数字面量
-    if (auto intExpr = dynamic_cast<IntConstExprAST*>(expr)) {
-        // 检查是否是非负整数
-        if (intExpr->getValue() < 0) {
-            throw std::runtime_error("Array size must be non-negative");
-        }
-        return intExpr->getValue();
-    }
-
-    // 处理左值表达式（必须是常量）
-    if (auto lvalExpr = dynamic_cast<LValExprAST*>(expr)) {
-        // 查找变量
-        const std::string& varName = lvalExpr->getName();
-        auto symOpt = lookupSymbol(varName);
-        if (!symOpt) {
-            throw std::runtime_error("Variable '" + varName + "' not defined");
+    switch (expr->getNodeKind()) {
+        // 处理整数字面量
+        case ASTKind::IntConstExpr: {
+            auto intExpr = cast<IntConstExprAST>(expr);
+            // 检查是否是非负整数
+            if (intExpr->getValue() < 0) {
+                throw std::runtime_error("Array size must be non-negative");
+            }
+            return intExpr->getValue();
         }
-
-        // 检查是否是常量
-        llvm::Value* varPtr = symOpt.value().value;
-        if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(varPtr)) {
-            // 全局常量
-            if (!globalVar->isConstant()) {
-                throw std::runtime_error("Array size must be a constant");
+        
+        // 处理左值表达式（必须是常量）
+        case ASTKind::LValExpr: {
+            auto lvalExpr = cast<LValExprAST>(expr);
+            // 查找变量
+            const std::string& varName = lvalExpr->getName();
+            auto symOpt = lookupSymbol(lvalExpr->getIdentifier());
+            if (!symOpt) {
+                throw std::runtime_error("Variable '" + varName + "' not defined");
             }
 
-            // 获取初始值
-            llvm::Constant* initValue = globalVar->getInitializer();
-            if (!initValue) {
-                throw std::runtime_error("Array size must be a constant with value");
-            }
+            // 检查是否是常量
+            llvm::Value* varPtr = symOpt.value().value;
+            if (auto globalVar = llvm::dyn_cast_or_null<llvm::GlobalVariable>(varPtr)) {
+                // 全局常量
+                if (!globalVar->isConstant()) {
+                    throw std::runtime_error("Array size must be a constant");
+                }
 
-            // 检查是否是非负整数
-            if (auto intConst = llvm::dyn_cast<llvm::ConstantInt>(initValue)) {
-                if (intConst->getSExtValue() < 0) {
-                    throw std::runtime_error("Array size must be non-negative");
+                // 获取初始值
+                llvm::Constant* initValue = globalVar->getInitializer();
+                if (!initValue) {
+                    throw std::runtime_error("Array size must be a constant with value");
+                }
+
+                // 检查是否是非负整数
+                if (auto intConst = llvm::dyn_cast<llvm::ConstantInt>(initValue)) {
+                    if (intConst->getSExtValue() < 0) {
+                        throw std::runtime_error("Array size must be non-negative");
+                    }
+                    return intConst->getSExtValue();
+                } else {
+                    throw std::runtime_error("Array size must be an integer constant");
                 }
-                return intConst->getSExtValue();
             } else {
-                throw std::runtime_error("Array size must be an integer constant");
+                // 局部变量不能作为数组大小
+                throw std::runtime_error("Array size must be a constant");
             }
-        } else {
-            // 局部变量不能作为数组大小
-            throw std::runtime_error("Array size must be a constant");
-        }
-    }
-
-    // 处理二元运算表达式
-    if (auto binaryExpr = dynamic_cast<BinaryExprAST*>(expr)) {
-        // 递归求值左右操作数
-        int lhs = evaluateConstExpr(binaryExpr->getLHS());
-        int rhs = evaluateConstExpr(binaryExpr->getRHS());
-
-        // 根据运算符进行计算
-        switch (binaryExpr->getOp()) {
-            case BinaryExprAST::ADD:
-                return lhs + rhs;
-            case BinaryExprAST::SUB:
-                return lhs - rhs;
-            case BinaryExprAST::MUL:
-                return lhs * rhs;
-            case BinaryExprAST::DIV:
-                if (rhs == 0) {
-                    throw std::runtime_error("Division by zero in constant expression");
-                }
-                return lhs / rhs;
-            case BinaryExprAST::MOD:
-                if (rhs == 0) {
-                    throw std::runtime_error("Modulo by zero in constant expression");
-                }
-                return lhs % rhs;
-            default:
-                throw std::runtime_error("Unsupported operator in constant expression");
+            break;
         }
-    }
-
-    // 处理一元运算表达式
-    if (auto unaryExpr = dynamic_cast<UnaryExprAST*>(expr)) {
-        // 递归求值操作数
-        int operand = evaluateConstExpr(unaryExpr->getOperand());
-
-        // 根据运算符进行计算
-        switch (unaryExpr->getOp()) {
-            case UnaryExprAST::PLUS:
-                return operand;
-            case UnaryExprAST::MINUS:
-                return -operand;
-            default:
-                throw std::runtime_error("Unsupported unary operator in constant expression");
+        
+        // 处理二元运算表达式
+        case ASTKind::BinaryExpr: {
+            auto binaryExpr = cast<BinaryExprAST>(expr);
+            // 递归求值左右操作数
+            int lhs = evaluateConstExpr(binaryExpr->getLHS());
+            int rhs = evaluateConstExpr(binaryExpr->getRHS());
+
+            // 根据运算符进行计算
+            switch (binaryExpr->getOp()) {
+                case BinaryExprAST::ADD:
+                    return lhs + rhs;
+                case BinaryExprAST::SUB:
+                    return lhs - rhs;
+                case BinaryExprAST::MUL:
+                    return lhs * rhs;
+                case BinaryExprAST::DIV:
+                    if (rhs == 0) {
+                        throw std::runtime_error("Division by zero in constant expression");
+                    }
+                    return lhs / rhs;
+                case BinaryExprAST::MOD:
+                    if (rhs == 0) {
+                        throw std::runtime_error("Modulo by zero in constant expression");
+                    }
+                    return lhs % rhs;
+                default:
+                    throw std::runtime_error("Unsupported operator in constant expression");
+            }
+            break;
+        }
+        
+        // 处理一元运算表达式
+        case ASTKind::UnaryExpr: {
+            auto unaryExpr = cast<UnaryExprAST>(expr);
+            // 递归求值操作数
+            int operand = evaluateConstExpr(unaryExpr->getOperand());
+
+            // 根据运算符进行计算
+            switch (unaryExpr->getOp()) {
+                case UnaryExprAST::PLUS:
+                    return operand;
+                case UnaryExprAST::MINUS:
+                    return -operand;
+                default:
+                    throw std::runtime_error("Unsupported unary operator in constant expression");
+            }
+            break;
         }
+        default:
+            break;
     }
 
     throw std::runtime_error("Array size must be a constant integer expression");
@@ -197,81 +417,93 @@ llvm::Value* IRGenerator::generateExprForArraySize(ExprAST* expr) {
         throw std::runtime_error("Expression is null");
     }
 
-    // 处理整数字面量
-    if (auto intExpr = dynamic_cast<IntConstExprAST*>(expr)) {
-        // 检查是否是非负整数
-        if (intExpr->getValue() < 0) {
-            throw std::runtime_error("Array size must be non-negative");
-        }
-
-        // 创建 32 位整数常量
-        return llvm::ConstantInt::get(
-            llvm::Type::getInt32Ty(context),
-            intExpr->getValue(),
-            true  // 有符号
-        );
-    }
+    switch (expr->getNodeKind()) {
+        // 处理整数字面量
+        case ASTKind::IntConstExpr: {
+            auto intExpr = cast<IntConstExprAST>(expr);
+            // 检查是否是非负整数
+            if (intExpr->getValue() < 0) {
+                throw std::runtime_error("Array size must be non-negative");
+            }
 
-    // 处理左值表达式（必须是常量）
-    if (auto lvalExpr = dynamic_cast<LValExprAST*>(expr)) {
-        // 查找变量
-        const std::string& varName = lvalExpr->getName();
-        auto symOpt = lookupSymbol(varName);
-        if (!symOpt) {
-            throw std::runtime_error("Variable '" + varName + "' not defined");
+            // 创建 32 位整数常量
+            return llvm::ConstantInt::get(
+                llvm::Type::getInt32Ty(context),
+                intExpr->getValue(),
+                true  // 有符号
+            );
+            break;
         }
-
-        // 检查是否是常量
-        llvm::Value* varPtr = symOpt.value().value;
-        if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(varPtr)) {
-            // 全局常量
-            if (!globalVar->isConstant()) {
-                throw std::runtime_error("Array size must be a constant");
+        
+        // 处理左值表达式（必须是常量）
+        case ASTKind::LValExpr: {
+            auto lvalExpr = cast<LValExprAST>(expr);
+            // 查找变量
+            const std::string& varName = lvalExpr->getName();
+            auto symOpt = lookupSymbol(lvalExpr->getIdentifier());
+            if (!symOpt) {
+                throw std::runtime_error("Variable '" + varName + "' not defined");
             }
 
-            // 获取初始值
-            llvm::Constant* initValue = globalVar->getInitializer();
-            if (!initValue) {
-                throw std::runtime_error("Array size must be a constant with value");
-            }
+            // 检查是否是常量
+            llvm::Value* varPtr = symOpt.value().value;
+            if (auto globalVar = llvm::dyn_cast_or_null<llvm::GlobalVariable>(varPtr)) {
+                // 全局常量
+                if (!globalVar->isConstant()) {
+                    throw std::runtime_error("Array size must be a constant");
+                }
 
-            // 检查是否是非负整数
-            if (auto intConst = llvm::dyn_cast<llvm::ConstantInt>(initValue)) {
-                if (intConst->getSExtValue() < 0) {
-                    throw std::runtime_error("Array size must be non-negative");
+                // 获取初始值
+                llvm::Constant* initValue = globalVar->getInitializer();
+                if (!initValue) {
+                    throw std::runtime_error("Array size must be a constant with value");
+                }
+
+                // 检查是否是非负整数
+                if (auto intConst = llvm::dyn_cast<llvm::ConstantInt>(initValue)) {
+                    if (intConst->getSExtValue() < 0) {
+                        throw std::runtime_error("Array size must be non-negative");
+                    }
+                    return intConst;
+                } else {
+                    throw std::runtime_error("Array size must be an integer constant");
                 }
-                return intConst;
             } else {
-                throw std::runtime_error("Array size must be an integer constant");
+                // 局部变量不能作为数组大小
+                throw std::runtime_error("Array size must be a constant");
             }
-        } else {
-            // 局部变量不能作为数组大小
-            throw std::runtime_error("Array size must be a constant");
+            break;
         }
-    }
-
-    // 处理二元运算表达式（必须是常量表达式）
-    if (auto binaryExpr = dynamic_cast<BinaryExprAST*>(expr)) {
-        // 使用 evaluateConstExpr 在编译时计算常量值
-        int value = evaluateConstExpr(binaryExpr);
-        // 创建 32 位整数常量
-        return llvm::ConstantInt::get(
-            llvm::Type::getInt32Ty(context),
-            value,
-            true  // 有符号
-        );
-    }
-
-    // 处理一元运算表达式（必须是常量表达式）
-    if (auto unaryExpr = dynamic_cast<UnaryExprAST*>(expr)) {
-        // 使用 evaluateConstExpr 在编译时计算常量值
-        int value = evaluateConstExpr(unaryExpr);
-        // 创建 32 位整数常量
-        return llvm::ConstantInt::get(
-            llvm::Type::getInt32Ty(context),
-            value,
-            true  // 有符号
-        );
+        
+        // 处理二元运算表达式（必须是常量表达式）
+        case ASTKind::BinaryExpr: {
+            auto binaryExpr = cast<BinaryExprAST>(expr);
+            // 使用 evaluateConstExpr 在编译时计算常量值
+            int value = evaluateConstExpr(binaryExpr);
+            // 创建 32 位整数常量
+            return llvm::ConstantInt::get(
+                llvm::Type::getInt32Ty(context),
+                value,
+                true  // 有符号
+            );
+            break;
+        }
+        
+        // 处理一元运算表达式（必须是常量表达式）
+        case ASTKind::UnaryExpr: {
+            auto unaryExpr = cast<UnaryExprAST>(expr);
+            // 使用 evaluateConstExpr 在编译时计算常量值
+            int value = evaluateConstExpr(unaryExpr);
+            // 创建 32 位整数常量
+            return llvm::ConstantInt::get(
+                llvm::Type::getInt32Ty(context),
+                value,
+                true  // 有符号
+            );
+            break;
+        }
+        default:
+            break;
     }
 
     throw std::runtime_error("Array size must be a constant integer expression");
@@ -282,277 +514,292 @@ llvm::Value* IRGenerator::generateExpr(ExprAST* expr) {
         throw std::runtime_error("Expression is null");
     }
     
-    // 处理整数字面量
-    if (auto intExpr = dynamic_cast<IntConstExprAST*>(expr)) {
-        // 创建 32 位整数常量
+    switch (expr->getNodeKind()) {
+        // 处理整数字面量
+        case ASTKind::IntConstExpr: {
+            auto intExpr = cast<IntConstExprAST>(expr);
+            // 创建 32 位整数常量
        
-        return llvm::ConstantInt::get(
-            llvm::Type::getInt32Ty(context),
-            intExpr->getValue(),
-            true  // 有符号
-        );
-    }
-    
-    // 处理浮点数字面量
-    if (auto floatExpr = dynamic_cast<FloatConstExprAST*>(expr)) {
-        // 创建浮点数常量
+            return llvm::ConstantInt::get(
+                llvm::Type::getInt32Ty(context),
+                intExpr->getValue(),
+                true  // 有符号
+            );
+            break;
+        }
         
-        return llvm::ConstantFP::get(
-            llvm::Type::getFloatTy(context),
-            floatExpr->getValue()
-        );
-    }
-    
-    // 处理字符串字面量
-    if (auto strExpr = dynamic_cast<StringLiteralExprAST*>(expr)) {
+        // 处理浮点数字面量
+        case ASTKind::FloatConstExpr: {
+            auto floatExpr = cast<FloatConstExprAST>(expr);
+            // 创建浮点数常量
+        
+            return llvm::ConstantFP::get(
+                llvm::Type::getFloatTy(context),
+                floatExpr->getValue()
+            );
+            break;
+        }
+        
+        // 处理字符串字面量
+        case ASTKind::StringLiteralExpr: {
+            auto strExpr = cast<StringLiteralExprAST>(expr);
        
-        return generateStringLiteral(strExpr);
-    }
-    
-    // 处理左值表达式（变量或数组访问）
-    if (auto lvalExpr = dynamic_cast<LValExprAST*>(expr)) {
+            return generateStringLiteral(strExpr);
+        }
         
-        return generateLVal(lvalExpr);
-    }
-    
-    // 处理函数调用表达式
-    if (auto callExpr = dynamic_cast<CallExprAST*>(expr)) {
+        // 处理左值表达式（变量或数组访问）
+        case ASTKind::LValExpr: {
+            auto lvalExpr = cast<LValExprAST>(expr);
         
-        return generateCallExpr(callExpr);
-    }
-
-    // 处理二元运算表达式
-    if (auto binaryExpr = dynamic_cast<BinaryExprAST*>(expr)) {
-        // 生成左侧表达式
-        llvm::Value* lhs = generateExpr(binaryExpr->getLHS());
-        // 生成右侧表达式
-        llvm::Value* rhs = generateExpr(binaryExpr->getRHS());
+            return generateLVal(lvalExpr);
+        }
+        
+        // 处理函数调用表达式
+        case ASTKind::CallExpr: {
+            auto callExpr = cast<CallExprAST>(expr);
+        
+            return generateCallExpr(callExpr);
+        }
+        
+        // 处理二元运算表达式
+        case ASTKind::BinaryExpr: {
+            auto binaryExpr = cast<BinaryExprAST>(expr);
+            // 生成左侧表达式
+            llvm::Value* lhs = generateExpr(binaryExpr->getLHS());
+            // 生成右侧表达式
+            llvm::Value* rhs = generateExpr(binaryExpr->getRHS());
         
-        // 类型转换逻辑：当两个操作数都是int类型时，进行整数运算；否则，转换为float类型进行浮点运算
-        llvm::Type* lhsType = lhs->getType();
-        llvm::Type* rhsType = rhs->getType();
-        bool lhsIsVector = lhsType->isVectorTy();
-        bool rhsIsVector = rhsType->isVectorTy();
-        if (lhsIsVector || rhsIsVector) {
-            // 向量-向量运算
-            if (lhsIsVector && rhsIsVector) {
-                if (lhsType != rhsType) {
-                    throw std::runtime_error("Vector operands must have the same type");
+            // 类型转换逻辑：当两个操作数都是int类型时，进行整数运算；否则，转换为float类型进行浮点运算
+            llvm::Type* lhsType = lhs->getType();
+            llvm::Type* rhsType = rhs->getType();
+            bool lhsIsVector = lhsType->isVectorTy();
+            bool rhsIsVector = rhsType->isVectorTy();
+            if (lhsIsVector || rhsIsVector) {
+                // 向量-向量运算
+                if (lhsIsVector && rhsIsVector) {
+                    if (lhsType != rhsType) {
+                        throw std::runtime_error("Vector operands must have the same type");
+                    }
+                    auto vecType = llvm::cast<llvm::VectorType>(lhsType);
+                    llvm::Type* elemType = vecType->getElementType();
+                    bool elemIsFloat = elemType->isFloatingPointTy();
+                    switch (binaryExpr->getOp()) {
+                        case BinaryExprAST::ADD:
+                            return elemIsFloat ? builder.CreateFAdd(lhs, rhs, "vaddtmp")
+                                               : builder.CreateAdd(lhs, rhs, "vaddtmp");
+                        case BinaryExprAST::SUB:
+                            return elemIsFloat ? builder.CreateFSub(lhs, rhs, "vsubtmp")
+                                               : builder.CreateSub(lhs, rhs, "vsubtmp");
+                        case BinaryExprAST::MUL:
+                            return elemIsFloat ? builder.CreateFMul(lhs, rhs, "vmultmp")
+                                               : builder.CreateMul(lhs, rhs, "vmultmp");
+                        case BinaryExprAST::DIV:
+                            return elemIsFloat ? builder.CreateFDiv(lhs, rhs, "vdivtmp")
+                                               : builder.CreateSDiv(lhs, rhs, "vdivtmp");
+                        default:
+                            throw std::runtime_error("Unsupported vector binary operator");
+                    }
+                }
+
+                // 向量-标量广播运算
+                auto op = binaryExpr->getOp();
+                if (op != BinaryExprAST::ADD && op != BinaryExprAST::SUB &&
+                    op != BinaryExprAST::MUL && op != BinaryExprAST::DIV &&
+                    op != BinaryExprAST::MOD) {
+                    throw std::runtime_error("Unsupported vector-scalar operator");
                 }
-                auto vecType = llvm::cast<llvm::VectorType>(lhsType);
+
+                bool scalarOnLeft = !lhsIsVector;
+                llvm::Value* vecValue = lhsIsVector ? lhs : rhs;
+                llvm::Value* scalarValue = lhsIsVector ? rhs : lhs;
+                auto vecType = llvm::dyn_cast<llvm::VectorType>(vecValue->getType());
+                if (!vecType) {
+                    throw std::runtime_error("Vector-scalar operation requires a vector operand");
+                }
+                auto fixedVecType = llvm::dyn_cast<llvm::FixedVectorType>(vecType);
+                if (!fixedVecType) {
+                    throw std::runtime_error("Vector-scalar operation only supports fixed-length vectors");
+                }
+
                 llvm::Type* elemType = vecType->getElementType();
                 bool elemIsFloat = elemType->isFloatingPointTy();
-                switch (binaryExpr->getOp()) {
+
+                // 标量类型适配
+                if (elemIsFloat) {
+                    if (scalarValue->getType()->isIntegerTy()) {
+                        scalarValue = builder.CreateSIToFP(scalarValue, elemType, "vsplat.int2float");
+                    } else if (!scalarValue->getType()->isFloatingPointTy()) {
+                        throw std::runtime_error("Vector-scalar multiplication expects int/float scalar");
+                    }
+                } else {
+                    if (!scalarValue->getType()->isIntegerTy()) {
+                        throw std::runtime_error("Vector<int> scalar must be integer");
+                    }
+                }
+
+                auto numElems = fixedVecType->getNumElements();
+                llvm::Value* splat = builder.CreateVectorSplat(numElems, scalarValue, "vsplat");
+                switch (op) {
                     case BinaryExprAST::ADD:
-                        return elemIsFloat ? builder.CreateFAdd(lhs, rhs, "vaddtmp")
-                                           : builder.CreateAdd(lhs, rhs, "vaddtmp");
+                        return elemIsFloat ? builder.CreateFAdd(vecValue, splat, "vsaddtmp")
+                                           : builder.CreateAdd(vecValue, splat, "vsaddtmp");
                     case BinaryExprAST::SUB:
-                        return elemIsFloat ? builder.CreateFSub(lhs, rhs, "vsubtmp")
-                                           : builder.CreateSub(lhs, rhs, "vsubtmp");
+                        if (scalarOnLeft) {
+                            return elemIsFloat ? builder.CreateFSub(splat, vecValue, "vssubtmp")
+                                               : builder.CreateSub(splat, vecValue, "vssubtmp");
+                        }
+                        return elemIsFloat ? builder.CreateFSub(vecValue, splat, "vssubtmp")
+                                           : builder.CreateSub(vecValue, splat, "vssubtmp");
                     case BinaryExprAST::MUL:
-                        return elemIsFloat ? builder.CreateFMul(lhs, rhs, "vmultmp")
-                                           : builder.CreateMul(lhs, rhs, "vmultmp");
+                        return elemIsFloat ? builder.CreateFMul(vecValue, splat, "vsmultmp")
+                                           : builder.CreateMul(vecValue, splat, "vsmultmp");
                     case BinaryExprAST::DIV:
-                        return elemIsFloat ? builder.CreateFDiv(lhs, rhs, "vdivtmp")
-                                           : builder.CreateSDiv(lhs, rhs, "vdivtmp");
+                        if (scalarOnLeft) {
+                            return elemIsFloat ? builder.CreateFDiv(splat, vecValue, "vsdivtmp")
+                                               : builder.CreateSDiv(splat, vecValue, "vsdivtmp");
+                        }
+                        return elemIsFloat ? builder.CreateFDiv(vecValue, splat, "vsdivtmp")
+                                           : builder.CreateSDiv(vecValue, splat, "vsdivtmp");
+                    case BinaryExprAST::MOD:
+                        if (elemIsFloat) {
+                            throw std::runtime_error("Vector-scalar modulo does not support float");
+                        }
+                        if (scalarOnLeft) {
+                            return builder.CreateSRem(splat, vecValue, "vsmodtmp");
+                        }
+                        return builder.CreateSRem(vecValue, splat, "vsmodtmp");
                     default:
-                        throw std::runtime_error("Unsupported vector binary operator");
+                        throw std::runtime_error("Unsupported vector-scalar operator");
                 }
             }
-
-            // 向量-标量广播运算
-            auto op = binaryExpr->getOp();
-            if (op != BinaryExprAST::ADD && op != BinaryExprAST::SUB &&
-                op != BinaryExprAST::MUL && op != BinaryExprAST::DIV &&
-                op != BinaryExprAST::MOD) {
-                throw std::runtime_error("Unsupported vector-scalar operator");
-            }
-
-            bool scalarOnLeft = !lhsIsVector;
-            llvm::Value* vecValue = lhsIsVector ? lhs : rhs;
-            llvm::Value* scalarValue = lhsIsVector ? rhs : lhs;
-            auto vecType = llvm::dyn_cast<llvm::VectorType>(vecValue->getType());
-            if (!vecType) {
-                throw std::runtime_error("Vector-scalar operation requires a vector operand");
-            }
-            auto fixedVecType = llvm::dyn_cast<llvm::FixedVectorType>(vecType);
-            if (!fixedVecType) {
-                throw std::runtime_error("Vector-scalar operation only supports fixed-length vectors");
-            }
-
-            llvm::Type* elemType = vecType->getElementType();
-            bool elemIsFloat = elemType->isFloatingPointTy();
-
-            // 标量类型适配
-            if (elemIsFloat) {
-                if (scalarValue->getType()->isIntegerTy()) {
-                    scalarValue = builder.CreateSIToFP(scalarValue, elemType, "vsplat.int2float");
-                } else if (!scalarValue->getType()->isFloatingPointTy()) {
-                    throw std::runtime_error("Vector-scalar multiplication expects int/float scalar");
+            bool lhsIsInt = lhsType->isIntegerTy();
+            bool rhsIsInt = rhsType->isIntegerTy();
+            bool isFloat = !(lhsIsInt && rhsIsInt);
+        
+            // 转换为float类型（如果需要）
+            if (isFloat) {
+                if (lhsIsInt) {
+                    lhs = builder.CreateSIToFP(lhs, llvm::Type::getFloatTy(context), "int2float_lhs");
                 }
-            } else {
-                if (!scalarValue->getType()->isIntegerTy()) {
-                    throw std::runtime_error("Vector<int> scalar must be integer");
+                if (rhsIsInt) {
+                    rhs = builder.CreateSIToFP(rhs, llvm::Type::getFloatTy(context), "int2float_rhs");
                 }
             }
-
-            auto numElems = fixedVecType->getNumElements();
-            llvm::Value* splat = builder.CreateVectorSplat(numElems, scalarValue, "vsplat");
-            switch (op) {
+        
+            switch (binaryExpr->getOp()) {
+                // 算术运算
                 case BinaryExprAST::ADD:
-                    return elemIsFloat ? builder.CreateFAdd(vecValue, splat, "vsaddtmp")
-                                       : builder.CreateAdd(vecValue, splat, "vsaddtmp");
+                    if (isFloat) {
+                        return builder.CreateFAdd(lhs, rhs, "addtmp");
+                    } else {
+                        return builder.CreateAdd(lhs, rhs, "addtmp");
+                    }
                 case BinaryExprAST::SUB:
-                    if (scalarOnLeft) {
-                        return elemIsFloat ? builder.CreateFSub(splat, vecValue, "vssubtmp")
-                                           : builder.CreateSub(splat, vecValue, "vssubtmp");
+                    if (isFloat) {
+                        return builder.CreateFSub(lhs, rhs, "subtmp");
+                    } else {
+                        return builder.CreateSub(lhs, rhs, "subtmp");
                     }
-                    return elemIsFloat ? builder.CreateFSub(vecValue, splat, "vssubtmp")
-                                       : builder.CreateSub(vecValue, splat, "vssubtmp");
                 case BinaryExprAST::MUL:
-                    return elemIsFloat ? builder.CreateFMul(vecValue, splat, "vsmultmp")
-                                       : builder.CreateMul(vecValue, splat, "vsmultmp");
+                    if (isFloat) {
+                        return builder.CreateFMul(lhs, rhs, "multmp");
+                    } else {
+                        return builder.CreateMul(lhs, rhs, "multmp");
+                    }
                 case BinaryExprAST::DIV:
-                    if (scalarOnLeft) {
-                        return elemIsFloat ? builder.CreateFDiv(splat, vecValue, "vsdivtmp")
-                                           : builder.CreateSDiv(splat, vecValue, "vsdivtmp");
+                    if (isFloat) {
+                        return builder.CreateFDiv(lhs, rhs, "divtmp");
+                    } else {
+                        // 使用有符号除法
+                        return builder.CreateSDiv(lhs, rhs, "divtmp");
                     }
-                    return elemIsFloat ? builder.CreateFDiv(vecValue, splat, "vsdivtmp")
-                                       : builder.CreateSDiv(vecValue, splat, "vsdivtmp");
                 case BinaryExprAST::MOD:
-                    if (elemIsFloat) {
-                        throw std::runtime_error("Vector-scalar modulo does not support float");
+                    if (isFloat) {
+                        // 浮点数不支持取模运算，返回0.0
+                        return llvm::Constant::getNullValue(llvm::Type::getFloatTy(context));
+                    } else {
+                        // 使用有符号取模
+                        return builder.CreateSRem(lhs, rhs, "modtmp");
                     }
-                    if (scalarOnLeft) {
-                        return builder.CreateSRem(splat, vecValue, "vsmodtmp");
+                // 关系运算
+                case BinaryExprAST::LT:
+                    if (isFloat) {
+                        return builder.CreateFCmpOLT(lhs, rhs, "lttmp");
+                    } else {
+                        return builder.CreateICmpSLT(lhs, rhs, "lttmp");
+                    }
+                case BinaryExprAST::GT:
+                    if (isFloat) {
+                        return builder.CreateFCmpOGT(lhs, rhs, "gttmp");
+                    } else {
+                        return builder.CreateICmpSGT(lhs, rhs, "gttmp");
+                    }
+                case BinaryExprAST::LE:
+                    if (isFloat) {
+                        return builder.CreateFCmpOLE(lhs, rhs, "letmp");
+                    } else {
+                        return builder.CreateICmpSLE(lhs, rhs, "letmp");
+                    }
+                case BinaryExprAST::GE:
+                    if (isFloat) {
+                        return builder.CreateFCmpOGE(lhs, rhs, "getmp");
+                    } else {
+                        return builder.CreateICmpSGE(lhs, rhs, "getmp");
+                    }
+                // 相等性运算
+                case BinaryExprAST::EQ:
+                    if (isFloat) {
+                        return builder.CreateFCmpOEQ(lhs, rhs, "eqtmp");
+                    } else {
+                        return builder.CreateICmpEQ(lhs, rhs, "eqtmp");
+                    }
+                case BinaryExprAST::NE:
+                    if (isFloat) {
+                        return builder.CreateFCmpONE(lhs, rhs, "netmp");
+                    } else {
+                        return builder.CreateICmpNE(lhs, rhs, "netmp");
                     }
-                    return builder.CreateSRem(vecValue, splat, "vsmodtmp");
+                // 逻辑运算（不能在Exp中出现）
+                case BinaryExprAST::AND:
+                    throw std::runtime_error("Logical AND operator cannot be used in expressions");
+                case BinaryExprAST::OR:
+                    throw std::runtime_error("Logical OR operator cannot be used in expressions");
                 default:
-                    throw std::runtime_error("Unsupported vector-scalar operator");
+                    throw std::runtime_error("Unknown binary operator");
             }
+            break;
         }
-        bool lhsIsInt = lhsType->isIntegerTy();
-        bool rhsIsInt = rhsType->isIntegerTy();
-        bool isFloat = !(lhsIsInt && rhsIsInt);
         
-        // 转换为float类型（如果需要）
-        if (isFloat) {
-            if (lhsIsInt) {
-                lhs = builder.CreateSIToFP(lhs, llvm::Type::getFloatTy(context), "int2float_lhs");
-            }
-            if (rhsIsInt) {
-                rhs = builder.CreateSIToFP(rhs, llvm::Type::getFloatTy(context), "int2float_rhs");
-            }
-        }
+        // 处理一元运算表达式
+        case ASTKind::UnaryExpr: {
+            auto unaryExpr = cast<UnaryExprAST>(expr);
+            // 生成操作数表达式
+            llvm::Value* operand = generateExpr(unaryExpr->getOperand());
         
-        switch (binaryExpr->getOp()) {
-            // 算术运算
-            case BinaryExprAST::ADD:
-                if (isFloat) {
-                    return builder.CreateFAdd(lhs, rhs, "addtmp");
-                } else {
-                    return builder.CreateAdd(lhs, rhs, "addtmp");
-                }
-            case BinaryExprAST::SUB:
-                if (isFloat) {
-                    return builder.CreateFSub(lhs, rhs, "subtmp");
-                } else {
-                    return builder.CreateSub(lhs, rhs, "subtmp");
-                }
-            case BinaryExprAST::MUL:
-                if (isFloat) {
-                    return builder.CreateFMul(lhs, rhs, "multmp");
-                } else {
-                    return builder.CreateMul(lhs, rhs, "multmp");
-                }
-            case BinaryExprAST::DIV:
-                if (isFloat) {
-                    return builder.CreateFDiv(lhs, rhs, "divtmp");
-                } else {
-                    // 使用有符号除法
-                    return builder.CreateSDiv(lhs, rhs, "divtmp");
-                }
-            case BinaryExprAST::MOD:
-                if (isFloat) {
-                    // 浮点数不支持取模运算，返回0.0
-                    return llvm::Constant::getNullValue(llvm::Type::getFloatTy(context));
-                } else {
-                    // 使用有符号取模
-                    return builder.CreateSRem(lhs, rhs, "modtmp");
-                }
-            // 关系运算
-            case BinaryExprAST::LT:
-                if (isFloat) {
-                    return builder.CreateFCmpOLT(lhs, rhs, "lttmp");
-                } else {
-                    return builder.CreateICmpSLT(lhs, rhs, "lttmp");
-                }
-            case BinaryExprAST::GT:
-                if (isFloat) {
-                    return builder.CreateFCmpOGT(lhs, rhs, "gttmp");
-                } else {
-                    return builder.CreateICmpSGT(lhs, rhs, "gttmp");
-                }
-            case BinaryExprAST::LE:
-                if (isFloat) {
-                    return builder.CreateFCmpOLE(lhs, rhs, "letmp");
-                } else {
-                    return builder.CreateICmpSLE(lhs, rhs, "letmp");
-                }
-            case BinaryExprAST::GE:
-                if (isFloat) {
-                    return builder.CreateFCmpOGE(lhs, rhs, "getmp");
-                } else {
-                    return builder.CreateICmpSGE(lhs, rhs, "getmp");
-                }
-            // 相等性运算
-            case BinaryExprAST::EQ:
-                if (isFloat) {
-                    return builder.CreateFCmpOEQ(lhs, rhs, "eqtmp");
-                } else {
-                    return builder.CreateICmpEQ(lhs, rhs, "eqtmp");
-                }
-            case BinaryExprAST::NE:
-                if (isFloat) {
-                    return builder.CreateFCmpONE(lhs, rhs, "netmp");
-                } else {
-                    return builder.CreateICmpNE(lhs, rhs, "netmp");
-                }
-            // 逻辑运算（不能在Exp中出现）
-            case BinaryExprAST::AND:
-                throw std::runtime_error("Logical AND operator cannot be used in expressions");
-            case BinaryExprAST::OR:
-                throw std::runtime_error("Logical OR operator cannot be used in expressions");
-            default:
-                throw std::runtime_error("Unknown binary operator");
-        }
-    }
-
-    // 处理一元运算表达式
-    if (auto unaryExpr = dynamic_cast<UnaryExprAST*>(expr)) {
-        // 生成操作数表达式
-        llvm::Value* operand = generateExpr(unaryExpr->getOperand());
-        
-        // 根据运算符类型生成相应的IR指令
-        switch (unaryExpr->getOp()) {
-            case UnaryExprAST::PLUS:
-                // 正号不改变值，直接返回操作数
-                return operand;
-            case UnaryExprAST::MINUS:
-                // 根据操作数类型选择取负指令
-                if (operand->getType()->isFloatingPointTy()) {
-                    // 浮点类型使用浮点取负指令
-                    return builder.CreateFNeg(operand, "negtmp");
-                } else {
-                    // 整数类型使用整数取负指令
-                    return builder.CreateNeg(operand, "negtmp");
-                }
-            case UnaryExprAST::NOT:
-                // 逻辑非运算符只能在Cond中出现，不能在Exp中出现
-                throw std::runtime_error("Logical NOT operator cannot be used in expressions");
-            default:
-                throw std::runtime_error("Unknown unary operator");
+            // 根据运算符类型生成相应的IR指令
+            switch (unaryExpr->getOp()) {
+                case UnaryExprAST::PLUS:
+                    // 正号不改变值，直接返回操作数
+                    return operand;
+                case UnaryExprAST::MINUS:
+                    // 根据操作数类型选择取负指令
+                    if (operand->getType()->isFloatingPointTy()) {
+                        // 浮点类型使用浮点取负指令
+                        return builder.CreateFNeg(operand, "negtmp");
+                    } else {
+                        // 整数类型使用整数取负指令
+                        return builder.CreateNeg(operand, "negtmp");
+                    }
+                case UnaryExprAST::NOT:
+                    // 逻辑非运算符只能在Cond中出现，不能在Exp中出现
+                    throw std::runtime_error("Logical NOT operator cannot be used in expressions");
+                default:
+                    throw std::runtime_error("Unknown unary operator");
+            }
+            break;
         }
+        default:
+            break;
     }
 
     throw std::runtime_error("Unsupported expression type");
@@ -564,446 +811,579 @@ llvm::Value* IRGenerator::generateCondExpr(ExprAST* expr) {
         throw std::runtime_error("Expression is null");
     }
 
-    // 处理整数字面量
-    if (auto intExpr = dynamic_cast<IntConstExprAST*>(expr)) {
-        // 创建 32 位整数常量
-        return llvm::ConstantInt::get(
-            llvm::Type::getInt32Ty(context),
-            intExpr->getValue(),
-            true  // 有符号
-        );
-    }
-
-    // 处理浮点数字面量
-    if (auto floatExpr = dynamic_cast<FloatConstExprAST*>(expr)) {
-        // 创建浮点数常量
-        return llvm::ConstantFP::get(
-            llvm::Type::getFloatTy(context),
-            floatExpr->getValue()
-        );
-    }
-
-    // 处理左值表达式（变量或数组访问）
-    if (auto lvalExpr = dynamic_cast<LValExprAST*>(expr)) {
-        llvm::Value* value = generateLVal(lvalExpr);
-        if (value->getType()->isVectorTy()) {
-            throw std::runtime_error("Vector value cannot be used as a condition");
-        }
-        return value;
-    }
-
-    // 处理函数调用表达式
-    if (auto callExpr = dynamic_cast<CallExprAST*>(expr)) {
-        llvm::Value* value = generateCallExpr(callExpr);
-        if (value->getType()->isVectorTy()) {
-            throw std::runtime_error("Vector value cannot be used as a condition");
+    switch (expr->getNodeKind()) {
+        // 处理整数字面量
+        case ASTKind::IntConstExpr: {
+            auto intExpr = cast<IntConstExprAST>(expr);
+            // 创建 32 位整数常量
+            return llvm::ConstantInt::get(
+                llvm::Type::getInt32Ty(context),
+                intExpr->getValue(),
+                true  // 有符号
+            );
+            break;
         }
-        return value;
-    }
-
-    // 处理二元运算表达式
-    if (auto binaryExpr = dynamic_cast<BinaryExprAST*>(expr)) {
-        // 生成左侧表达式
-        llvm::Value* lhs = generateCondExpr(binaryExpr->getLHS());
-        // 生成右侧表达式
-        llvm::Value* rhs = generateCondExpr(binaryExpr->getRHS());
-
-        // 类型转换逻辑：当两个操作数都是int类型时，进行整数运算；否则，转换为float类型进行浮点运算
-        llvm::Type* lhsType = lhs->getType();
-        llvm::Type* rhsType = rhs->getType();
-        if (lhsType->isVectorTy() || rhsType->isVectorTy()) {
-            throw std::runtime_error("Vector value cannot be used in conditional expressions");
+        
+        // 处理浮点数字面量
+        case ASTKind::FloatConstExpr: {
+            auto floatExpr = cast<FloatConstExprAST>(expr);
+            // 创建浮点数常量
+            return llvm::ConstantFP::get(
+                llvm::Type::getFloatTy(context),
+                floatExpr->getValue()
+            );
+            break;
         }
-        bool lhsIsInt = lhsType->isIntegerTy();
-        bool rhsIsInt = rhsType->isIntegerTy();
-        bool isFloat = !(lhsIsInt && rhsIsInt);
         
-        // 转换为float类型（如果需要）
-        if (isFloat) {
-            if (lhsIsInt) {
-                lhs = builder.CreateSIToFP(lhs, llvm::Type::getFloatTy(context), "int2float_lhs");
+        // 处理左值表达式（变量或数组访问）
+        case ASTKind::LValExpr: {
+            auto lvalExpr = cast<LValExprAST>(expr);
+            llvm::Value* value = generateLVal(lvalExpr);
+            if (value->getType()->isVectorTy()) {
+                throw std::runtime_error("Vector value cannot be used as a condition");
             }
-            if (rhsIsInt) {
-                rhs = builder.CreateSIToFP(rhs, llvm::Type::getFloatTy(context), "int2float_rhs");
+            return value;
+        }
+        
+        // 处理函数调用表达式
+        case ASTKind::CallExpr: {
+            auto callExpr = cast<CallExprAST>(expr);
+            llvm::Value* value = generateCallExpr(callExpr);
+            if (value->getType()->isVectorTy()) {
+                throw std::runtime_error("Vector value cannot be used as a condition");
             }
+            return value;
         }
         
-        switch (binaryExpr->getOp()) {
-            // 算术运算
-            case BinaryExprAST::ADD:
-                if (isFloat) {
-                    return builder.CreateFAdd(lhs, rhs, "addtmp");
-                } else {
-                    return builder.CreateAdd(lhs, rhs, "addtmp");
-                }
-            case BinaryExprAST::SUB:
-                if (isFloat) {
-                    return builder.CreateFSub(lhs, rhs, "subtmp");
-                } else {
-                    return builder.CreateSub(lhs, rhs, "subtmp");
-                }
-            case BinaryExprAST::MUL:
-                if (isFloat) {
-                    return builder.CreateFMul(lhs, rhs, "multmp");
-                } else {
-                    return builder.CreateMul(lhs, rhs, "multmp");
-                }
-            case BinaryExprAST::DIV:
-                if (isFloat) {
-                    return builder.CreateFDiv(lhs, rhs, "divtmp");
-                } else {
-                    // 使用有符号除法
-                    return builder.CreateSDiv(lhs, rhs, "divtmp");
-                }
-            case BinaryExprAST::MOD:
-                if (isFloat) {
-                    // 浮点数不支持取模运算，返回0.0
-                    return llvm::Constant::getNullValue(llvm::Type::getFloatTy(context));
-                } else {
-                    // 使用有符号取模
-                    return builder.CreateSRem(lhs, rhs, "modtmp");
-                }
-            // 关系运算
-            case BinaryExprAST::LT:
-                if (isFloat) {
-                    return builder.CreateFCmpOLT(lhs, rhs, "lttmp");
-                } else {
-                    return builder.CreateICmpSLT(lhs, rhs, "lttmp");
-                }
-            case BinaryExprAST::GT:
-                if (isFloat) {
-                    return builder.CreateFCmpOGT(lhs, rhs, "gttmp");
-                } else {
-                    return builder.CreateICmpSGT(lhs, rhs, "gttmp");
-                }
-            case BinaryExprAST::LE:
-                if (isFloat) {
-                    return builder.CreateFCmpOLE(lhs, rhs, "letmp");
-                } else {
-                    return builder.CreateICmpSLE(lhs, rhs, "letmp");
-                }
-            case BinaryExprAST::GE:
-                if (isFloat) {
-                    return builder.CreateFCmpOGE(lhs, rhs, "getmp");
-                } else {
-                    return builder.CreateICmpSGE(lhs, rhs, "getmp");
-                }
-            // 相等性运算
-            case BinaryExprAST::EQ:
-                if (isFloat) {
-                    return builder.CreateFCmpOEQ(lhs, rhs, "eqtmp");
-                } else {
-                    return builder.CreateICmpEQ(lhs, rhs, "eqtmp");
-                }
-            case BinaryExprAST::NE:
-                if (isFloat) {
-                    return builder.CreateFCmpONE(lhs, rhs, "netmp");
-                } else {
-                    return builder.CreateICmpNE(lhs, rhs, "netmp");
+        // 处理二元运算表达式
+        case ASTKind::BinaryExpr: {
+            auto binaryExpr = cast<BinaryExprAST>(expr);
+            // 逻辑运算需要短路求值，单独生成控制流
+            if (binaryExpr->getOp() == BinaryExprAST::AND ||
+                binaryExpr->getOp() == BinaryExprAST::OR) {
+                return generateLogicalValue(binaryExpr);
+            }
+
+            // 生成左侧表达式
+            llvm::Value* lhs = generateCondExpr(binaryExpr->getLHS());
+            // 生成右侧表达式
+            llvm::Value* rhs = generateCondExpr(binaryExpr->getRHS());
+
+            // 关系/逻辑运算的结果为 i1，参与后续运算时扩展为 int
+            if (lhs->getType()->isIntegerTy(1)) {
+                lhs = builder.CreateZExt(lhs, llvm::Type::getInt32Ty(context), "bool2int_lhs");
+            }
+            if (rhs->getType()->isIntegerTy(1)) {
+                rhs = builder.CreateZExt(rhs, llvm::Type::getInt32Ty(context), "bool2int_rhs");
+            }
+
+            // 类型转换逻辑：当两个操作数都是int类型时，进行整数运算；否则，转换为float类型进行浮点运算
+            llvm::Type* lhsType = lhs->getType();
+            llvm::Type* rhsType = rhs->getType();
+            if (lhsType->isVectorTy() || rhsType->isVectorTy()) {
+                throw std::runtime_error("Vector value cannot be used in conditional expressions");
+            }
+            bool lhsIsInt = lhsType->isIntegerTy();
+            bool rhsIsInt = rhsType->isIntegerTy();
+            bool isFloat = !(lhsIsInt && rhsIsInt);
+        
+            // 转换为float类型（如果需要）
+            if (isFloat) {
+                if (lhsIsInt) {
+                    lhs = builder.CreateSIToFP(lhs, llvm::Type::getFloatTy(context), "int2float_lhs");
                 }
-            // 逻辑运算
-            case BinaryExprAST::AND:
-                return builder.CreateAnd(lhs, rhs, "andtmp");
-            case BinaryExprAST::OR:
-                return builder.CreateOr(lhs, rhs, "ortmp");
-            default:
-                throw std::runtime_error("Unknown binary operator");
-        }
-    }
-
-    // 处理一元运算表达式
-    if (auto unaryExpr = dynamic_cast<UnaryExprAST*>(expr)) {
-        // 生成操作数表达式
-        llvm::Value* operand = generateCondExpr(unaryExpr->getOperand());
-
-        // 根据运算符类型生成相应的IR指令
-        switch (unaryExpr->getOp()) {
-            case UnaryExprAST::PLUS:
-                // 正号不改变值，直接返回操作数
-                return operand;
-            case UnaryExprAST::MINUS:
-                // 根据操作数类型选择取负指令
-                if (operand->getType()->isFloatingPointTy()) {
-                    // 浮点类型使用浮点取负指令
-                    return builder.CreateFNeg(operand, "negtmp");
-                } else {
-                    // 整数类型使用整数取负指令
-                    return builder.CreateNeg(operand, "negtmp");
+                if (rhsIsInt) {
+                    rhs = builder.CreateSIToFP(rhs, llvm::Type::getFloatTy(context), "int2float_rhs");
                 }
-            case UnaryExprAST::NOT:
-                // 逻辑非运算，将操作数与0比较
-                return builder.CreateICmpEQ(operand, 
-                    llvm::ConstantInt::get(operand->getType(), 0), 
-                    "nottmp");
-            default:
-                throw std::runtime_error("Unknown unary operator");
+            }
+        
+            switch (binaryExpr->getOp()) {
+                // 算术运算
+                case BinaryExprAST::ADD:
+                    if (isFloat) {
+                        return builder.CreateFAdd(lhs, rhs, "addtmp");
+                    } else {
+                        return builder.CreateAdd(lhs, rhs, "addtmp");
+                    }
+                case BinaryExprAST::SUB:
+                    if (isFloat) {
+                        return builder.CreateFSub(lhs, rhs, "subtmp");
+                    } else {
+                        return builder.CreateSub(lhs, rhs, "subtmp");
+                    }
+                case BinaryExprAST::MUL:
+                    if (isFloat) {
+                        return builder.CreateFMul(lhs, rhs, "multmp");
+                    } else {
+                        return builder.CreateMul(lhs, rhs, "multmp");
+                    }
+                case BinaryExprAST::DIV:
+                    if (isFloat) {
+                        return builder.CreateFDiv(lhs, rhs, "divtmp");
+                    } else {
+                        // 使用有符号除法
+                        return builder.CreateSDiv(lhs, rhs, "divtmp");
+                    }
+                case BinaryExprAST::MOD:
+                    if (isFloat) {
+                        // 浮点数不支持取模运算，返回0.0
+                        return llvm::Constant::getNullValue(llvm::Type::getFloatTy(context));
+                    } else {
+                        // 使用有符号取模
+                        return builder.CreateSRem(lhs, rhs, "modtmp");
+                    }
+                // 关系运算
+                case BinaryExprAST::LT:
+                    if (isFloat) {
+                        return builder.CreateFCmpOLT(lhs, rhs, "lttmp");
+                    } else {
+                        return builder.CreateICmpSLT(lhs, rhs, "lttmp");
+                    }
+                case BinaryExprAST::GT:
+                    if (isFloat) {
+                        return builder.CreateFCmpOGT(lhs, rhs, "gttmp");
+                    } else {
+                        return builder.CreateICmpSGT(lhs, rhs, "gttmp");
+                    }
+                case BinaryExprAST::LE:
+                    if (isFloat) {
+                        return builder.CreateFCmpOLE(lhs, rhs, "letmp");
+                    } else {
+                        return builder.CreateICmpSLE(lhs, rhs, "letmp");
+                    }
+                case BinaryExprAST::GE:
+                    if (isFloat) {
+                        return builder.CreateFCmpOGE(lhs, rhs, "getmp");
+                    } else {
+                        return builder.CreateICmpSGE(lhs, rhs, "getmp");
+                    }
+                // 相等性运算
+                case BinaryExprAST::EQ:
+                    if (isFloat) {
+                        return builder.CreateFCmpOEQ(lhs, rhs, "eqtmp");
+                    } else {
+                        return builder.CreateICmpEQ(lhs, rhs, "eqtmp");
+                    }
+                case BinaryExprAST::NE:
+                    if (isFloat) {
+                        return builder.CreateFCmpONE(lhs, rhs, "netmp");
+                    } else {
+                        return builder.CreateICmpNE(lhs, rhs, "netmp");
+                    }
+                default:
+                    throw std::runtime_error("Unknown binary operator");
+            }
+            break;
         }
+        
+        // 处理一元运算表达式
+        case ASTKind::UnaryExpr: {
+            auto unaryExpr = cast<UnaryExprAST>(expr);
+            // 生成操作数表达式
+            llvm::Value* operand = generateCondExpr(unaryExpr->getOperand());
+
+            // 根据运算符类型生成相应的IR指令
+            switch (unaryExpr->getOp()) {
+                case UnaryExprAST::PLUS:
+                    // 正号不改变值，直接返回操作数
+                    return operand;
+                case UnaryExprAST::MINUS:
+                    // 根据操作数类型选择取负指令
+                    if (operand->getType()->isFloatingPointTy()) {
+                        // 浮点类型使用浮点取负指令
+                        return builder.CreateFNeg(operand, "negtmp");
+                    } else {
+                        // 整数类型使用整数取负指令
+                        return builder.CreateNeg(operand, "negtmp");
+                    }
+                case UnaryExprAST::NOT:
+                    // 逻辑非运算，先转换为布尔值再取反
+                    return builder.CreateNot(convertToBool(operand, "tobool"), "nottmp");
+                default:
+                    throw std::runtime_error("Unknown unary operator");
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    throw std::runtime_error("Unsupported expression type");
+}
+
+// 将条件值转换为 i1（非零为真，零为假），关系运算结果直接复用
+llvm::Value* IRGenerator::convertToBool(llvm::Value* value, const std::string& name) {
+    llvm::Type* type = value->getType();
+    if (type->isIntegerTy(1)) {
+        return value;
+    }
+    if (type->isIntegerTy()) {
+        return builder.CreateICmpNE(value, llvm::ConstantInt::get(type, 0), name);
+    }
+    if (type->isFloatingPointTy()) {
+        return builder.CreateFCmpUNE(value, llvm::ConstantFP::get(type, 0.0), name);
     }
-
-    throw std::runtime_error("Unsupported expression type");
+    throw std::runtime_error("Condition must be int or float");
 }
 
-// 生成语句的 IR
-void IRGenerator::generateStmt(StmtAST* stmt) {
-    if (!stmt) {
-        throw std::runtime_error("Statement is null");
+// 生成条件跳转：条件为真跳转到 trueBB，为假跳转到 falseBB
+// && 和 || 按短路语义拆分为跳转链，! 交换真假目标，比较结果直接用于条件跳转
+void IRGenerator::generateCondBranch(ExprAST* expr, llvm::BasicBlock* trueBB, llvm::BasicBlock* falseBB) {
+    if (!expr) {
+        throw std::runtime_error("Expression is null");
     }
 
-    // 处理 return 语句
-    if (auto retStmt = dynamic_cast<ReturnStmtAST*>(stmt)) {
-        // 检查是否有返回值
-        if (retStmt->getReturnValue()) {
-            // 有返回值，生成表达式并返回
-            llvm::Value* retValue = generateExpr(retStmt->getReturnValue());
-
-            // 检查函数返回类型是否为void
-            llvm::Type* retType = currentFunction->getReturnType();
-            if (retType->isVoidTy()) {
-                throw std::runtime_error("Void function cannot return a value");
-            }
-
-            // 类型检查和转换：确保返回值类型与函数返回类型一致
-            llvm::Type* retValueType = retValue->getType();
-            if (retValueType != retType) {
-                // 类型转换逻辑
-                if (retType->isFloatingPointTy() && retValueType->isIntegerTy()) {
-                    // 整数转换为浮点
-                    retValue = builder.CreateSIToFP(retValue, retType, "int2float_ret");
-                } else if (retType->isIntegerTy() && retValueType->isFloatingPointTy()) {
-                    // 浮点转换为整数
-                    retValue = builder.CreateFPToSI(retValue, retType, "float2int_ret");
-                } else {
-                    // 其他类型转换不支持
-                    throw std::runtime_error("Unsupported return type conversion");
-                }
-            }
+    if (auto binaryExpr = dyn_cast<BinaryExprAST>(expr)) {
+        if (binaryExpr->getOp() == BinaryExprAST::AND ||
+            binaryExpr->getOp() == BinaryExprAST::OR) {
+            bool isAnd = binaryExpr->getOp() == BinaryExprAST::AND;
+            llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+            llvm::BasicBlock* rhsBB = llvm::BasicBlock::Create(
+                context, isAnd ? "land.rhs" : "lor.rhs", theFunction);
 
-            builder.CreateRet(retValue);
-        } else {
-            // 无返回值，检查函数返回类型
-            if (!currentFunction->getReturnType()->isVoidTy()) {
-                throw std::runtime_error("Non-void function must return a value");
+            // a && b：a 为假直接跳到 falseBB；a || b：a 为真直接跳到 trueBB
+            if (isAnd) {
+                generateCondBranch(binaryExpr->getLHS(), rhsBB, falseBB);
+            } else {
+                generateCondBranch(binaryExpr->getLHS(), trueBB, rhsBB);
             }
 
-            builder.CreateRetVoid();
+            sealBlock(rhsBB);
+            builder.SetInsertPoint(rhsBB);
+            generateCondBranch(binaryExpr->getRHS(), trueBB, falseBB);
+            return;
+        }
+    }
+
+    if (auto unaryExpr = dyn_cast<UnaryExprAST>(expr)) {
+        if (unaryExpr->getOp() == UnaryExprAST::NOT) {
+            generateCondBranch(unaryExpr->getOperand(), falseBB, trueBB);
+            return;
         }
+    }
+
+    llvm::Value* boolValue = convertToBool(generateCondExpr(expr), "tobool");
+
+    // 条件为常量时直接生成无条件跳转
+    if (auto constBool = llvm::dyn_cast<llvm::ConstantInt>(boolValue)) {
+        builder.CreateBr(constBool->isZero() ? falseBB : trueBB);
         return;
     }
+    builder.CreateCondBr(boolValue, trueBB, falseBB);
+}
 
-    // 处理 if 语句
-    if (auto ifStmt = dynamic_cast<IfStmtAST*>(stmt)) {
-        // 生成条件表达式
-        llvm::Value* condValue = generateCondExpr(ifStmt->getCondition());
+// 需要 && / || 的值时（如作为比较运算的操作数），短路求值后用 PHI 合并结果
+llvm::Value* IRGenerator::generateLogicalValue(BinaryExprAST* expr) {
+    bool isAnd = expr->getOp() == BinaryExprAST::AND;
+    llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
 
-        // 将条件转换为布尔值（非零为真，零为假）
-        llvm::Value* boolValue = builder.CreateICmpNE(
-            condValue, 
-            llvm::ConstantInt::get(condValue->getType(), 0), 
-            "ifcond"
-        );
+    llvm::Value* lhsBool = convertToBool(generateCondExpr(expr->getLHS()), "tobool");
+    llvm::BasicBlock* lhsEndBB = builder.GetInsertBlock();
 
-        // 获取当前函数
-        llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* rhsBB = llvm::BasicBlock::Create(
+        context, isAnd ? "land.rhs" : "lor.rhs", theFunction);
+    llvm::BasicBlock* endBB = llvm::BasicBlock::Create(
+        context, isAnd ? "land.end" : "lor.end");
 
-        // 创建then块和end块
-        llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(context, "then", theFunction);
-        llvm::BasicBlock* endBB = llvm::BasicBlock::Create(context, "endif");
+    if (isAnd) {
+        builder.CreateCondBr(lhsBool, rhsBB, endBB);
+    } else {
+        builder.CreateCondBr(lhsBool, endBB, rhsBB);
+    }
+
+    sealBlock(rhsBB);
+    builder.SetInsertPoint(rhsBB);
+    llvm::Value* rhsBool = convertToBool(generateCondExpr(expr->getRHS()), "tobool");
+    llvm::BasicBlock* rhsEndBB = builder.GetInsertBlock();
+    builder.CreateBr(endBB);
+
+    theFunction->insert(theFunction->end(), endBB);
+    sealBlock(endBB);
+    builder.SetInsertPoint(endBB);
+    llvm::PHINode* phi = builder.CreatePHI(llvm::Type::getInt1Ty(context), 2,
+                                           isAnd ? "landtmp" : "lortmp");
+    // 左侧短路时结果固定：&& 为假，|| 为真
+    phi->addIncoming(llvm::ConstantInt::getBool(context, !isAnd), lhsEndBB);
+    phi->addIncoming(rhsBool, rhsEndBB);
+    return phi;
+}
 
-        // 如果有else部分，创建else块
-        llvm::BasicBlock* elseBB = nullptr;
-        if (ifStmt->getElseStmt()) {
-            elseBB = llvm::BasicBlock::Create(context, "else");
-            // 创建条件跳转
-            builder.CreateCondBr(boolValue, thenBB, elseBB);
-        } else {
-            // 没有else部分，直接跳转到then块或end块
-            builder.CreateCondBr(boolValue, thenBB, endBB);
-        }
+// 生成语句的 IR
+void IRGenerator::generateStmt(StmtAST* stmt) {
+    if (!stmt) {
+        throw std::runtime_error("Statement is null");
+    }
 
-        // 生成then部分
-        builder.SetInsertPoint(thenBB);
-        generateStmt(ifStmt->getThenStmt());
+    switch (stmt->getNodeKind()) {
+        // 处理 return 语句
+        case ASTKind::ReturnStmt: {
+            auto retStmt = cast<ReturnStmtAST>(stmt);
+            // 检查是否有返回值
+            if (retStmt->getReturnValue()) {
+                // 有返回值，生成表达式并返回
+                llvm::Value* retValue = generateExpr(retStmt->getReturnValue());
 
-        // 如果then块没有终止指令，跳转到end块
-        if (!builder.GetInsertBlock()->getTerminator()) {
-            builder.CreateBr(endBB);
+                // 检查函数返回类型是否为void
+                llvm::Type* retType = currentFunction->getReturnType();
+                if (retType->isVoidTy()) {
+                    throw std::runtime_error("Void function cannot return a value");
+                }
+
+                // 类型检查和转换：确保返回值类型与函数返回类型一致
+                llvm::Type* retValueType = retValue->getType();
+                if (retValueType != retType) {
+                    // 类型转换逻辑
+                    if (retType->isFloatingPointTy() && retValueType->isIntegerTy()) {
+                        // 整数转换为浮点
+                        retValue = builder.CreateSIToFP(retValue, retType, "int2float_ret");
+                    } else if (retType->isIntegerTy() && retValueType->isFloatingPointTy()) {
+                        // 浮点转换为整数
+                        retValue = builder.CreateFPToSI(retValue, retType, "float2int_ret");
+                    } else {
+                        // 其他类型转换不支持
+                        throw std::runtime_error("Unsupported return type conversion");
+                    }
+                }
+
+                builder.CreateRet(retValue);
+            } else {
+                // 无返回值，检查函数返回类型
+                if (!currentFunction->getReturnType()->isVoidTy()) {
+                    throw std::runtime_error("Non-void function must return a value");
+                }
+
+                builder.CreateRetVoid();
+            }
+            return;
         }
+        
+        // 处理 if 语句
+        case ASTKind::IfStmt: {
+            auto ifStmt = cast<IfStmtAST>(stmt);
+            // 获取当前函数
+            llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+
+            // 创建then块和end块
+            llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(context, "then");
+            llvm::BasicBlock* endBB = llvm::BasicBlock::Create(context, "endif");
+
+            // 如果有else部分，创建else块
+            llvm::BasicBlock* elseBB = nullptr;
+            if (ifStmt->getElseStmt()) {
+                elseBB = llvm::BasicBlock::Create(context, "else");
+            }
+
+            // 生成条件跳转（没有else部分时，条件为假直接跳转到end块）
+            generateCondBranch(ifStmt->getCondition(), thenBB, elseBB ? elseBB : endBB);
+
+            // 条件跳转生成后，then/else块的前驱已经确定
+            sealBlock(thenBB);
+            if (elseBB) {
+                sealBlock(elseBB);
+            }
 
-        // 如果有else部分，生成else部分
-        if (ifStmt->getElseStmt()) {
-            theFunction->insert(theFunction->end(), elseBB);
-            builder.SetInsertPoint(elseBB);
-            generateStmt(ifStmt->getElseStmt());
+            // 生成then部分
+            theFunction->insert(theFunction->end(), thenBB);
+            builder.SetInsertPoint(thenBB);
+            generateStmt(ifStmt->getThenStmt());
 
-            // 如果else块没有终止指令，跳转到end块
+            // 如果then块没有终止指令，跳转到end块
             if (!builder.GetInsertBlock()->getTerminator()) {
                 builder.CreateBr(endBB);
             }
-        }
 
-        // 设置插入点到end块
-        theFunction->insert(theFunction->end(), endBB);
-        builder.SetInsertPoint(endBB);
+            // 如果有else部分，生成else部分
+            if (ifStmt->getElseStmt()) {
+                theFunction->insert(theFunction->end(), elseBB);
+                builder.SetInsertPoint(elseBB);
+                generateStmt(ifStmt->getElseStmt());
 
-        return;
-    }
+                // 如果else块没有终止指令，跳转到end块
+                if (!builder.GetInsertBlock()->getTerminator()) {
+                    builder.CreateBr(endBB);
+                }
+            }
+
+            // 设置插入点到end块（两个分支都已生成，可以封闭）
+            theFunction->insert(theFunction->end(), endBB);
+            sealBlock(endBB);
+            builder.SetInsertPoint(endBB);
 
-    // 处理表达式语句
-    if (auto exprStmt = dynamic_cast<ExprStmtAST*>(stmt)) {
-        // 如果有表达式，生成并丢弃结果
-        if (exprStmt->getExpr()) {
-            generateExpr(exprStmt->getExpr());
+            return;
         }
-        return;
-    }
-    
-    // 处理赋值语句
-    if (auto assignStmt = dynamic_cast<AssignStmtAST*>(stmt)) {
-        // 检查是否是数组名直接赋值
-        auto lval = assignStmt->getLVal();
-        const std::string& varName = lval->getName();
         
-        // 查找变量
-        auto symOpt = lookupSymbol(varName);
-        if (symOpt) {
-            // 如果是数组且没有使用索引，则是数组名直接赋值，这是非法的
-            if (symOpt.value().isArray && lval->getIndices().empty()) {
-                throw std::runtime_error("Cannot assign to array name '" + varName + "' directly, use array indexing");
+        // 处理表达式语句
+        case ASTKind::ExprStmt: {
+            auto exprStmt = cast<ExprStmtAST>(stmt);
+            // 如果有表达式，生成并丢弃结果
+            if (exprStmt->getExpr()) {
+                generateExpr(exprStmt->getExpr());
             }
+            return;
         }
         
-        // 向量索引赋值：v[i] = x
-        if (symOpt) {
-            llvm::Value* varPtr = symOpt.value().value;
-            llvm::Type* allocatedType = nullptr;
-            if (auto allocaInst = llvm::dyn_cast<llvm::AllocaInst>(varPtr)) {
-                allocatedType = allocaInst->getAllocatedType();
-            } else if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(varPtr)) {
-                allocatedType = globalVar->getValueType();
-            }
-
-            if (allocatedType && allocatedType->isVectorTy() && !lval->getIndices().empty()) {
-                if (lval->getIndices().size() != 1) {
-                    throw std::runtime_error("Vector index must be one-dimensional");
-                }
-                llvm::Value* vecValue = builder.CreateLoad(allocatedType, varPtr, "vecload");
-                llvm::Value* indexValue = generateExpr(lval->getIndices()[0].get());
-                if (!indexValue->getType()->isIntegerTy()) {
-                    throw std::runtime_error("Vector index must be integer");
+        // 处理赋值语句
+        case ASTKind::AssignStmt: {
+            auto assignStmt = cast<AssignStmtAST>(stmt);
+            // 检查是否是数组名直接赋值
+            auto lval = assignStmt->getLVal();
+            const std::string& varName = lval->getName();
+        
+            // 查找变量
+            auto symOpt = lookupSymbol(lval->getIdentifier());
+            if (symOpt) {
+                // 如果是数组且没有使用索引，则是数组名直接赋值，这是非法的
+                if (symOpt.value().isArray && lval->getIndices().empty()) {
+                    throw std::runtime_error("Cannot assign to array name '" + varName + "' directly, use array indexing");
                 }
-                if (indexValue->getType() != llvm::Type::getInt32Ty(context)) {
-                    indexValue = builder.CreateIntCast(indexValue, llvm::Type::getInt32Ty(context), true, "vidxcast");
+            }
+        
+            // 直接 SSA 变量：记录新定义，不生成 store
+            if (symOpt && symOpt.value().ssaVar >= 0) {
+                int var = symOpt.value().ssaVar;
+                if (!lval->getIndices().empty()) {
+                    throw std::runtime_error("Scalar variable '" + varName + "' cannot be indexed");
                 }
+                llvm::Value* rval = convertScalar(generateExpr(assignStmt->getExpr()), ssaVariables[var].type);
+                writeVariable(var, builder.GetInsertBlock(), rval);
+                return;
+            }
 
-                llvm::Value* rval = generateExpr(assignStmt->getExpr());
-                llvm::Type* elemType = llvm::cast<llvm::VectorType>(allocatedType)->getElementType();
-                if (rval->getType() != elemType) {
-                    if (elemType->isFloatingPointTy() && rval->getType()->isIntegerTy()) {
-                        rval = builder.CreateSIToFP(rval, elemType, "int2float_elem");
-                    } else if (elemType->isIntegerTy() && rval->getType()->isFloatingPointTy()) {
-                        rval = builder.CreateFPToSI(rval, elemType, "float2int_elem");
-                    } else {
-                        throw std::runtime_error("Type mismatch in vector element assignment");
+            // 向量索引赋值：v[i] = x
+            if (symOpt) {
+                llvm::Value* varPtr = symOpt.value().value;
+                llvm::Type* allocatedType = getStorageType(symOpt.value());
+
+                if (allocatedType && allocatedType->isVectorTy() && !lval->getIndices().empty()) {
+                    if (lval->getIndices().size() != 1) {
+                        throw std::runtime_error("Vector index must be one-dimensional");
+                    }
+                    llvm::Value* vecValue = builder.CreateLoad(allocatedType, varPtr, "vecload");
+                    llvm::Value* indexValue = generateExpr(lval->getIndices()[0].get());
+                    if (!indexValue->getType()->isIntegerTy()) {
+                        throw std::runtime_error("Vector index must be integer");
+                    }
+                    if (indexValue->getType() != llvm::Type::getInt32Ty(context)) {
+                        indexValue = builder.CreateIntCast(indexValue, llvm::Type::getInt32Ty(context), true, "vidxcast");
+                    }
+
+                    llvm::Value* rval = generateExpr(assignStmt->getExpr());
+                    llvm::Type* elemType = llvm::cast<llvm::VectorType>(allocatedType)->getElementType();
+                    if (rval->getType() != elemType) {
+                        if (elemType->isFloatingPointTy() && rval->getType()->isIntegerTy()) {
+                            rval = builder.CreateSIToFP(rval, elemType, "int2float_elem");
+                        } else if (elemType->isIntegerTy() && rval->getType()->isFloatingPointTy()) {
+                            rval = builder.CreateFPToSI(rval, elemType, "float2int_elem");
+                        } else {
+                            throw std::runtime_error("Type mismatch in vector element assignment");
+                        }
                     }
+
+                    llvm::Value* newVec = builder.CreateInsertElement(vecValue, rval, indexValue, "vecins");
+                    builder.CreateStore(newVec, varPtr);
+                    return;
                 }
+            }
 
-                llvm::Value* newVec = builder.CreateInsertElement(vecValue, rval, indexValue, "vecins");
-                builder.CreateStore(newVec, varPtr);
-                return;
+            // 获取左值地址
+            llvm::Value* lvalAddr = generateLValAddress(lval);
+            // 生成右值表达式
+            llvm::Value* rval = generateExpr(assignStmt->getExpr());
+            // 目标元素类型已知时做 int/float 隐式转换
+            if (symOpt) {
+                llvm::Type* targetType = getStorageType(symOpt.value());
+                while (targetType && targetType->isArrayTy()) {
+                    targetType = targetType->getArrayElementType();
+                }
+                if (targetType && (targetType->isIntegerTy(32) || targetType->isFloatTy())) {
+                    rval = convertScalar(rval, targetType);
+                }
             }
+            // 存储值
+            builder.CreateStore(rval, lvalAddr);
+            return;
         }
-
-        // 获取左值地址
-        llvm::Value* lvalAddr = generateLValAddress(lval);
-        // 生成右值表达式
-        llvm::Value* rval = generateExpr(assignStmt->getExpr());
-        // 存储值
-        builder.CreateStore(rval, lvalAddr);
-        return;
-    }
-    
-    // 处理while语句
-    if (auto whileStmt = dynamic_cast<WhileStmtAST*>(stmt)) {
-        // 获取当前函数
-        llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
         
-        // 创建循环的基本块
-        llvm::BasicBlock* condBB = llvm::BasicBlock::Create(context, "whilecond", theFunction);
-        llvm::BasicBlock* loopBB = llvm::BasicBlock::Create(context, "whileloop");
-        llvm::BasicBlock* afterBB = llvm::BasicBlock::Create(context, "whileafter");
+        // 处理while语句
+        case ASTKind::WhileStmt: {
+            auto whileStmt = cast<WhileStmtAST>(stmt);
+            // 获取当前函数
+            llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
         
-        // 将break和continue目标压入栈
-        breakTargets.push_back(afterBB);
-        continueTargets.push_back(condBB);
+            // 创建循环的基本块
+            llvm::BasicBlock* condBB = llvm::BasicBlock::Create(context, "whilecond", theFunction);
+            llvm::BasicBlock* loopBB = llvm::BasicBlock::Create(context, "whileloop");
+            llvm::BasicBlock* afterBB = llvm::BasicBlock::Create(context, "whileafter");
         
-        // 跳转到条件块
-        builder.CreateBr(condBB);
+            // 将break和continue目标压入栈
+            breakTargets.push_back(afterBB);
+            continueTargets.push_back(condBB);
         
-        // 设置插入点到条件块
-        builder.SetInsertPoint(condBB);
+            // 跳转到条件块
+            builder.CreateBr(condBB);
         
-        // 生成条件表达式
-        llvm::Value* condValue = generateCondExpr(whileStmt->getCondition());
+            // 设置插入点到条件块
+            builder.SetInsertPoint(condBB);
         
-        // 将条件转换为布尔值
-        llvm::Value* boolValue = builder.CreateICmpNE(
-            condValue,
-            llvm::ConstantInt::get(condValue->getType(), 0),
-            "whilecond"
-        );
+            // 生成条件跳转
+            generateCondBranch(whileStmt->getCondition(), loopBB, afterBB);
         
-        // 创建条件跳转
-        builder.CreateCondBr(boolValue, loopBB, afterBB);
+            // 设置插入点到循环体
+            theFunction->insert(theFunction->end(), loopBB);
+            sealBlock(loopBB);
+            builder.SetInsertPoint(loopBB);
         
-        // 设置插入点到循环体
-        theFunction->insert(theFunction->end(), loopBB);
-        builder.SetInsertPoint(loopBB);
+            // 生成循环体
+            generateStmt(whileStmt->getBody());
         
-        // 生成循环体
-        generateStmt(whileStmt->getBody());
+            // 如果循环体没有终止指令，跳转回条件块
+            if (!builder.GetInsertBlock()->getTerminator()) {
+                builder.CreateBr(condBB);
+            }
         
-        // 如果循环体没有终止指令，跳转回条件块
-        if (!builder.GetInsertBlock()->getTerminator()) {
-            builder.CreateBr(condBB);
-        }
+            // 回边和 break 都已生成，封闭条件块和after块
+            sealBlock(condBB);
+            theFunction->insert(theFunction->end(), afterBB);
+            sealBlock(afterBB);
+            builder.SetInsertPoint(afterBB);
         
-        // 设置插入点到after块
-        theFunction->insert(theFunction->end(), afterBB);
-        builder.SetInsertPoint(afterBB);
+            // 弹出break和continue目标
+            breakTargets.pop_back();
+            continueTargets.pop_back();
         
-        // 弹出break和continue目标
-        breakTargets.pop_back();
-        continueTargets.pop_back();
+            return;
+        }
         
-        return;
-    }
-    
-    // 处理break语句
-    if (dynamic_cast<BreakStmtAST*>(stmt)) {
-        // 检查是否在循环中
-        if (breakTargets.empty()) {
-            throw std::runtime_error("Break statement outside of loop");
+        // 处理break语句
+        case ASTKind::BreakStmt: {
+            // 检查是否在循环中
+            if (breakTargets.empty()) {
+                throw std::runtime_error("Break statement outside of loop");
+            }
+            // 跳转到最近的break目标
+            builder.CreateBr(breakTargets.back());
+            return;
         }
-        // 跳转到最近的break目标
-        builder.CreateBr(breakTargets.back());
-        return;
-    }
-    
-    // 处理continue语句
-    if (dynamic_cast<ContinueStmtAST*>(stmt)) {
-        // 检查是否在循环中
-        if (continueTargets.empty()) {
-            throw std::runtime_error("Continue statement outside of loop");
+        
+        // 处理continue语句
+        case ASTKind::ContinueStmt: {
+            // 检查是否在循环中
+            if (continueTargets.empty()) {
+                throw std::runtime_error("Continue statement outside of loop");
+            }
+            // 跳转到最近的continue目标
+            builder.CreateBr(continueTargets.back());
+            return;
         }
-        // 跳转到最近的continue目标
-        builder.CreateBr(continueTargets.back());
-        return;
-    }
-    
-    // 处理代码块语句
-    if (auto blockStmt = dynamic_cast<BlockAST*>(stmt)) {
-        generateBlock(blockStmt);
-        return;
+        
+        // 处理代码块语句
+        case ASTKind::Block: {
+            auto blockStmt = cast<BlockAST>(stmt);
+            generateBlock(blockStmt);
+            return;
+        }
+        default:
+            break;
     }
 
     throw std::runtime_error("Unsupported statement type");
@@ -1021,15 +1401,25 @@ void IRGenerator::generateBlock(BlockAST* block) {
 
     // 遍历所有块项
     for (const auto& item : block->getItems()) {
+        // return/break/continue 之后的块项不可达，不再生成
+        if (builder.GetInsertBlock()->getTerminator()) {
+            break;
+        }
+
+        // 块项内申请的临时槽在块项结束后归还，供后续语句复用
+        size_t scratchMark = usedScratchSlots.size();
+        
         // 如果是声明块项，生成声明
-        if (auto declItem = dynamic_cast<DeclBlockItemAST*>(item.get())) {
+        if (auto declItem = dyn_cast<DeclBlockItemAST>(item.get())) {
             // 生成声明
             generateDecl(declItem->getDecl());
         }
         // 如果是语句块项，生成语句
-        else if (auto stmtItem = dynamic_cast<StmtBlockItemAST*>(item.get())) {
+        else if (auto stmtItem = dyn_cast<StmtBlockItemAST>(item.get())) {
             generateStmt(stmtItem->getStmt());
         }
+        
+        releaseScratchSlots(scratchMark);
     }
 
     // 退出当前作用域
@@ -1045,7 +1435,7 @@ llvm::Function* IRGenerator::generateFunction(FunctionAST* func) {
 
     // 检查函数名是否与全局符号冲突
     const std::string& funcName = func->getName();
-    auto existingSym = lookupSymbol(funcName);
+    auto existingSym = lookupSymbol(func->getIdentifier());
     if (existingSym) {
         throw std::runtime_error("Redeclaration of function '" + funcName + "'");
     }
@@ -1126,13 +1516,20 @@ llvm::Function* IRGenerator::generateFunction(FunctionAST* func) {
     // 设置插入点到入口基本块
     builder.SetInsertPoint(entryBB);
     
+    // 在入口块放置 alloca 占位指令，函数生成结束后删除
+    llvm::Type* int32Ty = llvm::Type::getInt32Ty(context);
+    allocaInsertPoint = new llvm::BitCastInst(llvm::UndefValue::get(int32Ty), int32Ty, "allocapt", entryBB);
+    
     // 保存当前函数
     llvm::Function* prevFunction = currentFunction;
     currentFunction = llvmFunc;
     
+    // 入口块没有前驱，直接封闭
+    sealBlock(entryBB);
+    
     // 第一步：为所有参数创建 alloca（但不加载数组指针）
     size_t idx = 0;
-    std::vector<std::tuple<std::string, llvm::AllocaInst*, bool, llvm::Type*, llvm::Type*>> paramInfo;
+    std::vector<std::tuple<Identifier, llvm::AllocaInst*, bool, llvm::Type*, llvm::Type*>> paramInfo;
     
     for (auto& arg : llvmFunc->args()) {
         const std::string& paramName = func->getParams()[idx]->getName();
@@ -1140,18 +1537,25 @@ llvm::Function* IRGenerator::generateFunction(FunctionAST* func) {
 
         bool isArray = func->getParams()[idx]->getIsArray();
         
+        // 直接 SSA 模式下标量参数直接作为入口块中的定义
+        if (!isArray && isSSACandidate(arg.getType())) {
+            int var = createSSAVariable(arg.getType(), paramName);
+            writeVariable(var, entryBB, &arg);
+            SymbolInfo symInfo(nullptr, false, false);
+            symInfo.ssaVar = var;
+            addSymbol(func->getParams()[idx]->getIdentifier(), symInfo);
+            idx++;
+            continue;
+        }
+        
         // 创建 alloca 存储参数值
-        llvm::AllocaInst* alloca = builder.CreateAlloca(
-            arg.getType(),
-            nullptr,
-            paramName + "_addr"
-        );
+        llvm::AllocaInst* alloca = createEntryBlockAlloca(arg.getType(), paramName + "_addr");
         
         builder.CreateStore(&arg, alloca);
         
         // 保存参数信息，稍后处理
         paramInfo.push_back(std::make_tuple(
-            paramName,
+            func->getParams()[idx]->getIdentifier(),
             alloca,
             isArray,
             arg.getType(),
@@ -1168,7 +1572,7 @@ llvm::Function* IRGenerator::generateFunction(FunctionAST* func) {
     }
 
     for (const auto& info : paramInfo) {
-        const std::string& paramName = std::get<0>(info);
+        const std::string& paramName = std::get<0>(info)->getName();
         llvm::AllocaInst* alloca = std::get<1>(info);
         bool isArray = std::get<2>(info);
         llvm::Type* argType = std::get<3>(info);
@@ -1184,7 +1588,7 @@ llvm::Function* IRGenerator::generateFunction(FunctionAST* func) {
         // 创建 SymbolInfo
         SymbolInfo symInfo(alloca, false, isArray, elemType);
         symInfo.loadedArrayPtr = loadedPtr;
-        addSymbol(paramName, symInfo);
+        addSymbol(std::get<0>(info), symInfo);
     }
 
     // 再次确认插入点仍在入口块
@@ -1216,6 +1620,13 @@ llvm::Function* IRGenerator::generateFunction(FunctionAST* func) {
     popScope();
     // 恢复当前函数
     currentFunction = prevFunction;
+    
+    // 删除 alloca 占位指令，清空本函数的临时槽
+    allocaInsertPoint->eraseFromParent();
+    allocaInsertPoint = nullptr;
+    freeScratchSlots.clear();
+    usedScratchSlots.clear();
+    resetSSAState();
 
 
     // 验证函数
@@ -1236,7 +1647,7 @@ void IRGenerator::generateDecl(DeclAST* decl) {
     }
     
     // 检查是否是变量声明
-    if (auto varDecl = dynamic_cast<VarDeclAST*>(decl)) {
+    if (auto varDecl = dyn_cast<VarDeclAST>(decl)) {
         // 获取变量类型
         llvm::Type* varType = getType(varDecl->getType());
         
@@ -1283,15 +1694,25 @@ void IRGenerator::generateDecl(DeclAST* decl) {
             // 判断是全局变量还是局部变量
             if (currentFunction == nullptr) {
                 // 全局变量：在创建之前检查是否已存在同名符号
-                auto existingSym = lookupSymbol(varName);
+                auto existingSym = lookupSymbol(varDef->getIdentifier());
                 if (existingSym) {
                     throw std::runtime_error("Redeclaration of global variable '" + varName + "'");
                 }
                 
+                // 全局数组：稀疏构建初始化值
+                if (!arraySizes.empty()) {
+                    llvm::GlobalVariable* globalArray = createGlobalArray(
+                        varName, elementType, varType, false, varDef->getInitVal(), arraySizes);
+                    SymbolInfo symInfo(globalArray, false, true);
+                    symInfo.valueType = elementType;
+                    addSymbol(varDef->getIdentifier(), symInfo);
+                    continue;
+                }
+                
                 // 全局变量
                 llvm::GlobalVariable* globalVar = new llvm::GlobalVariable(
                     *module,                    // 模块
-                    elementType,                // 类型（可能是数组类型）
+                    elementType,                // 类型
                     false,                      // 不是常量
                     llvm::GlobalValue::ExternalLinkage,  // 链接类型
                     nullptr,                    // 初始值（稍后设置）
@@ -1312,15 +1733,24 @@ void IRGenerator::generateDecl(DeclAST* decl) {
             }
             
             // 将变量添加到符号表
-            addSymbol(varName, SymbolInfo(globalVar, false, !arraySizes.empty()));
+            addSymbol(varDef->getIdentifier(), SymbolInfo(globalVar, false, !arraySizes.empty()));
+        } else if (arraySizes.empty() && isSSACandidate(elementType) &&
+                   (!varDef->getInitVal() || dyn_cast<ExprInitValAST>(varDef->getInitVal()))) {
+            // 直接 SSA 模式下的标量局部变量：不分配栈槽，初值作为当前定义
+            int var = createSSAVariable(elementType, varName);
+            llvm::Value* initValue = llvm::UndefValue::get(elementType);
+            if (auto exprInit = dyn_cast<ExprInitValAST>(varDef->getInitVal())) {
+                initValue = convertScalar(generateExpr(exprInit->getExpr()), elementType);
+            }
+            writeVariable(var, builder.GetInsertBlock(), initValue);
+
+            SymbolInfo symInfo(nullptr, false, false);
+            symInfo.ssaVar = var;
+            addSymbol(varDef->getIdentifier(), symInfo);
         } else {
             // 局部变量
-            // 在栈上分配空间
-            llvm::AllocaInst* alloca = builder.CreateAlloca(
-                elementType,
-                nullptr,
-                varName
-            );
+            // 在入口块分配栈空间（循环体内的声明也只分配一次）
+            llvm::AllocaInst* alloca = createEntryBlockAlloca(elementType, varName);
 
             // 如果有初始化值，设置它
             if (varDef->getInitVal()) {
@@ -1331,12 +1761,12 @@ void IRGenerator::generateDecl(DeclAST* decl) {
             // 注意：局部变量没有初始化值时，不需要设置默认值，因为其值是未定义的
 
             // 将变量添加到符号表
-            addSymbol(varName, SymbolInfo(alloca, false, !arraySizes.empty()));
+            addSymbol(varDef->getIdentifier(), SymbolInfo(alloca, false, !arraySizes.empty()));
             }
         }
     }
     // 检查是否是常量声明
-    else if (auto constDecl = dynamic_cast<ConstDeclAST*>(decl)) {
+    else if (auto constDecl = dyn_cast<ConstDeclAST>(decl)) {
         // 获取常量类型
         llvm::Type* constType = getType(constDecl->getType());
         
@@ -1381,11 +1811,24 @@ void IRGenerator::generateDecl(DeclAST* decl) {
             }
             
             // 全局常量：在创建之前检查是否已存在同名符号
-            auto existingSym = lookupSymbol(constName);
+            auto existingSym = lookupSymbol(constDef->getIdentifier());
             if (existingSym) {
                 throw std::runtime_error("Redeclaration of global constant '" + constName + "'");
             }
             
+            // 常量数组：稀疏构建初始化值
+            if (!arraySizes.empty()) {
+                if (!constDef->getInitVal()) {
+                    throw std::runtime_error("Constant '" + constName + "' must have an initializer");
+                }
+                llvm::GlobalVariable* globalArray = createGlobalArray(
+                    constName, elementType, constType, true, constDef->getInitVal(), arraySizes);
+                SymbolInfo symInfo(globalArray, true, true);
+                symInfo.valueType = elementType;
+                addSymbol(constDef->getIdentifier(), symInfo);
+                continue;
+            }
+            
             // 创建全局常量
             llvm::GlobalVariable* globalConst = new llvm::GlobalVariable(
                 *module,                    // 模块
@@ -1406,7 +1849,7 @@ void IRGenerator::generateDecl(DeclAST* decl) {
             }
             
             // 将常量添加到符号表
-            addSymbol(constName, SymbolInfo(globalConst, true, !arraySizes.empty()));
+            addSymbol(constDef->getIdentifier(), SymbolInfo(globalConst, true, !arraySizes.empty()));
         }
     } else {
         throw std::runtime_error("Unknown declaration type");
@@ -1438,7 +1881,7 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
         unsigned vecSize = vecType->getElementCount().getKnownMinValue();
 
         // 表达式初始化：要求类型为向量
-        if (auto exprInit = dynamic_cast<ExprInitValAST*>(initVal)) {
+        if (auto exprInit = dyn_cast<ExprInitValAST>(initVal)) {
             llvm::Value* value = generateExpr(exprInit->getExpr());
             if (value->getType() != targetType) {
                 throw std::runtime_error("Vector initializer must be a vector value");
@@ -1455,7 +1898,7 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
         }
 
         // 列表初始化
-        if (auto listInit = dynamic_cast<ListInitValAST*>(initVal)) {
+        if (auto listInit = dyn_cast<ListInitValAST>(initVal)) {
             const auto& initVals = listInit->getInitVals();
             if (initVals.size() > vecSize) {
                 throw std::runtime_error("Vector initializer has too many elements");
@@ -1467,7 +1910,7 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
                 for (unsigned i = 0; i < vecSize; ++i) {
                     llvm::Constant* elemConst = llvm::Constant::getNullValue(elemType);
                     if (i < initVals.size()) {
-                        auto exprVal = dynamic_cast<ExprInitValAST*>(initVals[i].get());
+                        auto exprVal = dyn_cast<ExprInitValAST>(initVals[i].get());
                         if (!exprVal) {
                             throw std::runtime_error("Vector initializer elements must be expressions");
                         }
@@ -1495,7 +1938,7 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
                 for (unsigned i = 0; i < vecSize; ++i) {
                     llvm::Value* elemValue = llvm::Constant::getNullValue(elemType);
                     if (i < initVals.size()) {
-                        auto exprVal = dynamic_cast<ExprInitValAST*>(initVals[i].get());
+                        auto exprVal = dyn_cast<ExprInitValAST>(initVals[i].get());
                         if (!exprVal) {
                             throw std::runtime_error("Vector initializer elements must be expressions");
                         }
@@ -1526,7 +1969,7 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
     }
     
     // 处理表达式初始化值
-    if (auto exprInit = dynamic_cast<ExprInitValAST*>(initVal)) {
+    if (auto exprInit = dyn_cast<ExprInitValAST>(initVal)) {
         // 单个表达式，直接设置值
         llvm::Value* value = generateExpr(exprInit->getExpr());
         
@@ -1579,7 +2022,7 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
         }
     }
     // 处理列表初始化值（数组）
-    else if (auto listInit = dynamic_cast<ListInitValAST*>(initVal)) {
+    else if (auto listInit = dyn_cast<ListInitValAST>(initVal)) {
         // 如果是空列表，表示所有元素初始化为0
         if (listInit->getInitVals().empty()) {
             llvm::Type* elementType;
@@ -1598,61 +2041,20 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
             llvm::Constant* zero = llvm::Constant::getNullValue(elementType);
             
             if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(ptr)) {
-                // 如果是全局变量，需要计算整个数组的零初始化值
-                if (dimensions > 0) {
-                    // 计算总元素数
-                    int totalElements = 1;
-                    for (int i = 0; i < dimensions; i++) {
-                        totalElements *= sizes[i];
-                    }
-                    
-                    // 创建零初始化的数组
-                    llvm::Type* elementType;
-                    if (auto allocaInst = llvm::dyn_cast<llvm::AllocaInst>(ptr)) {
-                        elementType = allocaInst->getAllocatedType();
-                    } else if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(ptr)) {
-                        elementType = globalVar->getValueType();
-                    } else {
-                        // 对于其他情况，尝试通过上下文推断类型
-                        if (auto gepInst = llvm::dyn_cast<llvm::GetElementPtrInst>(ptr)) {
-                            elementType = gepInst->getResultElementType();
-                        } else {
-                            throw std::runtime_error("Unable to determine pointer element type");
-                        }
-                    }
-                    while (llvm::isa<llvm::ArrayType>(elementType)) {
-                        elementType = llvm::cast<llvm::ArrayType>(elementType)->getElementType();
-                    }
-                    
-                    llvm::Constant* zeroElement = llvm::Constant::getNullValue(elementType);
-                    std::vector<llvm::Constant*> zeroElements(totalElements, zeroElement);
-                    
-                    // 构建多维数组的零初始化
-                    llvm::Type* arrayType;
-                    if (auto allocaInst = llvm::dyn_cast<llvm::AllocaInst>(ptr)) {
-                        arrayType = allocaInst->getAllocatedType();
-                    } else if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(ptr)) {
-                        arrayType = globalVar->getValueType();
-                    } else {
-                        // 对于其他情况，尝试通过上下文推断类型
-                        if (auto gepInst = llvm::dyn_cast<llvm::GetElementPtrInst>(ptr)) {
-                            arrayType = gepInst->getResultElementType();
-                        } else {
-                            throw std::runtime_error("Unable to determine pointer element type");
-                        }
-                    }
-                    llvm::Constant* zeroArray = llvm::ConstantArray::get(
-                        llvm::cast<llvm::ArrayType>(arrayType),
-                        zeroElements
-                    );
-                    
-                    globalVar->setInitializer(zeroArray);
-                } else {
-                    globalVar->setInitializer(zero);
+                // 全局数组由 createGlobalArray 处理，这里只会是标量
+                globalVar->setInitializer(zero);
+            } else if (dimensions > 0) {
+                // 局部数组：整体清零
+                int64_t totalElements = 1;
+                for (int i = 0; i < dimensions; i++) {
+                    totalElements *= sizes[i];
                 }
+                llvm::Type* scalarType = elementType;
+                while (llvm::isa<llvm::ArrayType>(scalarType)) {
+                    scalarType = llvm::cast<llvm::ArrayType>(scalarType)->getElementType();
+                }
+                generateLocalArrayInit({}, ptr, scalarType, totalElements);
             } else {
-                // 如果是局部变量，使用memset或循环初始化
-                // 这里简化处理，实际可能需要更复杂的逻辑
                 builder.CreateStore(zero, ptr);
             }
             return;
@@ -1687,164 +2089,311 @@ void IRGenerator::generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dim
         }
         
         // 计算总元素数
-        int totalElements = 1;
+        int64_t totalElements = 1;
         for (int i = 0; i < dimensions; i++) {
             totalElements *= sizes[i];
         }
         
-        // 生成全局变量初始化值
-        if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(ptr)) {
-            // 递归构建多维数组初始化值
-            std::function<llvm::Constant*(llvm::Type*, const std::vector<int>&, const std::vector<std::unique_ptr<InitValAST>>&, size_t&)> buildArrayInit;
-            buildArrayInit = [&](llvm::Type* type, const std::vector<int>& dims, const std::vector<std::unique_ptr<InitValAST>>& initVals, size_t& index) -> llvm::Constant* {
-                if (dims.empty()) {         // 到达最内层元素，返回单个初始化值
-                    // 到达最内层元素
-                    if (index < initVals.size()) {
-                        if (auto exprVal = dynamic_cast<ExprInitValAST*>(initVals[index].get())) {
-                            llvm::Value* val = generateExpr(exprVal->getExpr());
-                            if (!llvm::isa<llvm::Constant>(val)) {
-                                throw std::runtime_error("Global variable initializer must be a constant");
-                            }
-                            if (val->getType() != elementType) {
-                                throw std::runtime_error("Type mismatch in global variable initializer");
-                            }
-                            index++;
-                            return llvm::cast<llvm::Constant>(val);
-                        }
-                    }
-                    return llvm::Constant::getNullValue(elementType);
-                }
-                
-                // 处理当前维度
-                std::vector<llvm::Constant*> subInits;
-                int currentDimSize = dims[0];
-                std::vector<int> subDims(dims.begin() + 1, dims.end());
-                
-                for (int i = 0; i < currentDimSize; i++) {
-                    if (index < initVals.size()) {
-                        if (auto listVal = dynamic_cast<ListInitValAST*>(initVals[index].get())) {
-                            // 处理嵌套列表初始化
-                            size_t subIndex = 0;
-                            llvm::Constant* subInit = buildArrayInit(
-                                llvm::cast<llvm::ArrayType>(type)->getElementType(),
-                                subDims,
-                                listVal->getInitVals(),
-                                subIndex
-                            );
-                            subInits.push_back(subInit);
-                            index++;
-                        } else {
-                            // 处理扁平化初始化
-                            llvm::Constant* subInit = buildArrayInit(
-                                llvm::cast<llvm::ArrayType>(type)->getElementType(),
-                                subDims,
-                                initVals,
-                                index
-                            );
-                            subInits.push_back(subInit);
-                        }
-                    } else {
-                        // 填充默认值
-                        size_t dummyIndex = 0;
-                        llvm::Constant* subInit = buildArrayInit(
-                            llvm::cast<llvm::ArrayType>(type)->getElementType(),
-                            subDims,
-                            std::vector<std::unique_ptr<InitValAST>>(),
-                            dummyIndex
-                        );
-                        subInits.push_back(subInit);
-                    }
-                }
-                
-                return llvm::ConstantArray::get(
-                    llvm::cast<llvm::ArrayType>(type),
-                    subInits
-                );
-            };
-            
-            size_t index = 0;
-            llvm::Constant* arrayInit = buildArrayInit(arrayType, sizes, listInit->getInitVals(), index);
-            globalVar->setInitializer(arrayInit);
+        // 全局数组的初始化值在 createGlobalArray 中稀疏构建
+        if (llvm::isa<llvm::GlobalVariable>(ptr)) {
+            throw std::runtime_error("Global array initializer must be built by createGlobalArray");
+        }
+
+        // 局部变量初始化：展平后统一清零 + 写入显式元素
+        std::vector<std::pair<int64_t, ExprAST*>> elements;
+        size_t index = 0;
+        flattenInitList(listInit->getInitVals(), sizes, 0, index, 0, elements);
+        generateLocalArrayInit(elements, ptr, elementType, totalElements);
+    } else {
+        throw std::runtime_error("Unknown initializer type");
+    }
+}
+
+// 展平数组初始化列表（与全局数组初始化的花括号规则一致）：
+// 嵌套列表对齐到当前维度的子数组，裸表达式按顺序填充，剩余元素为 0
+void IRGenerator::flattenInitList(const std::vector<std::unique_ptr<InitValAST>>& initVals, const std::vector<int>& dims,
+                                  size_t dimIndex, size_t& index, int64_t base,
+                                  std::vector<std::pair<int64_t, ExprAST*>>& out) {
+    if (dimIndex == dims.size()) {
+        // 到达最内层元素
+        if (index < initVals.size()) {
+            InitValAST* init = initVals[index].get();
+            // 标量位置上的花括号取其第一个表达式
+            while (auto listVal = dyn_cast<ListInitValAST>(init)) {
+                init = listVal->getInitVals().empty() ? nullptr : listVal->getInitVals()[0].get();
+            }
+            if (auto exprVal = dyn_cast<ExprInitValAST>(init)) {
+                out.emplace_back(base, exprVal->getExpr());
+            }
+            index++;
+        }
+        return;
+    }
+
+    // 当前维度每个子数组的元素个数
+    int64_t stride = 1;
+    for (size_t d = dimIndex + 1; d < dims.size(); d++) {
+        stride *= dims[d];
+    }
+
+    for (int i = 0; i < dims[dimIndex] && index < initVals.size(); i++) {
+        int64_t subBase = base + i * stride;
+        if (auto listVal = dyn_cast<ListInitValAST>(initVals[index].get())) {
+            // 嵌套列表初始化一个完整的子数组
+            size_t subIndex = 0;
+            flattenInitList(listVal->getInitVals(), dims, dimIndex + 1, subIndex, subBase, out);
+            index++;
         } else {
-            // 局部变量初始化
-            // 递归初始化多维数组元素
-            std::function<void(llvm::Value*, llvm::Type*, const std::vector<int>&, const std::vector<std::unique_ptr<InitValAST>>&, size_t&)> initArrayElements;
-            initArrayElements = [&](llvm::Value* basePtr, llvm::Type* type, const std::vector<int>& dims, const std::vector<std::unique_ptr<InitValAST>>& initVals, size_t& index) {
-                if (dims.empty()) {
-                    // 到达最内层元素
-                    if (index < initVals.size()) {
-                        if (auto exprVal = dynamic_cast<ExprInitValAST*>(initVals[index].get())) {
-                            llvm::Value* val = generateExpr(exprVal->getExpr());
-                            if (val->getType() != elementType) {
-                                // 允许类型转换
-                                if (elementType->isIntegerTy() && val->getType()->isFloatTy()) {
-                                    val = builder.CreateFPToSI(val, elementType, "fptosi");
-                                } else if (elementType->isFloatTy() && val->getType()->isIntegerTy()) {
-                                    val = builder.CreateSIToFP(val, elementType, "sitofp");
-                                } else {
-                                    throw std::runtime_error("Type mismatch in array initializer");
-                                }
-                            }
-                            builder.CreateStore(val, basePtr);
-                            index++;
-                        }
-                    }
-                    return;
+            // 扁平化初始化
+            flattenInitList(initVals, dims, dimIndex + 1, index, subBase, out);
+        }
+    }
+}
+
+// 局部数组清零：小数组用 llvm.memset，超大数组用循环（O2 下可被向量化或识别回 memset）
+static constexpr int64_t kZeroFillLoopBytes = 64 * 1024;
+// 至少这么多个连续常量才从私有常量 memcpy，否则逐个 store
+static constexpr int64_t kInitMemcpyMinRun = 8;
+
+void IRGenerator::zeroFillArray(llvm::Value* flatPtr, llvm::Type* elementType, int64_t totalElements) {
+    int64_t elementBytes = elementType->getPrimitiveSizeInBits() / 8;
+    int64_t totalBytes = totalElements * elementBytes;
+    if (totalBytes == 0) {
+        return;
+    }
+    if (totalBytes <= kZeroFillLoopBytes) {
+        builder.CreateMemSet(flatPtr, builder.getInt8(0), builder.getInt64(totalBytes), llvm::MaybeAlign(4));
+        return;
+    }
+
+    llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* preheaderBB = builder.GetInsertBlock();
+    llvm::BasicBlock* loopBB = llvm::BasicBlock::Create(context, "zeroinit.loop", theFunction);
+    llvm::BasicBlock* afterBB = llvm::BasicBlock::Create(context, "zeroinit.end");
+    builder.CreateBr(loopBB);
+
+    builder.SetInsertPoint(loopBB);
+    llvm::PHINode* indexPhi = builder.CreatePHI(llvm::Type::getInt32Ty(context), 2, "zeroinit.idx");
+    indexPhi->addIncoming(builder.getInt32(0), preheaderBB);
+    llvm::Value* elementPtr = builder.CreateGEP(elementType, flatPtr, indexPhi, "elementptr");
+    builder.CreateStore(llvm::Constant::getNullValue(elementType), elementPtr);
+    llvm::Value* nextIndex = builder.CreateAdd(indexPhi, builder.getInt32(1), "zeroinit.next");
+    indexPhi->addIncoming(nextIndex, loopBB);
+    llvm::Value* done = builder.CreateICmpEQ(
+        nextIndex, builder.getInt32(static_cast<uint32_t>(totalElements)), "zeroinit.done");
+    builder.CreateCondBr(done, afterBB, loopBB);
+    sealBlock(loopBB);
+
+    theFunction->insert(theFunction->end(), afterBB);
+    sealBlock(afterBB);
+    builder.SetInsertPoint(afterBB);
+}
+
+void IRGenerator::generateLocalArrayInit(const std::vector<std::pair<int64_t, ExprAST*>>& elements, llvm::Value* ptr,
+                                         llvm::Type* elementType, int64_t totalElements) {
+    llvm::Value* flatPtr = builder.CreateBitCast(ptr, llvm::PointerType::get(elementType, 0), "arrayflat");
+
+    // 所有元素都显式初始化时无需清零
+    bool zeroFilled = static_cast<int64_t>(elements.size()) < totalElements;
+    if (zeroFilled) {
+        zeroFillArray(flatPtr, elementType, totalElements);
+    }
+
+    auto storeElement = [&](int64_t flatIndex, llvm::Value* value) {
+        llvm::Value* elementPtr = builder.CreateGEP(
+            elementType, flatPtr, builder.getInt32(static_cast<uint32_t>(flatIndex)), "elementptr");
+        builder.CreateStore(value, elementPtr);
+    };
+
+    // 连续下标的常量先攒起来，遇到不连续或非常量时统一写出
+    int64_t runStart = 0;
+    std::vector<llvm::Constant*> run;
+    auto flushRun = [&]() {
+        size_t first = 0;
+        size_t last = run.size();
+        if (zeroFilled) {
+            // 已清零，两端的 0 不必再写
+            while (first < last && run[first]->isNullValue()) first++;
+            while (last > first && run[last - 1]->isNullValue()) last--;
+        }
+        if (static_cast<int64_t>(last - first) >= kInitMemcpyMinRun) {
+            std::vector<llvm::Constant*> values(run.begin() + first, run.begin() + last);
+            auto runType = llvm::ArrayType::get(elementType, values.size());
+            auto runConst = new llvm::GlobalVariable(
+                *module, runType, true, llvm::GlobalValue::PrivateLinkage,
+                llvm::ConstantArray::get(runType, values), ptr->getName() + ".init");
+            runConst->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+            runConst->setAlignment(llvm::Align(4));
+
+            int64_t elementBytes = elementType->getPrimitiveSizeInBits() / 8;
+            llvm::Value* dstPtr = builder.CreateGEP(
+                elementType, flatPtr, builder.getInt32(static_cast<uint32_t>(runStart + first)), "elementptr");
+            builder.CreateMemCpy(dstPtr, llvm::MaybeAlign(4), runConst, llvm::MaybeAlign(4),
+                                 builder.getInt64(values.size() * elementBytes));
+        } else {
+            for (size_t i = first; i < last; i++) {
+                if (!zeroFilled || !run[i]->isNullValue()) {
+                    storeElement(runStart + static_cast<int64_t>(i), run[i]);
                 }
-                
-                // 处理当前维度
-                int currentDimSize = dims[0];
-                std::vector<int> subDims(dims.begin() + 1, dims.end());
-                
-                for (int i = 0; i < currentDimSize; i++) {
-                    std::vector<llvm::Value*> indices;
-                    indices.push_back(llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0));
-                    indices.push_back(llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), i));
-                    
-                    llvm::Value* elementPtr = builder.CreateGEP(type, basePtr, indices, "elementptr");
-                    
-                    if (index < initVals.size()) {
-                        if (auto listVal = dynamic_cast<ListInitValAST*>(initVals[index].get())) {
-                            // 处理嵌套列表初始化
-                            size_t subIndex = 0;
-                            initArrayElements(
-                                elementPtr,
-                                llvm::cast<llvm::ArrayType>(type)->getElementType(),
-                                subDims,
-                                listVal->getInitVals(),
-                                subIndex
-                            );
-                            index++;
-                        } else {
-                            // 处理扁平化初始化
-                            initArrayElements(
-                                elementPtr,
-                                llvm::cast<llvm::ArrayType>(type)->getElementType(),
-                                subDims,
-                                initVals,
-                                index
-                            );
-                        }
-                    } else {
-                        // 填充默认值
-                        size_t dummyIndex = 0;
-                        initArrayElements(
-                            elementPtr,
-                            llvm::cast<llvm::ArrayType>(type)->getElementType(),
-                            subDims,
-                            std::vector<std::unique_ptr<InitValAST>>(),
-                            dummyIndex
-                        );
-                    }
+            }
+        }
+        run.clear();
+    };
+
+    for (const auto& [flatIndex, expr] : elements) {
+        llvm::Value* val = generateExpr(expr);
+        if (val->getType() != elementType) {
+            // 允许类型转换
+            if (elementType->isIntegerTy() && val->getType()->isFloatTy()) {
+                val = builder.CreateFPToSI(val, elementType, "fptosi");
+            } else if (elementType->isFloatTy() && val->getType()->isIntegerTy()) {
+                val = builder.CreateSIToFP(val, elementType, "sitofp");
+            } else {
+                throw std::runtime_error("Type mismatch in array initializer");
+            }
+        }
+
+        if (auto constVal = llvm::dyn_cast<llvm::Constant>(val)) {
+            if (!run.empty() && runStart + static_cast<int64_t>(run.size()) != flatIndex) {
+                flushRun();
+            }
+            if (run.empty()) {
+                runStart = flatIndex;
+            }
+            run.push_back(constVal);
+        } else {
+            flushRun();
+            storeElement(flatIndex, val);
+        }
+    }
+    flushRun();
+}
+
+// 稀疏全局初始化值中，至少这么多个连续的全零子数组才单独拆成一个 zeroinitializer 字段
+static constexpr int64_t kSparseZeroRun = 16;
+
+// 按非零元素构建 type 类型（第 dimIndex 维起）的常量，entries[begin, end) 为落在本子数组内的
+// (扁平下标, 值)，base 为本子数组首元素的扁平下标。
+// 没有非零元素的子数组直接用 zeroinitializer；出现长段零或子数组类型被拆分时，
+// 改用匿名结构体按顺序拼接各段（元素都是 4 字节对齐，结构体布局与原数组一致）
+llvm::Constant* IRGenerator::buildSparseConstant(llvm::Type* type, const std::vector<int>& dims, size_t dimIndex,
+                                                 const std::vector<std::pair<int64_t, llvm::Constant*>>& entries,
+                                                 size_t begin, size_t end, int64_t base) {
+    if (begin == end) {
+        return llvm::Constant::getNullValue(type);
+    }
+    if (dimIndex == dims.size()) {
+        return entries[begin].second;
+    }
+
+    auto arrayType = llvm::cast<llvm::ArrayType>(type);
+    llvm::Type* subType = arrayType->getElementType();
+    int64_t stride = 1;
+    for (size_t d = dimIndex + 1; d < dims.size(); d++) {
+        stride *= dims[d];
+    }
+
+    std::vector<llvm::Constant*> fields;   // 结构体字段
+    std::vector<llvm::Constant*> pending;  // 尚未打包的、类型为 subType 的连续子数组
+    bool split = false;
+    auto flushPending = [&]() {
+        if (!pending.empty()) {
+            fields.push_back(llvm::ConstantArray::get(llvm::ArrayType::get(subType, pending.size()), pending));
+            pending.clear();
+        }
+    };
+    auto appendZeros = [&](int64_t count) {
+        if (count >= kSparseZeroRun) {
+            flushPending();
+            fields.push_back(llvm::ConstantAggregateZero::get(llvm::ArrayType::get(subType, count)));
+            split = true;
+        } else {
+            pending.insert(pending.end(), count, llvm::Constant::getNullValue(subType));
+        }
+    };
+
+    int64_t next = 0;  // 下一个尚未生成的子数组下标
+    size_t i = begin;
+    while (i < end) {
+        int64_t child = (entries[i].first - base) / stride;
+        size_t j = i;
+        while (j < end && (entries[j].first - base) / stride == child) {
+            j++;
+        }
+        appendZeros(child - next);
+
+        llvm::Constant* sub = buildSparseConstant(subType, dims, dimIndex + 1, entries, i, j, base + child * stride);
+        if (sub->getType() != subType) {
+            flushPending();
+            fields.push_back(sub);
+            split = true;
+        } else {
+            pending.push_back(sub);
+        }
+        next = child + 1;
+        i = j;
+    }
+
+    int64_t tail = dims[dimIndex] - next;
+    if (!split && tail < kSparseZeroRun) {
+        pending.insert(pending.end(), tail, llvm::Constant::getNullValue(subType));
+        return llvm::ConstantArray::get(arrayType, pending);
+    }
+    if (tail > 0) {
+        appendZeros(tail);
+    }
+    flushPending();
+    return llvm::ConstantStruct::getAnon(context, fields);
+}
+
+// 创建全局数组（变量或常量）。编译期内存只与非零初始化元素个数相关；
+// 全零数组得到 zeroinitializer，放入 .bss
+llvm::GlobalVariable* IRGenerator::createGlobalArray(const std::string& name, llvm::Type* arrayType, llvm::Type* elementType,
+                                                     bool isConst, InitValAST* initVal, const std::vector<int>& sizes) {
+    std::vector<std::pair<int64_t, llvm::Constant*>> entries;
+    if (auto listInit = dyn_cast<ListInitValAST>(initVal)) {
+        std::vector<std::pair<int64_t, ExprAST*>> elements;
+        size_t index = 0;
+        flattenInitList(listInit->getInitVals(), sizes, 0, index, 0, elements);
+
+        for (const auto& [flatIndex, expr] : elements) {
+            llvm::Value* val = generateExpr(expr);
+            if (!llvm::isa<llvm::Constant>(val)) {
+                throw std::runtime_error("Global variable initializer must be a constant");
+            }
+            llvm::Constant* cval = llvm::cast<llvm::Constant>(val);
+            if (cval->getType() != elementType) {
+                if (elementType->isIntegerTy() && cval->getType()->isFloatTy()) {
+                    cval = llvm::ConstantExpr::getFPToSI(cval, elementType);
+                } else if (elementType->isFloatTy() && cval->getType()->isIntegerTy()) {
+                    cval = llvm::ConstantExpr::getSIToFP(cval, elementType);
+                } else {
+                    throw std::runtime_error("Type mismatch in global variable initializer");
                 }
-            };
-            
-            size_t index = 0;
-            initArrayElements(ptr, arrayType, sizes, listInit->getInitVals(), index);
+            }
+            // 零值由 zeroinitializer 覆盖
+            if (!cval->isNullValue()) {
+                entries.emplace_back(flatIndex, cval);
+            }
         }
-    } else {
-        throw std::runtime_error("Unknown initializer type");
+    } else if (initVal) {
+        throw std::runtime_error("Array initializer must be a list");
+    }
+
+    llvm::Constant* init = buildSparseConstant(arrayType, sizes, 0, entries, 0, entries.size(), 0);
+    llvm::GlobalVariable* globalArray = new llvm::GlobalVariable(
+        *module,
+        init->getType(),            // 拆分后可能是结构体类型，访问时使用登记的数组类型
+        isConst,
+        llvm::GlobalValue::ExternalLinkage,
+        init,
+        name
+    );
+    globalArray->setAlignment(llvm::Align(4));
+    if (entries.empty()) {
+        globalArray->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
     }
+    return globalArray;
 }
 
 // 生成左值表达式的 IR
@@ -1856,25 +2405,41 @@ llvm::Value* IRGenerator::generateLVal(LValExprAST* lval) {
     const std::string& varName = lval->getName();
     
     // 查找变量
-    auto symOpt = lookupSymbol(varName);
+    auto symOpt = lookupSymbol(lval->getIdentifier());
     if (!symOpt) {
         throw std::runtime_error("Variable '" + varName + "' not defined");
     }
     
     // 立即获取需要的信息到局部变量
     SymbolInfo symInfo = symOpt.value();
+
+    // 直接 SSA 变量：读取当前基本块中的定义
+    if (symInfo.ssaVar >= 0) {
+        if (!lval->getIndices().empty()) {
+            throw std::runtime_error("Scalar variable '" + varName + "' cannot be indexed");
+        }
+        return readVariable(symInfo.ssaVar, builder.GetInsertBlock());
+    }
+
+    // 非数组常量直接使用其初始值（全局初始化表达式中引用常量时没有插入点，不能生成 load）
+    if (symInfo.isConst && !symInfo.isArray && lval->getIndices().empty()) {
+        if (auto globalConst = llvm::dyn_cast<llvm::GlobalVariable>(symInfo.value)) {
+            if (globalConst->hasInitializer()) {
+                return globalConst->getInitializer();
+            }
+        }
+    }
+    if (!builder.GetInsertBlock()) {
+        throw std::runtime_error("Global initializer must be a constant expression");
+    }
+
     llvm::Value* varPtr = symInfo.value;
     bool isArray = symInfo.isArray;
     llvm::Value* loadedArrayPtr = symInfo.loadedArrayPtr;
     llvm::Type* arrayElementType = symInfo.arrayElementType;
     
     // 首先检查是否是数组参数，如果是则直接使用预加载指针
-    llvm::Type* allocatedType = nullptr;
-    if (auto allocaInst = llvm::dyn_cast<llvm::AllocaInst>(varPtr)) {
-        allocatedType = allocaInst->getAllocatedType();
-    } else if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(varPtr)) {
-        allocatedType = globalVar->getValueType();
-    }
+    llvm::Type* allocatedType = getStorageType(symInfo);
     
     bool isArrayParam = isArray && allocatedType && allocatedType->isPointerTy();
     if (isArrayParam) {
@@ -2149,7 +2714,7 @@ llvm::Value* IRGenerator::generateCallExpr(CallExprAST* expr) {
                     // 如果期望的是指针类型，且当前值是数组或指针，尝试转换
                     if (expectedType->isPointerTy()) {
                         // 如果是左值表达式，获取其地址而不是值
-                        if (auto lvalExpr = dynamic_cast<LValExprAST*>(expr->getArgs()[i].get())) {
+                        if (auto lvalExpr = dyn_cast<LValExprAST>(expr->getArgs()[i].get())) {
                             // 生成左值地址
                             argValue = generateLValAddress(lvalExpr);
                         } else {
@@ -2198,7 +2763,7 @@ llvm::Value* IRGenerator::generateCallExpr(CallExprAST* expr) {
             // 对于putarray函数，第二个参数必须是数组指针
             if (i == 1 && libFuncIt->second.name == "putarray") {
                 // 如果是左值表达式，获取其地址而不是值
-                if (auto lvalExpr = dynamic_cast<LValExprAST*>(expr->getArgs()[i].get())) {
+                if (auto lvalExpr = dyn_cast<LValExprAST>(expr->getArgs()[i].get())) {
                     // 生成左值地址
                     argValue = generateLValAddress(lvalExpr);
                 } else {
@@ -2238,7 +2803,7 @@ llvm::Value* IRGenerator::generateLValAddress(LValExprAST* lval) {
     const std::string& varName = lval->getName();
 
     // 查找变量
-    auto symOpt = lookupSymbol(varName);
+    auto symOpt = lookupSymbol(lval->getIdentifier());
     if (!symOpt) {
         throw std::runtime_error("Variable '" + varName + "' not defined");
     }
@@ -2251,6 +2816,11 @@ llvm::Value* IRGenerator::generateLValAddress(LValExprAST* lval) {
         throw std::runtime_error("Cannot assign to constant '" + varName + "'");
     }
 
+    // 直接 SSA 变量没有内存地址
+    if (symInfo.ssaVar >= 0) {
+        throw std::runtime_error("Variable '" + varName + "' has no address");
+    }
+
     // 检查是否是数组名直接赋值（没有使用索引）
     // 注意：函数调用中的数组参数传递是合法的，真正的赋值检查在赋值语句中进行
     if (symInfo.isArray && lval->getIndices().empty()) {
@@ -2264,12 +2834,7 @@ llvm::Value* IRGenerator::generateLValAddress(LValExprAST* lval) {
     llvm::Type* arrayElementType = symInfo.arrayElementType;
 
     // 首先检查是否是数组参数，如果是则直接使用预加载指针
-    llvm::Type* allocatedType = nullptr;
-    if (auto allocaInst = llvm::dyn_cast<llvm::AllocaInst>(varPtr)) {
-        allocatedType = allocaInst->getAllocatedType();
-    } else if (auto globalVar = llvm::dyn_cast<llvm::GlobalVariable>(varPtr)) {
-        allocatedType = globalVar->getValueType();
-    }
+    llvm::Type* allocatedType = getStorageType(symInfo);
     
     bool isArrayParam = isArray && allocatedType && allocatedType->isPointerTy();
     if (isArrayParam) {
@@ -2341,7 +2906,7 @@ llvm::Value* IRGenerator::generateLValAddress(LValExprAST* lval) {
 
             llvm::Value* elem = builder.CreateExtractElement(vecValue, indexValue, "vecelem");
             llvm::Type* elemType = llvm::cast<llvm::VectorType>(allocatedType)->getElementType();
-            llvm::AllocaInst* tmp = builder.CreateAlloca(elemType, nullptr, "vec.elem.tmp");
+            llvm::AllocaInst* tmp = acquireScratchSlot(elemType, "vec.elem.tmp");
             builder.CreateStore(elem, tmp);
             return tmp;
         }
@@ -2399,7 +2964,7 @@ std::unique_ptr<llvm::Module> IRGenerator::generate(CompUnitAST* compUnit) {
     module = std::make_unique<llvm::Module>("SysY_Module", context);
 
     // 初始化作用域栈
-    symbolTableStack.clear();
+    resetScopes();
     pushScope();  // 创建全局作用域
     
     // 声明库函数
@@ -10,8 +10,11 @@
 #include <llvm/IR/Verifier.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/ValueHandle.h>
 #include <memory>
 #include <map>
+#include <set>
 #include <string>
 #include <functional>
 #include <optional>
@@ -30,27 +33,77 @@ private:
         bool isArray;                 // 是否是数组
         llvm::Type* arrayElementType; // 数组元素类型
         llvm::Value* loadedArrayPtr;  // 已加载的数组指针（用于数组参数）
+        int ssaVar;                   // 直接 SSA 模式下的变量编号（-1 表示使用栈槽）
+        llvm::Type* valueType;        // 存储的逻辑类型（稀疏全局数组的实际类型可能是结构体）
       
         SymbolInfo() : value(nullptr), isConst(false), isArray(false), 
-                       arrayElementType(nullptr), loadedArrayPtr(nullptr) {}
+                       arrayElementType(nullptr), loadedArrayPtr(nullptr), ssaVar(-1),
+                       valueType(nullptr) {}
       
         SymbolInfo(llvm::Value* v, bool c, bool a, llvm::Type* elemType = nullptr)
             : value(v), isConst(c), isArray(a), arrayElementType(elemType), 
-              loadedArrayPtr(nullptr) {}
+              loadedArrayPtr(nullptr), ssaVar(-1), valueType(nullptr) {}
     };
     
-    // 符号表栈：支持嵌套作用域
-    std::vector<std::map<std::string, SymbolInfo>> symbolTableStack;
+    // 符号表：按标识符编号（IdentifierInfo::getID()）直接索引的扁平表，每项是该名字当前可见的绑定。
+    // 嵌套作用域用撤销日志实现：addSymbol 记下被遮蔽的旧绑定，popScope 时按日志逆序恢复
+    struct SymbolBinding {
+        SymbolInfo info;
+        int depth = -1;               // 所在作用域深度，-1 表示未绑定
+    };
+    struct ShadowedBinding {
+        unsigned id;
+        SymbolBinding previous;
+    };
+    std::vector<SymbolBinding> symbolBindings;
+    std::vector<ShadowedBinding> scopeUndoLog;
+    std::vector<size_t> scopeMarks;   // 每层作用域开始时撤销日志的长度
     
     // 作用域管理函数
+    void resetScopes();
     void pushScope();
     void popScope();
-    std::optional<SymbolInfo> lookupSymbol(const std::string& name);
-    void addSymbol(const std::string& name, const SymbolInfo& info);
+    std::optional<SymbolInfo> lookupSymbol(Identifier name) const;
+    void addSymbol(Identifier name, const SymbolInfo& info);
+    llvm::Type* getStorageType(const SymbolInfo& info);
     
     // 当前函数
     llvm::Function* currentFunction;
     
+    // 入口块 alloca 分配器：局部变量、参数溢出槽和临时槽统一放在入口块开头，
+    // 避免循环体内出现动态 alloca，同时让 mem2reg/SROA 可以提升
+    llvm::Instruction* allocaInsertPoint = nullptr;                          // 入口块中的占位指令，alloca 插在它之前
+    std::map<llvm::Type*, std::vector<llvm::AllocaInst*>> freeScratchSlots;  // 按类型缓存的空闲临时槽
+    std::vector<llvm::AllocaInst*> usedScratchSlots;                         // 当前语句占用的临时槽
+    
+    llvm::AllocaInst* createEntryBlockAlloca(llvm::Type* type, const std::string& name);
+    llvm::AllocaInst* acquireScratchSlot(llvm::Type* type, const std::string& name);
+    void releaseScratchSlots(size_t mark);
+    
+    // 直接 SSA 构造（Braun 等人的算法）：标量 int/float 局部变量和参数不分配栈槽，
+    // 按基本块记录当前定义，读取时沿前驱查找，必要时插入 PHI；
+    // 基本块的前驱全部生成后封闭（seal），再补全其中未完成的 PHI
+    struct SSAVariable {
+        llvm::Type* type;
+        std::string name;
+    };
+    bool directSSA = false;
+    std::vector<SSAVariable> ssaVariables;                                             // 变量编号 -> 类型和名字
+    std::map<llvm::BasicBlock*, std::map<int, llvm::WeakTrackingVH>> ssaCurrentDef;    // 块内当前定义
+    std::map<llvm::BasicBlock*, std::map<int, llvm::PHINode*>> ssaIncompletePhis;      // 未封闭块中的 PHI
+    std::set<llvm::BasicBlock*> ssaSealedBlocks;
+    
+    bool isSSACandidate(llvm::Type* type) const;
+    int createSSAVariable(llvm::Type* type, const std::string& name);
+    void writeVariable(int var, llvm::BasicBlock* block, llvm::Value* value);
+    llvm::Value* readVariable(int var, llvm::BasicBlock* block);
+    llvm::Value* readVariableRecursive(int var, llvm::BasicBlock* block);
+    llvm::Value* addPhiOperands(int var, llvm::PHINode* phi);
+    llvm::Value* tryRemoveTrivialPhi(llvm::PHINode* phi);
+    void sealBlock(llvm::BasicBlock* block);
+    void resetSSAState();
+    llvm::Value* convertScalar(llvm::Value* value, llvm::Type* type);
+    
     // 循环上下文（用于break和continue）
     std::vector<llvm::BasicBlock*> breakTargets;
     std::vector<llvm::BasicBlock*> continueTargets;
@@ -77,6 +130,10 @@ private:
     llvm::Value* generateExpr(ExprAST* expr);
     llvm::Value* generateExprForArraySize(ExprAST* expr);
     llvm::Value* generateCondExpr(ExprAST* expr);
+    // 条件跳转生成：&&/|| 短路求值，直接跳转到真/假目标块
+    void generateCondBranch(ExprAST* expr, llvm::BasicBlock* trueBB, llvm::BasicBlock* falseBB);
+    llvm::Value* convertToBool(llvm::Value* value, const std::string& name);
+    llvm::Value* generateLogicalValue(BinaryExprAST* expr);
     void generateStmt(StmtAST* stmt);
     void generateBlock(BlockAST* block);
     llvm::Function* generateFunction(FunctionAST* func);
@@ -84,6 +141,20 @@ private:
     llvm::Value* generateLVal(LValExprAST* lval);
     llvm::Value* generateLValAddress(LValExprAST* lval);
     void generateInitVal(InitValAST* initVal, llvm::Value* ptr, int dimensions, const std::vector<int>& sizes);
+    // 数组初始化列表展平：按 SysY 花括号规则得到 (扁平下标, 表达式) 序列，未出现的元素为 0
+    void flattenInitList(const std::vector<std::unique_ptr<InitValAST>>& initVals, const std::vector<int>& dims,
+                         size_t dimIndex, size_t& index, int64_t base,
+                         std::vector<std::pair<int64_t, ExprAST*>>& out);
+    // 局部数组初始化：整体清零后只写入显式给出的元素，连续常量从私有常量 memcpy
+    void generateLocalArrayInit(const std::vector<std::pair<int64_t, ExprAST*>>& elements, llvm::Value* ptr,
+                                llvm::Type* elementType, int64_t totalElements);
+    void zeroFillArray(llvm::Value* flatPtr, llvm::Type* elementType, int64_t totalElements);
+    // 全局数组：按非零元素稀疏构建初始化值，全零子数组用 zeroinitializer，长段零拆成结构体字段
+    llvm::GlobalVariable* createGlobalArray(const std::string& name, llvm::Type* arrayType, llvm::Type* elementType,
+                                            bool isConst, InitValAST* initVal, const std::vector<int>& sizes);
+    llvm::Constant* buildSparseConstant(llvm::Type* type, const std::vector<int>& dims, size_t dimIndex,
+                                        const std::vector<std::pair<int64_t, llvm::Constant*>>& entries,
+                                        size_t begin, size_t end, int64_t base);
     llvm::Value* generateBinaryExpr(BinaryExprAST* expr);
     llvm::Value* generateUnaryExpr(UnaryExprAST* expr);
     llvm::Value* generateCallExpr(CallExprAST* expr);
@@ -123,6 +194,9 @@ public:
     void declareStarttimeFunction();
     void declareStoptimeFunction();
     
+    // 直接 SSA 构造：标量局部变量不经过 alloca/load/store
+    void setDirectSSA(bool enable) { directSSA = enable; }
+    
     // 获取模块（用于测试）
     llvm::Module* getModule() { return module.get(); }
 };
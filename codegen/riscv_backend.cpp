@@ -1,28 +1,210 @@
 #include "riscv_backend.h"
 #include <iostream>
+#include <mutex>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/IR/PassTimingInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/MC/MCAsmBackend.h>
+#include <llvm/MC/MCCodeEmitter.h>
+#include <llvm/MC/MCContext.h>
+#include <llvm/MC/MCObjectFileInfo.h>
+#include <llvm/MC/MCObjectWriter.h>
+#include <llvm/MC/MCParser/MCAsmParser.h>
+#include <llvm/MC/MCParser/MCTargetAsmParser.h>
+#include <llvm/MC/MCStreamer.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <set>
+#include <sstream>
+#include <thread>
+
+static const char* const TARGET_TRIPLE = "riscv64-unknown-linux-gnu";
+static const char* const TARGET_CPU = "generic-rv64";
+
+// 把一行汇编中的私有标签（.L 开头，如 .LBB0_1、.Lfunc_end0、.Lpcrel_hi0）改为 prefix 开头。
+// 各片段独立编号，拼接前必须改名；字符串字面量和注释中的内容不改
+static std::string renamePrivateLabels(const std::string& line, const std::string& prefix) {
+    std::string result;
+    bool inString = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (inString) {
+            result += c;
+            if (c == '\\' && i + 1 < line.size()) {
+                result += line[++i];
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        if (c == '"') {
+            inString = true;
+        } else if (c == '#') {
+            result.append(line, i, std::string::npos);
+            break;
+        } else if (c == '.' && i + 1 < line.size() && line[i + 1] == 'L') {
+            char prev = i > 0 ? line[i - 1] : ' ';
+            if (!std::isalnum(static_cast<unsigned char>(prev)) && prev != '_' && prev != '.' && prev != '$') {
+                result += prefix;
+                i++;
+                continue;
+            }
+        }
+        result += c;
+    }
+    return result;
+}
+
+// 用 machine 把模块生成为汇编文本
+static bool emitAssemblyText(llvm::TargetMachine& machine, llvm::Module& module, std::string& asmText) {
+    llvm::SmallString<0> buffer;
+    llvm::raw_svector_ostream stream(buffer);
+    llvm::legacy::PassManager pass;
+    if (machine.addPassesToEmitFile(pass, stream, nullptr, llvm::CGFT_AssemblyFile)) {
+        return false;
+    }
+    pass.run(module);
+    asmText = buffer.str().str();
+    return true;
+}
+
+// value 是否（经由常量表达式）被 func 中的指令使用
+static bool isUsedBy(const llvm::Value* value, const llvm::Function* func) {
+    for (const llvm::User* user : value->users()) {
+        if (auto inst = llvm::dyn_cast<llvm::Instruction>(user)) {
+            if (inst->getFunction() == func) {
+                return true;
+            }
+        } else if (llvm::isa<llvm::Constant>(user) && isUsedBy(user, func)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 取出一个代码片段：func 为空时是全部全局变量（私有常量除外）的定义，否则是该函数的定义与它用到的私有常量，
+// 其余符号只保留用到的声明。私有常量改为匿名（按片段内的顺序编号），片段的内容因此只取决于它自己，
+// 与模块中的其他函数无关。
+// 声明保持原来的 dso_local：片段最终拼接成同一个汇编文件，对其他片段中 internal 符号的引用
+// 直接解析到文件内的定义，这些符号不需要变成外部符号
+static std::unique_ptr<llvm::Module> extractFragment(const llvm::Module& module, const llvm::Function* func) {
+    llvm::ValueToValueMapTy valueMap;
+    std::unique_ptr<llvm::Module> part = llvm::CloneModule(module, valueMap, [&](const llvm::GlobalValue* value) {
+        if (!func) {
+            return llvm::isa<llvm::GlobalVariable>(value) && !value->hasPrivateLinkage();
+        }
+        return value == func || (value->hasPrivateLinkage() && isUsedBy(value, func));
+    });
+    
+    for (llvm::Function& other : llvm::make_early_inc_range(*part)) {
+        if (other.isDeclaration() && other.use_empty()) {
+            other.eraseFromParent();
+        }
+    }
+    for (llvm::GlobalVariable& global : llvm::make_early_inc_range(part->globals())) {
+        if (global.isDeclaration() && global.use_empty()) {
+            global.eraseFromParent();
+        } else if (global.hasPrivateLinkage()) {
+            global.setName("");
+        }
+    }
+    return part;
+}
+
+// 按片段顺序拼接汇编：第 i 个片段的私有标签加上 .Lp<i>_ 前缀；
+// 文件头的 .attribute/.file 只保留第一个片段的，结尾的 .note.GNU-stack 节只输出一次。
+// 每个片段的汇编都以 .text 开头，前一个片段结束时所在的节不影响后一个
+static std::string stitchFragments(const std::vector<std::string>& parts) {
+    std::string result;
+    std::string trailer;
+    for (size_t i = 0; i < parts.size(); i++) {
+        std::string prefix = ".Lp" + std::to_string(i) + "_";
+        std::istringstream lines(parts[i]);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (line.rfind("\t.section\t\".note.GNU-stack\"", 0) == 0) {
+                trailer = line;
+                continue;
+            }
+            if (i > 0 && (line.rfind("\t.attribute\t", 0) == 0 || line.rfind("\t.file\t", 0) == 0)) {
+                continue;
+            }
+            result += renamePrivateLabels(line, prefix);
+            result += '\n';
+        }
+    }
+    if (!trailer.empty()) {
+        result += trailer + "\n";
+    }
+    return result;
+}
 
 bool RISCVBackend::initializeTarget() {
-    // 初始化 RISC-V 目标
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmParsers();
-    llvm::InitializeAllAsmPrinters();
+    // 只初始化 RISC-V 目标，且整个进程只做一次（批量模式下多个 backend 共享）
+    static std::once_flag initFlag;
+    std::call_once(initFlag, [] {
+        LLVMInitializeRISCVTargetInfo();
+        LLVMInitializeRISCVTarget();
+        LLVMInitializeRISCVTargetMC();
+        LLVMInitializeRISCVAsmParser();
+        LLVMInitializeRISCVAsmPrinter();
+    });
     return true;
 }
 
-RISCVBackend::RISCVBackend(int optLevel) : optLevel(optLevel) {
-    // 设置目标三元组为 RISC-V 64
-    std::string targetTriple = "riscv64-unknown-linux-gnu";
+std::string RISCVBackend::getFeatureString(RVVMode rvvMode, unsigned vlen) {
+    std::string features = "+m,+a,+f,+d,+c";
+    if (rvvMode == RVVMode::Off) {
+        return features;
+    }
+    features += ",+v";
+    if (vlen > 0) {
+        features += ",+zvl" + std::to_string(vlen) + "b";
+    }
+    return features;
+}
+
+RISCVBackend::RISCVBackend(int optLevel, RVVMode rvvMode, unsigned vlen)
+    : optLevel(optLevel), rvvMode(rvvMode), vlen(vlen) {
+    // 定长模式必须知道 VLEN，未指定时取 V 扩展的最小值
+    if (this->rvvMode == RVVMode::Fixed && this->vlen == 0) {
+        this->vlen = 128;
+    }
+    
+    // 定长模式下让循环向量化器只用定长向量（等价于 opt -scalable-vectorization=off）
+    if (this->rvvMode != RVVMode::Off) {
+        auto& options = llvm::cl::getRegisteredOptions();
+        auto it = options.find("scalable-vectorization");
+        if (it != options.end()) {
+            it->second->addOccurrence(0, "scalable-vectorization",
+                                      this->rvvMode == RVVMode::Fixed ? "off" : "on");
+        }
+    }
     
+    targetMachine = createTargetMachine();
+}
+
+// 按当前的优化级别和 RVV 设置创建 TargetMachine（并行代码生成时每个工作线程各用一个）
+llvm::TargetMachine* RISCVBackend::createTargetMachine() const {
     std::string error;
-    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(TARGET_TRIPLE, error);
     
     if (!target) {
         std::cerr << "Error: " << error << std::endl;
-        targetMachine = nullptr;
-        return;
+        return nullptr;
     }
     
     // 设置目标选项
@@ -33,6 +215,8 @@ RISCVBackend::RISCVBackend(int optLevel) : optLevel(optLevel) {
     //opt.NoInfsFPMath = true;  // 禁用无穷大浮点运算
     //opt.EnableIPRA = true;
     //opt.EnableFastISel = true;
+    // 与 sim 中工具链的 -mabi=lp64d 一致：浮点参数经浮点寄存器传递，目标文件带 double-float 标志才能与之链接
+    opt.MCOptions.ABIName = "lp64d";
 
     auto RM = std::optional<llvm::Reloc::Model>(llvm::Reloc::PIC_);    
 
@@ -47,19 +231,20 @@ RISCVBackend::RISCVBackend(int optLevel) : optLevel(optLevel) {
 
     llvm::CodeModel::Model codeModel = llvm::CodeModel::Small;
     
-    targetMachine = target->createTargetMachine(
-        targetTriple,
-        "generic-rv64",  // CPU
-        "+m,+a,+f,+d,+c,+v",  // 特性：M/A/F/D/C + 向量扩展
+    llvm::TargetMachine* machine = target->createTargetMachine(
+        TARGET_TRIPLE,
+        TARGET_CPU,
+        getFeatureString(rvvMode, vlen),  // 特性：M/A/F/D/C + 向量扩展（可选 VLEN）
         opt,
         RM,
         codeModel,
         codeGenOptLevel
     );
     
-    if (!targetMachine) {
+    if (!machine) {
         std::cerr << "Error: Could not create target machine" << std::endl;
     }
+    return machine;
 }
 
 RISCVBackend::~RISCVBackend() {
@@ -68,8 +253,132 @@ RISCVBackend::~RISCVBackend() {
     }
 }
 
+bool RISCVBackend::optimizeModule(llvm::Module* module) {
+    // 分析管理器：注册顺序与 opt 保持一致
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+    
+    // 与 clang 一致：O2 及以上才开启展开；启用 RVV 时 O1 起就开启循环与 SLP 向量化
+    llvm::PipelineTuningOptions PTO;
+    PTO.LoopUnrolling = optLevel >= 2;
+    PTO.LoopInterleaving = optLevel >= 2;
+    PTO.LoopVectorization = rvvMode != RVVMode::Off && optLevel >= 1;
+    PTO.SLPVectorization = rvvMode != RVVMode::Off && optLevel >= 1;
+    
+    // 传入 TargetMachine，使 TTI/代价模型按 RISC-V（含 RVV）计算
+    llvm::PassInstrumentationCallbacks PIC;
+    
+    // -time-passes 等标准插桩（LLVM 计时由全局的 TimePassesIsEnabled 控制）
+    llvm::StandardInstrumentations SI(module->getContext(), false);
+    SI.registerCallbacks(PIC);
+    
+    // 按函数累计中端 pass 耗时；pass manager/adaptor 只是外壳，跳过以免重复计时
+    std::vector<std::pair<double, double>> passStarts;
+    if (timeReport) {
+        PIC.registerBeforeNonSkippedPassCallback([&](llvm::StringRef, llvm::Any) {
+            passStarts.emplace_back(TimeReport::wallMs(), TimeReport::threadCPUMs());
+        });
+        auto afterPass = [&, this](llvm::StringRef passID, const llvm::Function* func) {
+            auto start = passStarts.back();
+            passStarts.pop_back();
+            if (func && !llvm::isSpecialPass(passID, {"PassManager", "PassAdaptor"})) {
+                timeReport->record("function", func->getName().str(), TimeReport::wallMs() - start.first,
+                                   TimeReport::threadCPUMs() - start.second, 0);
+            }
+        };
+        PIC.registerAfterPassCallback([afterPass](llvm::StringRef passID, llvm::Any IR, const llvm::PreservedAnalyses&) {
+            const llvm::Function* func = nullptr;
+            if (const auto* F = llvm::any_cast<const llvm::Function*>(&IR)) {
+                func = *F;
+            } else if (const auto* L = llvm::any_cast<const llvm::Loop*>(&IR)) {
+                func = (*L)->getHeader()->getParent();
+            }
+            afterPass(passID, func);
+        });
+        PIC.registerAfterPassInvalidatedCallback([afterPass](llvm::StringRef passID, const llvm::PreservedAnalyses&) {
+            afterPass(passID, nullptr);
+        });
+    }
+    
+    llvm::PassBuilder PB(targetMachine, PTO, std::nullopt, &PIC);
+    
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+    
+    llvm::ModulePassManager MPM;
+    if (!passPipeline.empty()) {
+        if (auto err = PB.parsePassPipeline(MPM, passPipeline)) {
+            std::cerr << "Error: Invalid pass pipeline '" << passPipeline << "': "
+                      << llvm::toString(std::move(err)) << std::endl;
+            return false;
+        }
+    } else {
+        switch (optLevel) {
+            case 0: MPM = PB.buildO0DefaultPipeline(llvm::OptimizationLevel::O0); break;
+            case 1: MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O1); break;
+            case 3: MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3); break;
+            default: MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2); break;
+        }
+    }
+    
+    if (printPipeline) {
+        // 输出格式与 opt -print-pipeline-passes 相同，可直接回填给 --passes=
+        std::string pipelineText;
+        llvm::raw_string_ostream pipelineStream(pipelineText);
+        MPM.printPipeline(pipelineStream, [&PIC](llvm::StringRef className) {
+            auto passName = PIC.getPassNameForClassName(className);
+            return passName.empty() ? className : passName;
+        });
+        pipelineStream.flush();
+        std::cout << pipelineText << std::endl;
+    }
+    
+    MPM.run(*module, MAM);
+    
+    // 新 PassManager 的计时器属于 SI，需在其析构前取出
+    collectLLVMTimers();
+    return true;
+}
+
+void RISCVBackend::collectLLVMTimers() {
+    if (!timeReport || !timeReport->hasLLVMTimers()) {
+        return;
+    }
+    std::string text;
+    llvm::raw_string_ostream stream(text);
+    if (timeReport->isJSON()) {
+        llvm::TimerGroup::printAllJSONValues(stream, "");
+    } else {
+        llvm::TimerGroup::printAll(stream);
+    }
+    stream.flush();
+    llvm::TimerGroup::clearAll();
+    timeReport->appendLLVMTimers(text);
+}
 
-bool RISCVBackend::generateAssembly(llvm::Module* module, const std::string& outputFile) {
+
+void RISCVBackend::applyVectorAttributes(llvm::Module* module) {
+    if (rvvMode == RVVMode::Off) {
+        return;
+    }
+    // vscale = VLEN / 64；VLEN 已知时上下界相同，否则按 V 扩展允许的 128..65536 位
+    unsigned minVScale = vlen > 0 ? vlen / 64 : 2;
+    unsigned maxVScale = vlen > 0 ? vlen / 64 : 1024;
+    for (auto& func : *module) {
+        if (func.isDeclaration()) {
+            continue;
+        }
+        func.removeFnAttr(llvm::Attribute::VScaleRange);
+        func.addFnAttr(llvm::Attribute::getWithVScaleRangeArgs(module->getContext(), minVScale, maxVScale));
+    }
+}
+
+bool RISCVBackend::prepareModule(llvm::Module* module) {
     if (!targetMachine) {
         std::cerr << "Error: Target machine not initialized" << std::endl;
         return false;
@@ -77,7 +386,11 @@ bool RISCVBackend::generateAssembly(llvm::Module* module, const std::string& out
     
     // 设置模块的目标信息
     module->setDataLayout(targetMachine->createDataLayout());
-    module->setTargetTriple("riscv64-unknown-linux-gnu");
+    module->setTargetTriple(TARGET_TRIPLE);
+    applyVectorAttributes(module);
+    if (timeReport && timeReport->hasLLVMTimers()) {
+        llvm::TimePassesIsEnabled = true;
+    }
     
     
     // 验证模块，确保 IR 有效
@@ -89,7 +402,12 @@ bool RISCVBackend::generateAssembly(llvm::Module* module, const std::string& out
         return false;
     }
     
-    
+    // 运行中端优化
+    TimeReport::Scope optTimer(timeReport, "stage", "llvm-opt");
+    if (!optimizeModule(module)) {
+        return false;
+    }
+    optTimer.stop();
     
     // 优化后再次验证模块
     if (llvm::verifyModule(*module, &errorStream)) {
@@ -97,7 +415,10 @@ bool RISCVBackend::generateAssembly(llvm::Module* module, const std::string& out
         std::cerr << "Module verification failed after optimization: " << errorMsg << std::endl;
         return false;
     }
-    
+    return true;
+}
+
+bool RISCVBackend::emitFile(llvm::Module* module, const std::string& outputFile, llvm::CodeGenFileType fileType) {
     // 打开输出文件
     std::error_code ec;
     llvm::raw_fd_ostream dest(outputFile, ec, llvm::sys::fs::OF_None);
@@ -111,69 +432,344 @@ bool RISCVBackend::generateAssembly(llvm::Module* module, const std::string& out
     // 使用 Legacy Pass Manager 仅用于代码生成，因为它仍然是生成汇编代码的可靠方式
     llvm::legacy::PassManager pass;
     
-    // 添加代码生成 Pass
-    if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, llvm::CGFT_AssemblyFile)) {
+    // 添加代码生成 Pass（LLVM 17 中目标文件使用 CGFT_ObjectFile）
+    if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
         std::cerr << "TargetMachine can't emit a file of this type" << std::endl;
         return false;
     }
     
     // 运行 Pass
+    TimeReport::Scope codegenTimer(timeReport, "stage", "codegen");
     pass.run(*module);
+    codegenTimer.stop();
     dest.flush();
     
     return true;
 }
 
-bool RISCVBackend::generateObject(llvm::Module* module, const std::string& outputFile) {
-    if (!targetMachine) {
-        std::cerr << "Error: Target machine not initialized" << std::endl;
+bool RISCVBackend::generate(llvm::Module* module, const BackendOutputs& outputs) {
+    if (!prepareModule(module)) {
         return false;
     }
     
-    // 设置模块的目标信息
-    module->setDataLayout(targetMachine->createDataLayout());
-    module->setTargetTriple("riscv64-unknown-linux-gnu");
+    // 优化后的 IR
+    if (!outputs.llFile.empty()) {
+        std::error_code ec;
+        llvm::raw_fd_ostream llOut(outputs.llFile, ec, llvm::sys::fs::OF_Text);
+        if (ec) {
+            std::cerr << "Could not open file: " << ec.message() << std::endl;
+            return false;
+        }
+        module->print(llOut, nullptr);
+    }
+    if (!outputs.bcFile.empty()) {
+        std::error_code ec;
+        llvm::raw_fd_ostream bcOut(outputs.bcFile, ec, llvm::sys::fs::OF_None);
+        if (ec) {
+            std::cerr << "Could not open file: " << ec.message() << std::endl;
+            return false;
+        }
+        llvm::WriteBitcodeToFile(*module, bcOut);
+    }
     
-    // 验证模块，确保 IR 有效
-    std::string errorMsg;
-    llvm::raw_string_ostream errorStream(errorMsg);
-    if (llvm::verifyModule(*module, &errorStream)) {
-        errorStream.flush();
-        std::cerr << "Module verification failed: " << errorMsg << std::endl;
-        return false;
+    bool ok = true;
+    if (outputs.asmFile.empty() && outputs.objFile.empty()) {
+        // 只输出 IR
+    } else if (codegenThreads > 1 || fragmentCache) {
+        ok = emitFragments(module, outputs);
+    } else {
+        // 代码生成会改写 IR（CodeGenPrepare 等），同时输出汇编和目标文件时先对副本生成汇编
+        if (!outputs.asmFile.empty() && !outputs.objFile.empty()) {
+            std::unique_ptr<llvm::Module> copy = llvm::CloneModule(*module);
+            ok = emitFile(copy.get(), outputs.asmFile, llvm::CGFT_AssemblyFile);
+        } else if (!outputs.asmFile.empty()) {
+            ok = emitFile(module, outputs.asmFile, llvm::CGFT_AssemblyFile);
+        }
+        if (ok && !outputs.objFile.empty()) {
+            ok = emitFile(module, outputs.objFile, llvm::CGFT_ObjectFile);
+        }
+    }
+    collectLLVMTimers();
+    return ok;
+}
+
+bool RISCVBackend::generateAssembly(llvm::Module* module, const std::string& outputFile) {
+    BackendOutputs outputs;
+    outputs.asmFile = outputFile;
+    return generate(module, outputs);
+}
+
+bool RISCVBackend::generateObject(llvm::Module* module, const std::string& outputFile) {
+    BackendOutputs outputs;
+    outputs.objFile = outputFile;
+    return generate(module, outputs);
+}
+
+bool RISCVBackend::emitFragments(llvm::Module* module, const BackendOutputs& outputs) {
+    // 第一个片段是全局变量，其后按模块中的顺序每个有定义的函数一个
+    std::vector<const llvm::Function*> functions = {nullptr};
+    for (auto& func : *module) {
+        if (!func.isDeclaration()) {
+            functions.push_back(&func);
+        }
     }
     
+    // LLVMContext 不能跨线程共享：各片段序列化为 bitcode，在生成代码的线程中读回到独立的 context。
+    // 不论是否并行、是否命中缓存，每个片段都经过同样的序列化和代码生成，输出因此只取决于优化后的模块
+    std::vector<llvm::SmallString<0>> bitcodes(functions.size());
+    for (size_t i = 0; i < functions.size(); i++) {
+        std::unique_ptr<llvm::Module> part = extractFragment(*module, functions[i]);
+        if (i > 0) {
+            // 只有第一个片段保留源文件名（汇编的 .file），函数片段的内容与所在的文件无关
+            part->setSourceFileName("");
+            part->setModuleIdentifier("");
+        }
+        llvm::raw_svector_ostream stream(bitcodes[i]);
+        llvm::WriteBitcodeToFile(*part, stream, /*ShouldPreserveUseListOrder=*/true);
+    }
     
+    // 片段缓存的键：目标设置与片段的 bitcode（CompileCache::computeKey 另含编译器标识）
+    std::vector<std::string> keys(functions.size());
+    std::vector<std::string> partAsm(functions.size());
+    std::vector<size_t> pending;
+    fragmentCount = functions.size();
+    reusedFragments = 0;
+    std::string options = "fragment;O" + std::to_string(optLevel) + ";features=" + getFeatureString(rvvMode, vlen);
+    for (size_t i = 0; i < functions.size(); i++) {
+        if (fragmentCache) {
+            keys[i] = CompileCache::computeKey(bitcodes[i].str().str(), options);
+            std::vector<std::pair<std::string, std::string>> parts;
+            if (fragmentCache->lookupParts(keys[i], parts) && parts.size() == 1 && parts[0].first == "asm") {
+                partAsm[i] = std::move(parts[0].second);
+                reusedFragments++;
+                continue;
+            }
+        }
+        pending.push_back(i);
+    }
     
-    // 优化后再次验证模块
-    if (llvm::verifyModule(*module, &errorStream)) {
-        errorStream.flush();
-        std::cerr << "Module verification failed after optimization: " << errorMsg << std::endl;
-        return false;
+    TimeReport::Scope codegenTimer(timeReport, "stage", "codegen");
+    size_t threadCount = std::max<size_t>(1, std::min<size_t>(codegenThreads, pending.size()));
+    // 旧 PassManager 的 pass 计时器是进程全局的，多线程代码生成时关闭
+    bool timePasses = llvm::TimePassesIsEnabled;
+    if (threadCount > 1) {
+        llvm::TimePassesIsEnabled = false;
     }
     
-    // 打开输出文件
+    std::vector<std::string> partErrors(functions.size());
+    std::atomic<size_t> nextFragment(0);
+    // 调用线程使用 targetMachine，其余线程各自创建 TargetMachine
+    auto worker = [&](llvm::TargetMachine* machine) {
+        size_t next;
+        while ((next = nextFragment++) < pending.size()) {
+            size_t index = pending[next];
+            partErrors[index] = machine ? emitFragment(bitcodes[index], *machine, partAsm[index])
+                                        : "Could not create target machine";
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back([&]() {
+            std::unique_ptr<llvm::TargetMachine> machine(createTargetMachine());
+            worker(machine.get());
+        });
+    }
+    worker(targetMachine);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    llvm::TimePassesIsEnabled = timePasses;
+    for (size_t i = 0; i < partErrors.size(); i++) {
+        if (!partErrors[i].empty()) {
+            std::cerr << "Code generation failed in fragment " << i << ": " << partErrors[i] << std::endl;
+            return false;
+        }
+    }
+    codegenTimer.stop();
+    
+    if (fragmentCache) {
+        for (size_t index : pending) {
+            if (!fragmentCache->storeParts(keys[index], {{"asm", partAsm[index]}})) {
+                std::cerr << "Warning: Cannot write fragment cache entry to " << fragmentCache->getDirectory()
+                          << std::endl;
+                break;
+            }
+        }
+    }
+    return writeStitched(partAsm, outputs);
+}
+
+bool RISCVBackend::writeStitched(const std::vector<std::string>& parts, const BackendOutputs& outputs) {
+    std::string asmText = stitchFragments(parts);
+    if (!outputs.asmFile.empty()) {
+        std::error_code ec;
+        llvm::raw_fd_ostream dest(outputs.asmFile, ec, llvm::sys::fs::OF_Text);
+        if (ec) {
+            std::cerr << "Could not open file: " << ec.message() << std::endl;
+            return false;
+        }
+        dest << asmText;
+    }
+    if (!outputs.objFile.empty()) {
+        TimeReport::Scope assembleTimer(timeReport, "stage", "assemble");
+        return assembleObject(asmText, outputs.objFile);
+    }
+    return true;
+}
+
+std::string RISCVBackend::emitFragment(llvm::StringRef bitcode, llvm::TargetMachine& machine, std::string& asmText) {
+    llvm::LLVMContext context;
+    llvm::Expected<std::unique_ptr<llvm::Module>> part =
+        llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "fragment"), context);
+    if (!part) {
+        return llvm::toString(part.takeError());
+    }
+    if (!emitAssemblyText(machine, **part, asmText)) {
+        return "TargetMachine can't emit a file of this type";
+    }
+    return "";
+}
+
+// 把 value 中（经由常量表达式、聚合常量和全局变量初始化值）引用到的函数加入 pending
+static void collectReferencedFunctions(const llvm::Value* value, std::set<const llvm::Value*>& visited,
+                                       std::vector<llvm::Function*>& pending) {
+    if (!llvm::isa<llvm::Constant>(value) || !visited.insert(value).second) {
+        return;
+    }
+    if (auto func = llvm::dyn_cast<llvm::Function>(value)) {
+        pending.push_back(const_cast<llvm::Function*>(func));
+    } else if (auto global = llvm::dyn_cast<llvm::GlobalVariable>(value)) {
+        if (global->hasInitializer()) {
+            collectReferencedFunctions(global->getInitializer(), visited, pending);
+        }
+    } else if (!llvm::isa<llvm::GlobalValue>(value)) {
+        for (const llvm::Use& operand : llvm::cast<llvm::User>(value)->operands()) {
+            collectReferencedFunctions(operand.get(), visited, pending);
+        }
+    }
+}
+
+std::unique_ptr<llvm::Module> RISCVBackend::loadModule(const std::string& content, const std::string& name,
+                                                       llvm::LLVMContext& context, std::string& error) {
+    std::unique_ptr<llvm::MemoryBuffer> buffer = llvm::MemoryBuffer::getMemBufferCopy(content, name);
+    
+    // 文本 IR 只能整体解析
+    if (!llvm::isBitcode(reinterpret_cast<const unsigned char*>(buffer->getBufferStart()),
+                         reinterpret_cast<const unsigned char*>(buffer->getBufferEnd()))) {
+        llvm::SMDiagnostic diagnostic;
+        std::unique_ptr<llvm::Module> module = llvm::parseIR(buffer->getMemBufferRef(), diagnostic, context);
+        if (!module) {
+            llvm::raw_string_ostream stream(error);
+            diagnostic.print("", stream, /*ShowColors=*/false);
+            stream.flush();
+            while (!error.empty() && error.back() == '\n') {
+                error.pop_back();
+            }
+        }
+        return module;
+    }
+    
+    llvm::Expected<std::unique_ptr<llvm::Module>> lazy = llvm::getOwningLazyBitcodeModule(std::move(buffer), context);
+    if (!lazy) {
+        error = llvm::toString(lazy.takeError());
+        return nullptr;
+    }
+    std::unique_ptr<llvm::Module> module = std::move(*lazy);
+    
+    // 从外部可见的函数和全局变量的初始化值出发，只读入用得到的函数体
+    std::set<const llvm::Value*> visited;
+    std::vector<llvm::Function*> pending;
+    for (llvm::Function& func : *module) {
+        if (!func.hasLocalLinkage()) {
+            collectReferencedFunctions(&func, visited, pending);
+        }
+    }
+    for (llvm::GlobalVariable& global : module->globals()) {
+        collectReferencedFunctions(&global, visited, pending);
+    }
+    while (!pending.empty()) {
+        llvm::Function* func = pending.back();
+        pending.pop_back();
+        if (!func->isMaterializable()) {
+            continue;
+        }
+        if (llvm::Error err = func->materialize()) {
+            error = llvm::toString(std::move(err));
+            return nullptr;
+        }
+        for (const llvm::BasicBlock& block : *func) {
+            for (const llvm::Instruction& inst : block) {
+                for (const llvm::Use& operand : inst.operands()) {
+                    collectReferencedFunctions(operand.get(), visited, pending);
+                }
+            }
+        }
+    }
+    
+    // 剩下未读入的只有无人引用的内部函数：去掉函数体后删除
+    for (llvm::Function& func : llvm::make_early_inc_range(*module)) {
+        if (func.isMaterializable()) {
+            func.deleteBody();
+            if (func.use_empty()) {
+                func.eraseFromParent();
+            }
+        }
+    }
+    if (llvm::Error err = module->materializeAll()) {
+        error = llvm::toString(std::move(err));
+        return nullptr;
+    }
+    return module;
+}
+
+bool RISCVBackend::assembleObject(const std::string& asmText, const std::string& outputFile) {
+    // 复用 targetMachine 的 MC 层配置（特性、ABI），用内置汇编器把拼接后的汇编转成目标文件
+    const llvm::Target& target = targetMachine->getTarget();
+    const llvm::MCSubtargetInfo& subtarget = *targetMachine->getMCSubtargetInfo();
+    const llvm::MCTargetOptions& mcOptions = targetMachine->Options.MCOptions;
+    
+    llvm::SourceMgr sourceMgr;
+    sourceMgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer(asmText, "<partitions>"), llvm::SMLoc());
+    
+    llvm::MCContext context(targetMachine->getTargetTriple(), targetMachine->getMCAsmInfo(),
+                            targetMachine->getMCRegisterInfo(), &subtarget, &sourceMgr, &mcOptions);
+    std::unique_ptr<llvm::MCObjectFileInfo> objectFileInfo(target.createMCObjectFileInfo(context, /*PIC=*/true));
+    context.setObjectFileInfo(objectFileInfo.get());
+    
     std::error_code ec;
     llvm::raw_fd_ostream dest(outputFile, ec, llvm::sys::fs::OF_None);
-    
     if (ec) {
         std::cerr << "Could not open file: " << ec.message() << std::endl;
         return false;
     }
     
-    // 创建 Pass Manager
-    llvm::legacy::PassManager pass;
-    
-    // 修改：LLVM 17 中使用 CGFT_ObjectFile
-    if (targetMachine->addPassesToEmitFile(pass, dest, nullptr,
-                                           llvm::CGFT_ObjectFile)) {
-        std::cerr << "TargetMachine can't emit a file of this type" << std::endl;
+    const llvm::MCInstrInfo& instrInfo = *targetMachine->getMCInstrInfo();
+    std::unique_ptr<llvm::MCAsmBackend> asmBackend(
+        target.createMCAsmBackend(subtarget, *targetMachine->getMCRegisterInfo(), mcOptions));
+    std::unique_ptr<llvm::MCCodeEmitter> codeEmitter(target.createMCCodeEmitter(instrInfo, context));
+    if (!asmBackend || !codeEmitter) {
+        std::cerr << "Could not create the integrated assembler" << std::endl;
         return false;
     }
+    std::unique_ptr<llvm::MCObjectWriter> objectWriter = asmBackend->createObjectWriter(dest);
+    std::unique_ptr<llvm::MCStreamer> streamer(target.createMCObjectStreamer(
+        targetMachine->getTargetTriple(), context, std::move(asmBackend), std::move(objectWriter),
+        std::move(codeEmitter), subtarget, mcOptions.MCRelaxAll, mcOptions.MCIncrementalLinkerCompatible,
+        /*DWARFMustBeAtTheEnd=*/false));
     
-    // 运行 pass
-    pass.run(*module);
-    dest.flush();
-    
+    std::unique_ptr<llvm::MCAsmParser> parser(
+        llvm::createMCAsmParser(sourceMgr, context, *streamer, *targetMachine->getMCAsmInfo()));
+    std::unique_ptr<llvm::MCTargetAsmParser> targetParser(
+        target.createMCAsmParser(subtarget, *parser, instrInfo, mcOptions));
+    if (!targetParser) {
+        std::cerr << "Could not create the integrated assembler" << std::endl;
+        return false;
+    }
+    parser->setTargetParser(*targetParser);
+    if (parser->Run(/*NoInitialTextSection=*/false)) {
+        std::cerr << "Failed to assemble the stitched partitions" << std::endl;
+        return false;
+    }
     return true;
 }
@@ -10,20 +10,99 @@
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/MC/TargetRegistry.h>
 #include <llvm/Support/CodeGen.h>
+#include <llvm/Passes/PassBuilder.h>
 #include <string>
+#include "../support/time_report.h"
+#include "../support/compile_cache.h"
+
+// RVV 使用方式：关闭 / 按已知 VLEN 生成定长向量 / 生成可伸缩向量
+enum class RVVMode {
+    Off,
+    Fixed,
+    Scalable
+};
+
+// 一次代码生成要写出的文件，路径为空表示不输出该类产物
+struct BackendOutputs {
+    std::string asmFile;   // 汇编
+    std::string objFile;   // ELF 目标文件
+    std::string llFile;    // 中端优化后的 LLVM IR
+    std::string bcFile;    // 中端优化后的 LLVM bitcode
+};
 
 class RISCVBackend {
 private:
     llvm::TargetMachine* targetMachine;
     int optLevel;
+    RVVMode rvvMode;
+    unsigned vlen;               // 目标 VLEN（位），0 表示未知
+    std::string passPipeline;    // 自定义中端流水线（为空时按 -O 级别选择默认流水线）
+    bool printPipeline = false;  // 运行前打印实际使用的流水线
+    TimeReport* timeReport = nullptr;  // 非空时记录中端/代码生成及每个函数的耗时
+    unsigned codegenThreads = 0; // 并行代码生成的线程数，0 或 1 表示整个模块在调用线程上生成
+    CompileCache* fragmentCache = nullptr;  // 非空时按片段缓存汇编（增量编译）
+    unsigned fragmentCount = 0;  // 上一次代码生成的片段数
+    unsigned reusedFragments = 0; // 其中命中片段缓存的个数
+    
+    // 按当前的优化级别和 RVV 设置创建一个新的 TargetMachine
+    llvm::TargetMachine* createTargetMachine() const;
+    
+    // 优化 LLVM IR（新 PassManager，按 -O 级别或自定义流水线运行）
+    bool optimizeModule(llvm::Module* module);
+    
+    // 给函数加上 vscale_range，向量化代价模型与后端据此确定 VLEN
+    void applyVectorAttributes(llvm::Module* module);
+    
+    // 把 LLVM 自带的 pass 计时追加到报告并清零（避免进程退出时打印到 stderr）
+    void collectLLVMTimers();
+    
+    // 设置目标信息、验证并运行中端优化
+    bool prepareModule(llvm::Module* module);
+    
+    // 对已优化的整个模块运行代码生成，写出汇编或目标文件
+    bool emitFile(llvm::Module* module, const std::string& outputFile, llvm::CodeGenFileType fileType);
+    
+    // 按片段生成代码（多线程或增量编译时）：模块中每个有定义的函数一个片段，全部全局变量一个片段。各片段单独取出、
+    // 序列化为 bitcode，在 codegenThreads 个线程上分别生成汇编（设置了片段缓存时先按 bitcode 查缓存），
+    // 再按模块中的顺序拼接；需要目标文件时用内置汇编器汇编拼接结果
+    bool emitFragments(llvm::Module* module, const BackendOutputs& outputs);
     
-    // 优化 LLVM IR
-    void optimizeModule(llvm::Module* module);
+    // 在独立的 LLVMContext 中读回一个片段的 bitcode，用 machine 生成汇编，失败时返回错误信息
+    static std::string emitFragment(llvm::StringRef bitcode, llvm::TargetMachine& machine, std::string& asmText);
+    
+    // 汇编文本 -> ELF 目标文件
+    bool assembleObject(const std::string& asmText, const std::string& outputFile);
+    
+    // 按顺序拼接各部分的汇编，写出汇编文件和/或目标文件
+    bool writeStitched(const std::vector<std::string>& parts, const BackendOutputs& outputs);
     
 public:
-    explicit RISCVBackend(int optLevel = 0);
+    explicit RISCVBackend(int optLevel = 0, RVVMode rvvMode = RVVMode::Scalable, unsigned vlen = 0);
     ~RISCVBackend();
     
+    // 设置自定义流水线，语法同 opt -passes=...（如 "default<O2>"、"mem2reg,instcombine"）
+    void setPassPipeline(const std::string& pipeline) { passPipeline = pipeline; }
+    
+    // 是否打印中端流水线
+    void setPrintPipeline(bool enable) { printPipeline = enable; }
+    
+    // 设置耗时报告（为空时不计时）
+    void setTimeReport(TimeReport* report) { timeReport = report; }
+    
+    // 设置并行代码生成的线程数（大于 1 时按片段生成，输出与线程数无关；否则整个模块一起生成）
+    void setCodegenThreads(unsigned threads) { codegenThreads = threads; }
+    
+    // 设置片段缓存（为空时不使用）：设置后总是按片段生成代码，片段的键是它优化后的 bitcode，
+    // 命中时直接复用汇编，因此输出与不用缓存、按片段生成（codegenThreads > 1）时逐字节相同
+    void setFragmentCache(CompileCache* cache) { fragmentCache = cache; }
+    
+    // 上一次代码生成的片段数及其中复用缓存的个数
+    unsigned getFragmentCount() const { return fragmentCount; }
+    unsigned getReusedFragments() const { return reusedFragments; }
+    
+    // 中端优化只运行一次，再按 outputs 写出优化后的 IR、汇编和/或目标文件
+    bool generate(llvm::Module* module, const BackendOutputs& outputs);
+    
     // 生成汇编代码
     bool generateAssembly(llvm::Module* module, const std::string& outputFile);
     
@@ -32,4 +111,13 @@ public:
     
     // 初始化目标
     static bool initializeTarget();
+    
+    // 目标特性字符串（含 +v 与 +zvl<N>b）
+    static std::string getFeatureString(RVVMode rvvMode, unsigned vlen);
+    
+    // 加载 LLVM IR（文本 .ll 或 bitcode .bc，按内容判断），跳过前端直接交给 generate。
+    // bitcode 按需加载：只读入外部可见的函数及它们（传递地）引用的函数体，未被引用的内部函数直接丢弃。
+    // 失败时返回空并在 error 中给出原因
+    static std::unique_ptr<llvm::Module> loadModule(const std::string& content, const std::string& name,
+                                                    llvm::LLVMContext& context, std::string& error);
 };
@@ -2,6 +2,14 @@
 #include <fstream>
 #include <string>
 #include <cstdlib>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <array>
 #include "antlr4-runtime.h"
 #include "frontend/SysYLexer.h"
 #include "frontend/SysYParser.h"
@@ -9,7 +17,10 @@
 #include "ast/ast_optimizer.h"
 #include "codegen/ir_generator.h"
 #include "codegen/riscv_backend.h"
+#include "server/compile_server.h"
+#include "support/compile_cache.h"
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/ADT/SmallString.h>
 
 using namespace antlr4;
 using namespace std;
@@ -23,32 +34,102 @@ struct CompilerOptions {
     bool verbose = false;       // 详细输出
     bool help = false;          // 显示帮助
     int optLevel = 0;           // 优化级别：0-3，对应O0-O3
+    string passPipeline;        // 自定义中端流水线（--passes=）
+    bool printPipeline = false; // 打印中端流水线
+    bool directSSA = false;     // IR 生成时直接构造 SSA（--ssa）
+    int inlineBudget = 60;      // AST 函数内联预算（--inline-budget=，0 关闭）
+    int unrollFactor = 4;       // 循环部分展开因子（--unroll-factor=，0 关闭展开）
+    RVVMode rvvMode = RVVMode::Scalable;  // RVV 向量化方式（--rvv=）
+    int vlen = 0;               // 目标 VLEN 位数（--vlen=，0 表示未知）
+    bool batch = false;         // 批量编译模式（--batch）
+    int jobs = 0;               // 批量模式的线程数（-j，0 表示按 CPU 核数）
+    int codegenThreads = 0;     // 并行代码生成的线程数（--codegen-threads=，0 或 1 表示整个模块在编译线程上生成）
+    string outDir;              // 输出目录（--out-dir=）
+    vector<string> inputFiles;  // 批量模式下的全部输入文件
+    string serveSocket;         // 编译服务监听的套接字（--serve）
+    bool timeReport = false;    // 输出各阶段耗时（--time-report）
+    bool timeReportJSON = false; // 耗时报告输出为 JSON 文件（--time-report=json）
+    bool concurrent = false;    // 与其他文件并发编译（批量/服务模式）
+    bool emitAsm = true;        // 输出汇编（--emit=asm）
+    bool emitObj = false;       // 输出 ELF 目标文件（-c / --emit=obj）
+    bool emitLL = false;        // 输出中端优化后的 IR（--emit=ll）
+    bool emitBC = false;        // 输出中端优化后的 bitcode（--emit=bc）
+    string cacheDir;            // 编译缓存目录（--cache-dir=，为空时不使用缓存）
+    int cacheSizeMB = 256;      // 缓存总大小上限（--cache-size=，MB）
+    bool cacheStats = false;    // 结束时输出缓存统计（--cache-stats）
+    bool incremental = false;   // 按函数增量编译，优化后未改变的函数复用缓存中的汇编（--incremental）
     
     // 输出文件名
     string astFile;
     string irFile;
     string asmFile;
+    string objFile;
+    string llFile;
+    string bcFile;
+    string timeReportFile;
 };
 
 void printUsage(const char* progName) {
     cout << "SysY Compiler - RISC-V 64 Code Generator\n" << endl;
-    cout << "Usage: " << progName << " <input.sy> [options]\n" << endl;
+    cout << "Usage: " << progName << " <input.sy> [options]" << endl;
+    cout << "       " << progName << " <input.ll|input.bc> [options]  (LLVM IR input skips the frontend)\n" << endl;
     cout << "Options:" << endl;
-    cout << "  -o <file>        Specify output assembly file (default: output.s)" << endl;
+    cout << "  -o <file>        Specify output file (only when a single kind is emitted)" << endl;
+    cout << "  -c               Emit an ELF object file <input>.o instead of assembly" << endl;
+    cout << "  --emit=<kinds>   Comma-separated outputs from one compile: asm, obj, ll, bc (default: asm)" << endl;
+    cout << "                   (ll/bc are the optimized IR; --dump-ir writes the IR before optimization)" << endl;
     cout << "  --dump-ast       Output abstract syntax tree to <input>.ast" << endl;
     cout << "  --dump-ir        Output LLVM IR to <input>.ll" << endl;
     cout << "  -O <level>       Optimization level (0-3, default: O0)" << endl;
+    cout << "  --passes=<pipeline>  Run a custom LLVM pass pipeline instead of the -O default" << endl;
+    cout << "  --print-pipeline Print the LLVM pass pipeline before running it" << endl;
+    cout << "  --ssa            Build SSA form directly for scalar locals (no alloca/load/store)" << endl;
+    cout << "  --inline-budget=<n>  Inline functions of up to n AST nodes (default: 60, 0 disables)" << endl;
+    cout << "  --unroll-factor=<n>  Partially unroll counted loops n times (default: 4, 1 full unroll only, 0 disables)" << endl;
+    cout << "  --rvv=<mode>     RVV vectorization: off, fixed or scalable (default: scalable)" << endl;
+    cout << "  --vlen=<bits>    Target vector length, power of two in 128-65536 (fixed default: 128)" << endl;
+    cout << "  --batch          Compile every input file in one process" << endl;
+    cout << "  --file-list=<file>  Read input files from <file>, one per line (implies --batch)" << endl;
+    cout << "  -j <n>           Number of worker threads in batch mode (default: CPU count)" << endl;
+    cout << "  --codegen-threads=<n>  Run code generation per function on n threads (same output for every n > 1)" << endl;
+    cout << "  --out-dir=<dir>  Write output files into <dir>" << endl;
+    cout << "  --serve <socket> Run as a compile server on a Unix socket (-j sets worker count)" << endl;
+    cout << "  --connect <socket> <args...>  Send a compile request to a running server (must come first)" << endl;
+    cout << "  --cache-dir=<dir>  Reuse outputs of identical compilations stored in <dir>" << endl;
+    cout << "  --cache-size=<MB>  Evict least recently used cache entries above this size (default: 256)" << endl;
+    cout << "  --cache-stats    Print cache hit/miss statistics when done" << endl;
+    cout << "  --incremental    Cache code per function and only regenerate functions whose optimized IR changed" << endl;
+    cout << "                   (needs --cache-dir; output is identical to --codegen-threads=<n> with n > 1)" << endl;
+    cout << "  --time-report[=json]  Report wall/CPU time and peak RSS per stage, AST pass and function" << endl;
+    cout << "                   (text to stderr, json to <input>.time.json)" << endl;
     cout << "  -v, --verbose    Enable verbose output" << endl;
     cout << "  -h, --help       Display this help message" << endl;
     cout << "\nExamples:" << endl;
     cout << "  " << progName << " test.sy                    # Generate test.s" << endl;
     cout << "  " << progName << " test.sy -o out.s          # Generate out.s" << endl;
     cout << "  " << progName << " test.sy -O2               # Generate optimized code with O2" << endl;
+    cout << "  " << progName << " test.sy -O2 -c            # Generate test.o directly" << endl;
+    cout << "  " << progName << " test.sy --emit=asm,obj,ll # Generate test.s, test.o and test.ll" << endl;
     cout << "  " << progName << " test.sy --dump-ast --dump-ir  # Debug mode" << endl;
+    cout << "  " << progName << " test.sy --emit=bc -O0 -o frozen.bc  # Freeze the frontend output" << endl;
+    cout << "  " << progName << " frozen.bc -O2 -o test.s    # Run only the backend on it" << endl;
+    cout << "  " << progName << " test.sy -O2 --rvv=fixed --vlen=256  # Vectorize for VLEN=256" << endl;
+    cout << "  " << progName << " --batch tests/*.sy -j 8 --out-dir=out  # Batch mode" << endl;
+    cout << "  " << progName << " --serve /tmp/sysyc.sock -j 4 &  # Start a compile server" << endl;
+    cout << "  " << progName << " --connect /tmp/sysyc.sock test.sy -O2  # Compile through the server" << endl;
+    cout << "  " << progName << " test.sy --passes='function(mem2reg,instcombine)'  # Custom pipeline" << endl;
     cout << endl;
 }
 
-bool parseArguments(int argc, char* argv[], CompilerOptions& options) {
+// 输入是 LLVM IR（.ll 文本或 .bc bitcode）时跳过前端，直接交给后端
+bool isIRInput(const string& path) {
+    auto endsWith = [&](const string& suffix) {
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith(".ll") || endsWith(".bc");
+}
+
+bool parseArguments(int argc, char* argv[], CompilerOptions& options, ostream& err = cerr) {
     if (argc < 2) {
         return false;
     }
@@ -64,7 +145,7 @@ bool parseArguments(int argc, char* argv[], CompilerOptions& options) {
             if (i + 1 < argc) {
                 options.outputFile = argv[++i];
             } else {
-                cerr << "Error: -o requires an argument" << endl;
+                err << "Error: -o requires an argument" << endl;
                 return false;
             }
         }
@@ -74,15 +155,15 @@ bool parseArguments(int argc, char* argv[], CompilerOptions& options) {
                 try {
                     options.optLevel = stoi(optStr);
                     if (options.optLevel < 0 || options.optLevel > 3) {
-                        cerr << "Error: Optimization level must be between 0 and 3" << endl;
+                        err << "Error: Optimization level must be between 0 and 3" << endl;
                         return false;
                     }
                 } catch (const invalid_argument&) {
-                    cerr << "Error: Invalid optimization level: " << optStr << endl;
+                    err << "Error: Invalid optimization level: " << optStr << endl;
                     return false;
                 }
             } else {
-                cerr << "Error: -O requires an argument" << endl;
+                err << "Error: -O requires an argument" << endl;
                 return false;
             }
         }
@@ -92,11 +173,204 @@ bool parseArguments(int argc, char* argv[], CompilerOptions& options) {
             try {
                 options.optLevel = stoi(optStr);
                 if (options.optLevel < 0 || options.optLevel > 3) {
-                    cerr << "Error: Optimization level must be between 0 and 3" << endl;
+                    err << "Error: Optimization level must be between 0 and 3" << endl;
                     return false;
                 }
             } catch (const invalid_argument&) {
-                cerr << "Error: Invalid optimization level: " << optStr << endl;
+                err << "Error: Invalid optimization level: " << optStr << endl;
+                return false;
+            }
+        }
+        else if (arg.rfind("--passes=", 0) == 0) {
+            options.passPipeline = arg.substr(9);
+            if (options.passPipeline.empty()) {
+                err << "Error: --passes requires a pipeline" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--print-pipeline") {
+            options.printPipeline = true;
+        }
+        else if (arg == "--ssa") {
+            options.directSSA = true;
+        }
+        else if (arg.rfind("--inline-budget=", 0) == 0) {
+            string budgetStr = arg.substr(16);
+            try {
+                options.inlineBudget = stoi(budgetStr);
+            } catch (const exception&) {
+                options.inlineBudget = -1;
+            }
+            if (options.inlineBudget < 0) {
+                err << "Error: Invalid inline budget: " << budgetStr << endl;
+                return false;
+            }
+        }
+        else if (arg.rfind("--unroll-factor=", 0) == 0) {
+            string factorStr = arg.substr(16);
+            try {
+                options.unrollFactor = stoi(factorStr);
+            } catch (const exception&) {
+                options.unrollFactor = -1;
+            }
+            if (options.unrollFactor < 0 || options.unrollFactor > 64) {
+                err << "Error: Invalid unroll factor: " << factorStr << endl;
+                return false;
+            }
+        }
+        else if (arg.rfind("--rvv=", 0) == 0) {
+            string modeStr = arg.substr(6);
+            if (modeStr == "off") {
+                options.rvvMode = RVVMode::Off;
+            } else if (modeStr == "fixed") {
+                options.rvvMode = RVVMode::Fixed;
+            } else if (modeStr == "scalable") {
+                options.rvvMode = RVVMode::Scalable;
+            } else {
+                err << "Error: Invalid RVV mode: " << modeStr << endl;
+                return false;
+            }
+        }
+        else if (arg.rfind("--vlen=", 0) == 0) {
+            string vlenStr = arg.substr(7);
+            try {
+                options.vlen = stoi(vlenStr);
+            } catch (const exception&) {
+                options.vlen = -1;
+            }
+            // V 扩展要求 VLEN 为 2 的幂，且在 128..65536 之间
+            if (options.vlen < 128 || options.vlen > 65536 || (options.vlen & (options.vlen - 1)) != 0) {
+                err << "Error: Invalid VLEN: " << vlenStr << endl;
+                return false;
+            }
+        }
+        else if (arg == "--serve" || arg.rfind("--serve=", 0) == 0) {
+            if (arg.size() > 7) {
+                options.serveSocket = arg.substr(8);
+            } else if (i + 1 < argc) {
+                options.serveSocket = argv[++i];
+            }
+            if (options.serveSocket.empty()) {
+                err << "Error: --serve requires a socket path" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--time-report" || arg == "--time-report=text") {
+            options.timeReport = true;
+            options.timeReportJSON = false;
+        }
+        else if (arg == "--time-report=json") {
+            options.timeReport = true;
+            options.timeReportJSON = true;
+        }
+        else if (arg == "--batch") {
+            options.batch = true;
+        }
+        else if (arg.rfind("--file-list=", 0) == 0) {
+            string listFile = arg.substr(12);
+            ifstream list(listFile);
+            if (!list.is_open()) {
+                err << "Error: Cannot open file list: " << listFile << endl;
+                return false;
+            }
+            string line;
+            while (getline(list, line)) {
+                // 去掉首尾空白，跳过空行和 # 注释
+                size_t begin = line.find_first_not_of(" \t\r");
+                if (begin == string::npos || line[begin] == '#') {
+                    continue;
+                }
+                size_t end = line.find_last_not_of(" \t\r");
+                options.inputFiles.push_back(line.substr(begin, end - begin + 1));
+            }
+            options.batch = true;
+        }
+        else if (arg == "-j" || (arg.rfind("-j", 0) == 0 && arg.size() > 2)) {
+            string jobsStr;
+            if (arg.size() > 2) {
+                jobsStr = arg.substr(2);
+            } else if (i + 1 < argc) {
+                jobsStr = argv[++i];
+            } else {
+                err << "Error: -j requires an argument" << endl;
+                return false;
+            }
+            try {
+                options.jobs = stoi(jobsStr);
+            } catch (const exception&) {
+                options.jobs = -1;
+            }
+            if (options.jobs < 1) {
+                err << "Error: Invalid job count: " << jobsStr << endl;
+                return false;
+            }
+        }
+        else if (arg.rfind("--codegen-threads=", 0) == 0) {
+            string threadsStr = arg.substr(18);
+            try {
+                options.codegenThreads = stoi(threadsStr);
+            } catch (const exception&) {
+                options.codegenThreads = -1;
+            }
+            if (options.codegenThreads < 1) {
+                err << "Error: Invalid codegen thread count: " << threadsStr << endl;
+                return false;
+            }
+        }
+        else if (arg.rfind("--cache-dir=", 0) == 0) {
+            options.cacheDir = arg.substr(12);
+            if (options.cacheDir.empty()) {
+                err << "Error: --cache-dir requires a directory" << endl;
+                return false;
+            }
+        }
+        else if (arg.rfind("--cache-size=", 0) == 0) {
+            string sizeStr = arg.substr(13);
+            try {
+                options.cacheSizeMB = stoi(sizeStr);
+            } catch (const exception&) {
+                options.cacheSizeMB = -1;
+            }
+            if (options.cacheSizeMB < 1) {
+                err << "Error: Invalid cache size: " << sizeStr << endl;
+                return false;
+            }
+        }
+        else if (arg == "--cache-stats") {
+            options.cacheStats = true;
+        }
+        else if (arg == "--incremental") {
+            options.incremental = true;
+        }
+        else if (arg.rfind("--out-dir=", 0) == 0) {
+            options.outDir = arg.substr(10);
+        }
+        else if (arg == "-c") {
+            options.emitAsm = false;
+            options.emitObj = true;
+            options.emitLL = false;
+            options.emitBC = false;
+        }
+        else if (arg.rfind("--emit=", 0) == 0) {
+            options.emitAsm = options.emitObj = options.emitLL = options.emitBC = false;
+            stringstream kinds(arg.substr(7));
+            string kind;
+            while (getline(kinds, kind, ',')) {
+                if (kind == "asm") {
+                    options.emitAsm = true;
+                } else if (kind == "obj") {
+                    options.emitObj = true;
+                } else if (kind == "ll") {
+                    options.emitLL = true;
+                } else if (kind == "bc") {
+                    options.emitBC = true;
+                } else {
+                    err << "Error: Invalid --emit kind: " << kind << endl;
+                    return false;
+                }
+            }
+            if (!options.emitAsm && !options.emitObj && !options.emitLL && !options.emitBC) {
+                err << "Error: --emit requires at least one of asm, obj, ll, bc" << endl;
                 return false;
             }
         }
@@ -110,22 +384,54 @@ bool parseArguments(int argc, char* argv[], CompilerOptions& options) {
             options.verbose = true;
         }
         else if (arg[0] != '-') {
-            if (options.inputFile.empty()) {
-                options.inputFile = arg;
-            } else {
-                cerr << "Error: Multiple input files specified" << endl;
-                return false;
-            }
+            options.inputFiles.push_back(arg);
         }
         else {
-            cerr << "Error: Unknown option: " << arg << endl;
+            err << "Error: Unknown option: " << arg << endl;
             return false;
         }
     }
     
-    if (options.inputFile.empty() && !options.help) {
-        cerr << "Error: No input file specified" << endl;
+    if (options.help || !options.serveSocket.empty()) {
+        return true;
+    }
+    
+    if (options.inputFiles.empty()) {
+        err << "Error: No input file specified" << endl;
+        return false;
+    }
+    
+    if (options.cacheStats && options.cacheDir.empty()) {
+        err << "Error: --cache-stats requires --cache-dir" << endl;
+        return false;
+    }
+    if (options.incremental && options.cacheDir.empty()) {
+        err << "Error: --incremental requires --cache-dir" << endl;
+        return false;
+    }
+    if (options.dumpAST && any_of(options.inputFiles.begin(), options.inputFiles.end(), isIRInput)) {
+        err << "Error: --dump-ast needs SysY source, not LLVM IR input" << endl;
+        return false;
+    }
+    if (options.dumpIR && options.emitLL) {
+        err << "Error: --dump-ir and --emit=ll both write <input>.ll" << endl;
+        return false;
+    }
+    if (!options.outputFile.empty() && options.emitAsm + options.emitObj + options.emitLL + options.emitBC > 1) {
+        err << "Error: -o cannot be used when emitting several kinds of output" << endl;
+        return false;
+    }
+    
+    if (options.batch) {
+        if (!options.outputFile.empty()) {
+            err << "Error: -o cannot be used with --batch, use --out-dir instead" << endl;
+            return false;
+        }
+    } else if (options.inputFiles.size() > 1) {
+        err << "Error: Multiple input files specified (use --batch)" << endl;
         return false;
+    } else {
+        options.inputFile = options.inputFiles[0];
     }
     
     return true;
@@ -139,11 +445,27 @@ void setupOutputFiles(CompilerOptions& options) {
         baseName = baseName.substr(0, lastDot);
     }
     
-    // 设置默认输出文件名
-    if (options.outputFile.empty()) {
-        options.asmFile = baseName + ".s";
-    } else {
-        options.asmFile = options.outputFile;
+    // 指定了输出目录时，输出文件放到该目录下
+    if (!options.outDir.empty()) {
+        size_t lastSlash = baseName.find_last_of('/');
+        if (lastSlash != string::npos) {
+            baseName = baseName.substr(lastSlash + 1);
+        }
+        baseName = options.outDir + "/" + baseName;
+    }
+    
+    // 设置默认输出文件名（-o 只在输出一种产物时可用）
+    if (options.emitAsm) {
+        options.asmFile = options.outputFile.empty() ? baseName + ".s" : options.outputFile;
+    }
+    if (options.emitObj) {
+        options.objFile = options.outputFile.empty() ? baseName + ".o" : options.outputFile;
+    }
+    if (options.emitLL) {
+        options.llFile = options.outputFile.empty() ? baseName + ".ll" : options.outputFile;
+    }
+    if (options.emitBC) {
+        options.bcFile = options.outputFile.empty() ? baseName + ".bc" : options.outputFile;
     }
     
     if (options.dumpAST) {
@@ -153,6 +475,66 @@ void setupOutputFiles(CompilerOptions& options) {
     if (options.dumpIR) {
         options.irFile = baseName + ".ll";
     }
+    
+    if (options.timeReportJSON) {
+        options.timeReportFile = baseName + ".time.json";
+    }
+}
+
+// 主要输出文件：依次取汇编、目标文件、优化后的 IR、bitcode
+const string& primaryOutputFile(const CompilerOptions& options) {
+    if (options.emitAsm) {
+        return options.asmFile;
+    }
+    if (options.emitObj) {
+        return options.objFile;
+    }
+    return options.emitLL ? options.llFile : options.bcFile;
+}
+
+// 影响生成代码的选项（不含输出哪些产物），是 cacheOptionsKey 的一部分。
+// 多线程与增量编译都按片段生成代码，输出与整个模块一起生成时不同；
+// 增量编译的片段缓存键由后端按片段的 bitcode 计算，不用这里的选项
+string codegenOptionsKey(const CompilerOptions& options) {
+    ostringstream key;
+    key << "O" << options.optLevel
+        << ";features=" << RISCVBackend::getFeatureString(options.rvvMode, static_cast<unsigned>(options.vlen))
+        << ";rvv=" << static_cast<int>(options.rvvMode) << ";vlen=" << options.vlen
+        << ";passes=" << options.passPipeline << ";ssa=" << options.directSSA
+        << ";inline=" << options.inlineBudget << ";unroll=" << options.unrollFactor
+        << ";fragments=" << (options.codegenThreads > 1 || options.incremental);
+    return key.str();
+}
+
+// 影响编译产物的全部选项，与源文件内容一起组成缓存键
+string cacheOptionsKey(const CompilerOptions& options) {
+    return codegenOptionsKey(options) + ";emit=" + to_string(options.emitAsm) + to_string(options.emitObj) +
+           to_string(options.emitLL) + to_string(options.emitBC);
+}
+
+// 本次编译要缓存的产物
+vector<CompileCache::Output> cacheOutputs(const CompilerOptions& options) {
+    vector<CompileCache::Output> outputs;
+    if (options.emitAsm) {
+        outputs.push_back({"asm", options.asmFile});
+    }
+    if (options.emitObj) {
+        outputs.push_back({"obj", options.objFile});
+    }
+    if (options.emitLL) {
+        outputs.push_back({"ll", options.llFile});
+    }
+    if (options.emitBC) {
+        outputs.push_back({"bc", options.bcFile});
+    }
+    return outputs;
+}
+
+unique_ptr<CompileCache> createCache(const CompilerOptions& options) {
+    if (options.cacheDir.empty()) {
+        return nullptr;
+    }
+    return make_unique<CompileCache>(options.cacheDir, static_cast<uint64_t>(options.cacheSizeMB) * 1024 * 1024);
 }
 
 void printHeader(const CompilerOptions& options) {
@@ -160,8 +542,24 @@ void printHeader(const CompilerOptions& options) {
     cout << "  SysY Compiler - RISC-V 64 Backend" << endl;
     cout << "========================================" << endl;
     cout << "[+]Input:  " << options.inputFile << endl;
-    cout << "[+]Output: " << options.asmFile << endl;
+    cout << "[+]Output: " << primaryOutputFile(options) << endl;
     cout << "[+]Opt:    O" << options.optLevel << endl;
+    if (options.rvvMode != RVVMode::Off) {
+        cout << "[+]RVV:    " << (options.rvvMode == RVVMode::Fixed ? "fixed" : "scalable");
+        if (options.vlen > 0) {
+            cout << ", VLEN=" << options.vlen;
+        }
+        cout << endl;
+    }
+    if (!options.passPipeline.empty()) {
+        cout << "[+]Passes: " << options.passPipeline << endl;
+    }
+    if (options.incremental) {
+        cout << "[+]Incremental: " << options.cacheDir << endl;
+    }
+    if (options.codegenThreads > 0) {
+        cout << "[+]Codegen threads: " << options.codegenThreads << endl;
+    }
     if (options.dumpAST) {
         cout << "[+]AST:    " << options.astFile << endl;
     }
@@ -172,170 +570,596 @@ void printHeader(const CompilerOptions& options) {
     cout << endl;
 }
 
-int main(int argc, char *argv[]) {
+// 语法错误监听器：按 "文件:行:列: error: 信息" 写到调用方给的流（批量/服务模式下按文件收集）
+class SyntaxErrorListener : public BaseErrorListener {
+private:
+    ostream& err;
+    string fileName;
+    
+public:
+    SyntaxErrorListener(ostream& err, const string& fileName) : err(err), fileName(fileName) {}
+    
+    void syntaxError(Recognizer*, Token*, size_t line, size_t charPositionInLine,
+                     const string& msg, exception_ptr) override {
+        err << fileName << ":" << line << ":" << charPositionInLine << ": error: " << msg << endl;
+    }
+};
+
+// 两阶段解析：先用 SLL 预测 + BailErrorStrategy 快速解析（绝大多数输入一次成功），
+// 出错时回退到完整 LL 预测与默认错误恢复重新解析，由它给出准确的错误信息
+SysYParser::CompUnitContext* parseCompUnit(SysYParser& parser, ANTLRErrorListener* errorListener,
+                                           TimeReport* timeReport) {
+    parser.removeErrorListeners();
+    parser.setErrorHandler(make_shared<BailErrorStrategy>());
+    parser.getInterpreter<atn::ParserATNSimulator>()->setPredictionMode(atn::PredictionMode::SLL);
     try {
-            CompilerOptions options;
-        
-        // 解析命令行参数
-        if (!parseArguments(argc, argv, options)) {
-            printUsage(argv[0]);
-            return 1;
-        }
-        
-        if (options.help) {
-            printUsage(argv[0]);
-            return 0;
+        return parser.compUnit();
+    } catch (const ParseCancellationException&) {
+        // SLL 失败不一定是真正的语法错误，需要用 LL 重新确认
+    }
+    
+    TimeReport::Scope fallbackTimer(timeReport, "stage", "parse-ll-fallback");
+    parser.reset();
+    parser.addErrorListener(errorListener);
+    parser.setErrorHandler(make_shared<DefaultErrorStrategy>());
+    parser.getInterpreter<atn::ParserATNSimulator>()->setPredictionMode(atn::PredictionMode::LL);
+    return parser.compUnit();
+}
+
+// 输出互斥锁：批量模式下各文件的结果输出、AST 输出（需要重定向全局 cout）都在锁内进行
+static mutex outputMutex;
+
+// 编译单个文件：正常输出写到 out，错误写到 err，返回值即退出码
+int compileFile(const CompilerOptions& options, RISCVBackend& backend, ostream& out, ostream& err,
+                CompileCache* cache = nullptr) {
+    try {
+        unique_ptr<TimeReport> timeReport;
+        if (options.timeReport) {
+            timeReport = make_unique<TimeReport>(options.timeReportJSON);
+            // LLVM 的 pass 计时器是进程全局的，并发编译时不收集
+            timeReport->setLLVMTimers(!options.concurrent);
         }
+        TimeReport::Scope totalTimer(timeReport.get(), "stage", "total");
         
-        // 设置输出文件名
-        setupOutputFiles(options);
+        // 本次编译的标识符驻留在 identifiers 中，AST 节点都分配在 astArena 中
+        // （两者需先于 ast 声明，保证在 AST 之后释放）
+        IdentifierTable identifiers;
+        IdentifierTable::Scope identifierScope(&identifiers);
+        ASTArena astArena;
+        ASTArena::Scope arenaScope(&astArena);
         
-        // 打印编译信息
-        if (options.verbose) {
-            printHeader(options);
-        }
-        
-        // ========================================
-        // Step 1: 词法分析和语法分析
-        // ========================================
-        if (options.verbose) {
-            cout << "[1/4] Lexical and Syntax Analysis..." << endl;
+        // 输出文件不能覆盖输入（如输入 test.ll 时的 --dump-ir/--emit=ll）
+        for (const string* output : {&options.asmFile, &options.objFile, &options.llFile, &options.bcFile,
+                                     &options.irFile}) {
+            if (*output == options.inputFile) {
+                err << "[-]Error: Output file would overwrite the input file: " << options.inputFile << endl;
+                return 1;
+            }
         }
         
-        ifstream stream(options.inputFile);
+        ifstream stream(options.inputFile, ios::binary);
         if (!stream.is_open()) {
-            cerr << "[-]Error: Cannot open input file: " << options.inputFile << endl;
+            err << "[-]Error: Cannot open input file: " << options.inputFile << endl;
             return 1;
         }
+        string source((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
         
-        ANTLRInputStream input(stream);
-        SysYLexer lexer(&input);
-        CommonTokenStream tokens(&lexer);
-        SysYParser parser(&tokens);
-        
-        // 检查语法错误
-        if (parser.getNumberOfSyntaxErrors() > 0) {
-            cerr << "[-]Error: Parsing failed with " << parser.getNumberOfSyntaxErrors() 
-                << " syntax error(s)" << endl;
-            return 1;
+        // 缓存命中时直接写出产物，跳过整个流水线（需要转储 AST/IR 时不使用缓存）
+        string cacheKey;
+        bool useCache = cache && !options.dumpAST && !options.dumpIR;
+        if (useCache) {
+            cacheKey = CompileCache::computeKey(source, cacheOptionsKey(options));
+            if (cache->lookup(cacheKey, cacheOutputs(options))) {
+                if (options.verbose) {
+                    out << "[+]Cache hit: " << cacheKey << endl;
+                }
+                out << "Compiled " << options.inputFile << " -> " << primaryOutputFile(options) << " (cached)" << endl;
+                return 0;
+            }
         }
         
-        if (options.verbose) {
-            cout << "[+]Parsing completed successfully" << endl << endl;
+        // 前端的产物：从 SysY 源文件生成时依次得到 AST 和 IRGenerator 中的模块；
+        // 输入 LLVM IR 时直接加载到 irContext 中
+        std::unique_ptr<CompUnitAST> ast;
+        IRGenerator irGen;
+        llvm::LLVMContext irContext;
+        std::unique_ptr<llvm::Module> module;
+        
+        if (isIRInput(options.inputFile)) {
+            if (options.verbose) {
+                out << "[1-3/4] Loading LLVM IR (frontend skipped)..." << endl;
+            }
+            
+            TimeReport::Scope loadTimer(timeReport.get(), "stage", "ir-load");
+            string loadError;
+            module = RISCVBackend::loadModule(source, options.inputFile, irContext, loadError);
+            loadTimer.stop();
+            
+            if (!module) {
+                err << "[-]Error: Cannot load LLVM IR: " << loadError << endl;
+                return 1;
+            }
+            
+            if (options.verbose) {
+                out << "[+]LLVM IR loaded successfully (" << module->size() << " functions)" << endl << endl;
+            }
+        } else {
+            // ========================================
+            // Step 1: 词法分析和语法分析
+            // ========================================
+            if (options.verbose) {
+                out << "[1/4] Lexical and Syntax Analysis..." << endl;
+            }
+            
+            TimeReport::Scope parseTimer(timeReport.get(), "stage", "parse");
+            SyntaxErrorListener errorListener(err, options.inputFile);
+            ANTLRInputStream input(source);
+            SysYLexer lexer(&input);
+            lexer.removeErrorListeners();
+            lexer.addErrorListener(&errorListener);
+            CommonTokenStream tokens(&lexer);
+            SysYParser parser(&tokens);
+            tree::ParseTree *parseTree = parseCompUnit(parser, &errorListener, timeReport.get());
+            parseTimer.stop();
+            
+            // 检查语法错误（词法错误不会中断解析，一并统计），出错时不再构建 AST
+            size_t syntaxErrors = lexer.getNumberOfSyntaxErrors() + parser.getNumberOfSyntaxErrors();
+            if (syntaxErrors > 0) {
+                err << "[-]Error: Parsing failed with " << syntaxErrors << " syntax error(s)" << endl;
+                return 1;
+            }
+            
+            if (options.verbose) {
+                out << "[+]Parsing completed successfully" << endl << endl;
+            }
+            
+            // ========================================
+            // Step 2: 构建抽象语法树 (AST)
+            // ========================================
+            if (options.verbose) {
+                out << "[2/4] Building Abstract Syntax Tree..." << endl;
+            }
+            
+            TimeReport::Scope astTimer(timeReport.get(), "stage", "ast-build");
+            ASTBuilder astBuilder;
+            auto astResult = astBuilder.visit(parseTree);
+            
+            CompUnitAST* astPtr = std::any_cast<CompUnitAST*>(astResult);
+            ast.reset(astPtr);
+            astTimer.stop();
+            
+            if (!ast) {
+                err << "[-]Error: Failed to build AST" << endl;
+                return 1;
+            }
+            
+            if (options.verbose) {
+                out << "[+]AST built successfully" << endl << endl;
+            }
+            
+            // ========================================
+            // Step 2.5: AST优化
+            // ========================================
+            if (options.verbose) {
+                out << "[2.5/4] Optimizing Abstract Syntax Tree..." << endl;
+            }
+            
+            ASTOptimizer optimizer(options.verbose);
+            optimizer.setInlineBudget(options.inlineBudget);
+            optimizer.setUnrollFactor(options.unrollFactor);
+            optimizer.setTimeReport(timeReport.get());
+            TimeReport::Scope optimizeTimer(timeReport.get(), "stage", "ast-optimize");
+            optimizer.optimize(ast.get());
+            optimizeTimer.stop();
+            
+            if (options.verbose) {
+                out << "[+]AST optimized successfully (arena: " << astArena.getNodeCount() << " nodes, "
+                    << astArena.getBytesAllocated() / 1024 << " KB; " << identifiers.size() << " identifiers)"
+                    << endl << endl;
+            }
+            
+            // 输出 AST（如果需要）
+            if (options.dumpAST) {
+                if (options.verbose) {
+                    out << "[+]Writing AST to " << options.astFile << "..." << endl;
+                }
+                
+                ofstream astOut(options.astFile);
+                if (!astOut.is_open()) {
+                    err << "[-]Warning: Cannot open AST output file: " << options.astFile << endl;
+                } else {
+                    // 重定向 cout 到文件（cout 是全局的，批量模式下需持锁）
+                    lock_guard<mutex> lock(outputMutex);
+                    streambuf* coutBuf = cout.rdbuf();
+                    cout.rdbuf(astOut.rdbuf());
+                    
+                    ast->print();
+                    
+                    // 恢复 cout
+                    cout.rdbuf(coutBuf);
+                    astOut.close();
+                    
+                    if (options.verbose) {
+                        out << "[+]AST written to " << options.astFile << endl << endl;
+                    }
+                }
+            }
+            
+            // ========================================
+            // Step 3: 生成 LLVM IR
+            // ========================================
+            if (options.verbose) {
+                out << "[3/4] Generating LLVM Intermediate Representation..." << endl;
+            }
+            
+            TimeReport::Scope irgenTimer(timeReport.get(), "stage", "irgen");
+            irGen.setDirectSSA(options.directSSA);
+            
+            // 声明运行时库函数
+            irGen.declareLibraryFunctions();
+            
+            module = irGen.generate(ast.get());
+            irgenTimer.stop();
+            
+            if (!module) {
+                err << "[-]Error: Failed to generate LLVM IR" << endl;
+                return 1;
+            }
+            
+            if (options.verbose) {
+                out << "[+]LLVM IR generated successfully" << endl << endl;
+            }
+            
+            // 输出 IR（如果需要）
+            if (options.dumpIR) {
+                if (options.verbose) {
+                    out << "[+]Writing IR to " << options.irFile << "..." << endl;
+                }
+                
+                std::error_code ec;
+                llvm::raw_fd_ostream irOut(options.irFile, ec);
+                
+                if (ec) {
+                    err << "[-]Warning: Cannot open IR output file: " << ec.message() << endl;
+                } else {
+                    module->print(irOut, nullptr);
+                    irOut.close();
+                    
+                    if (options.verbose) {
+                        out << "[+]LLVM IR written to " << options.irFile << endl << endl;
+                    }
+                }
+            }
+            
         }
         
         // ========================================
-        // Step 2: 构建抽象语法树 (AST)
+        // Step 4: 生成 RISC-V 64 汇编/目标文件
         // ========================================
         if (options.verbose) {
-            cout << "[2/4] Building Abstract Syntax Tree..." << endl;
+            out << "[4/4] Generating RISC-V 64 Code..." << endl;
         }
         
-        tree::ParseTree *parseTree = parser.compUnit();
-        ASTBuilder astBuilder;
-        auto astResult = astBuilder.visit(parseTree);
+        // 中端优化只运行一次，所有请求的产物都从同一个优化后的模块生成
+        BackendOutputs outputs;
+        outputs.asmFile = options.asmFile;
+        outputs.objFile = options.objFile;
+        outputs.llFile = options.llFile;
+        outputs.bcFile = options.bcFile;
         
-        CompUnitAST* astPtr = std::any_cast<CompUnitAST*>(astResult);
-        std::unique_ptr<CompUnitAST> ast(astPtr);
-        
-        if (!ast) {
-            cerr << "[-]Error: Failed to build AST" << endl;
+        // backend 可能被后续文件复用，用完立即清掉报告和片段缓存指针
+        backend.setTimeReport(timeReport.get());
+        backend.setFragmentCache(options.incremental ? cache : nullptr);
+        bool generated = backend.generate(module.get(), outputs);
+        backend.setFragmentCache(nullptr);
+        backend.setTimeReport(nullptr);
+        if (!generated) {
+            err << "[-]Error: Failed to generate RISC-V code" << endl;
             return 1;
         }
         
+        if (options.incremental && options.verbose && (options.emitAsm || options.emitObj)) {
+            out << "[+]Incremental: " << backend.getReusedFragments() << "/" << backend.getFragmentCount()
+                << " fragments reused" << endl;
+        }
+        
         if (options.verbose) {
-            cout << "[+]AST built successfully" << endl << endl;
+            out << "[+]RISC-V code written to " << primaryOutputFile(options) << endl << endl;
+        }
+        
+        if (useCache && !cache->store(cacheKey, cacheOutputs(options))) {
+            err << "[-]Warning: Cannot write cache entry to " << cache->getDirectory() << endl;
         }
         
         // ========================================
-        // Step 2.5: AST优化
+        // 完成
         // ========================================
         if (options.verbose) {
-            cout << "[2.5/4] Optimizing Abstract Syntax Tree..." << endl;
+            out << "========================================" << endl;
+            out << "  Compilation Successful!" << endl;
+            out << "========================================" << endl;
+            out << endl;
+            out << "Generated files:" << endl;
+            if (options.dumpAST) {
+                out << "  - AST:      " << options.astFile << endl;
+            }
+            if (options.dumpIR) {
+                out << "  - LLVM IR:  " << options.irFile << endl;
+            }
+            if (options.emitLL) {
+                out << "  - Opt IR:   " << options.llFile << endl;
+            }
+            if (options.emitBC) {
+                out << "  - Bitcode:  " << options.bcFile << endl;
+            }
+            if (options.emitAsm) {
+                out << "  - Assembly: " << options.asmFile << endl;
+            }
+            if (options.emitObj) {
+                out << "  - Object:   " << options.objFile << endl;
+            }
+        } else {
+            // 简洁模式：只输出成功信息
+            out << "Compiled " << options.inputFile << " -> " << primaryOutputFile(options) << endl;
         }
         
-        ASTOptimizer optimizer(options.verbose);
-        optimizer.optimize(ast.get());
+        // 单文件编译结束后进程即退出：放弃整棵 AST，不逐个运行节点析构函数，
+        // 节点内存随 astArena 整块释放（并发编译时照常析构，避免泄漏节点内的字符串等）
+        if (!options.concurrent) {
+            ast.release();
+        }
         
-        if (options.verbose) {
-            cout << "[+]AST optimized successfully" << endl << endl;
+        // 耗时报告：文本输出到 stderr，JSON 写到 <input>.time.json
+        if (timeReport) {
+            totalTimer.stop();
+            if (options.timeReportJSON) {
+                ofstream reportOut(options.timeReportFile);
+                if (!reportOut.is_open()) {
+                    err << "[-]Warning: Cannot open time report file: " << options.timeReportFile << endl;
+                } else {
+                    timeReport->printJSON(reportOut, options.inputFile);
+                }
+            } else {
+                timeReport->print(err, options.inputFile);
+            }
         }
         
-        // 输出 AST（如果需要）
-        if (options.dumpAST) {
-            if (options.verbose) {
-                cout << "[+]Writing AST to " << options.astFile << "..." << endl;
+        return 0;
+    } catch (const std::exception& e) {
+        err << "[-]Error: " << e.what() << endl;
+        return 1;
+    } catch (...) {
+        err << "[-]Error: Unknown exception occurred" << endl;
+        return 1;
+    }
+}
+
+// 批量模式：一个进程编译多个文件，省去每个文件的进程启动与目标初始化开销。
+// 每个 worker 线程持有自己的 RISCVBackend（TargetMachine），每个文件的
+// LLVMContext 由各自的 IRGenerator 持有；单个文件失败不影响其余文件。
+int runBatch(const CompilerOptions& options) {
+    if (!RISCVBackend::initializeTarget()) {
+        cerr << "[-]Error: Failed to initialize RISC-V target" << endl;
+        return 1;
+    }
+    
+    size_t fileCount = options.inputFiles.size();
+    size_t jobs = options.jobs > 0 ? static_cast<size_t>(options.jobs) : thread::hardware_concurrency();
+    jobs = max<size_t>(1, min(jobs, fileCount));
+    
+    // backend 构造时会设置全局的 LLVM 命令行选项，因此在主线程中依次创建
+    vector<unique_ptr<RISCVBackend>> backends;
+    for (size_t i = 0; i < jobs; i++) {
+        auto backend = make_unique<RISCVBackend>(options.optLevel, options.rvvMode, static_cast<unsigned>(options.vlen));
+        backend->setPassPipeline(options.passPipeline);
+        backend->setPrintPipeline(options.printPipeline && i == 0);
+        backend->setCodegenThreads(static_cast<unsigned>(options.codegenThreads));
+        backends.push_back(std::move(backend));
+    }
+    
+    unique_ptr<CompileCache> cache = createCache(options);
+    atomic<size_t> nextFile{0};
+    atomic<int> failedCount{0};
+    auto worker = [&](RISCVBackend& backend) {
+        size_t index;
+        while ((index = nextFile++) < fileCount) {
+            CompilerOptions fileOptions = options;
+            fileOptions.inputFile = options.inputFiles[index];
+            fileOptions.verbose = false;
+            fileOptions.concurrent = true;
+            setupOutputFiles(fileOptions);
+            
+            ostringstream out, err;
+            if (compileFile(fileOptions, backend, out, err, cache.get()) != 0) {
+                failedCount++;
             }
             
-            ofstream astOut(options.astFile);
-            if (!astOut.is_open()) {
-                cerr << "[-]Warning: Cannot open AST output file: " << options.astFile << endl;
-            } else {
-                // 重定向 cout 到文件
-                streambuf* coutBuf = cout.rdbuf();
-                cout.rdbuf(astOut.rdbuf());
-                
-                ast->print();
-                
-                // 恢复 cout
-                cout.rdbuf(coutBuf);
-                astOut.close();
-                
-                if (options.verbose) {
-                    cout << "[+]AST written to " << options.astFile << endl << endl;
-                }
+            // 错误信息逐行加上文件名前缀，整体输出避免与其他文件交错
+            string name = fileOptions.inputFile.substr(fileOptions.inputFile.find_last_of('/') + 1);
+            lock_guard<mutex> lock(outputMutex);
+            cout << out.str() << flush;
+            istringstream errLines(err.str());
+            string line;
+            while (getline(errLines, line)) {
+                cerr << "[" << name << "] " << line << endl;
             }
         }
+    };
+    
+    vector<thread> threads;
+    for (size_t i = 1; i < jobs; i++) {
+        threads.emplace_back(worker, ref(*backends[i]));
+    }
+    worker(*backends[0]);
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    int failed = failedCount.load();
+    cout << "Batch: " << (fileCount - failed) << "/" << fileCount << " files compiled";
+    if (failed > 0) {
+        cout << ", " << failed << " failed";
+    }
+    cout << " (" << jobs << " jobs)" << endl;
+    if (cache) {
+        cache->prune();
+        if (options.cacheStats) {
+            cache->printStats(cout);
+        }
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+// 把客户端给出的相对路径按其工作目录转成绝对路径
+string resolveClientPath(const string& cwd, const string& path) {
+    if (path.empty()) {
+        return path;
+    }
+    llvm::SmallString<256> result(path);
+    llvm::sys::fs::make_absolute(cwd, result);
+    return string(result.str());
+}
+
+// 常驻编译服务：目标只初始化一次，每个 worker 为 O0-O3 各保留一个预热的 backend。
+// 每个请求都新建 ASTOptimizer/IRGenerator（连同 LLVMContext、符号表和库函数声明），
+// 请求之间不共享前中端状态。
+int runServer(const CompilerOptions& serverOptions) {
+    if (!RISCVBackend::initializeTarget()) {
+        cerr << "[-]Error: Failed to initialize RISC-V target" << endl;
+        return 1;
+    }
+    
+    size_t workers = serverOptions.jobs > 0 ? static_cast<size_t>(serverOptions.jobs) : thread::hardware_concurrency();
+    workers = max<size_t>(1, workers);
+    
+    // backend 构造时会设置全局的 LLVM 命令行选项，因此全部在主线程中预先创建；
+    // RVV 设置也因此在服务启动时确定，请求不能修改
+    vector<array<unique_ptr<RISCVBackend>, 4>> backends(workers);
+    for (auto& workerBackends : backends) {
+        for (int level = 0; level < 4; level++) {
+            workerBackends[level] = make_unique<RISCVBackend>(level, serverOptions.rvvMode,
+                                                              static_cast<unsigned>(serverOptions.vlen));
+        }
+    }
+    
+    // 缓存目录同样在服务启动时确定
+    unique_ptr<CompileCache> cache = createCache(serverOptions);
+    
+    auto handleRequest = [&](const CompileRequest& request, size_t worker) {
+        CompileResponse response;
+        ostringstream out, err;
+        
+        vector<string> argStorage;
+        argStorage.push_back("compiler");
+        argStorage.insert(argStorage.end(), request.args.begin(), request.args.end());
+        vector<char*> argv;
+        for (auto& arg : argStorage) {
+            argv.push_back(&arg[0]);
+        }
         
-        // ========================================
-        // Step 3: 生成 LLVM IR
-        // ========================================
-        if (options.verbose) {
-            cout << "[3/4] Generating LLVM Intermediate Representation..." << endl;
+        CompilerOptions options;
+        options.rvvMode = serverOptions.rvvMode;
+        options.vlen = serverOptions.vlen;
+        options.cacheDir = serverOptions.cacheDir;
+        options.cacheSizeMB = serverOptions.cacheSizeMB;
+        if (!parseArguments(static_cast<int>(argv.size()), argv.data(), options, err)) {
+            response.err = err.str();
+            return response;
+        }
+        if (options.help || options.batch || !options.serveSocket.empty()) {
+            response.err = "[-]Error: --help, --batch and --serve are not available through the server\n";
+            return response;
+        }
+        if (options.rvvMode != serverOptions.rvvMode || options.vlen != serverOptions.vlen ||
+            options.cacheDir != serverOptions.cacheDir || options.cacheSizeMB != serverOptions.cacheSizeMB) {
+            response.err = "[-]Error: --rvv/--vlen/--cache-dir/--cache-size are fixed when the server starts\n";
+            return response;
         }
         
-        IRGenerator irGen;
+        options.inputFile = resolveClientPath(request.cwd, options.inputFile);
+        options.outputFile = resolveClientPath(request.cwd, options.outputFile);
+        options.outDir = resolveClientPath(request.cwd, options.outDir);
+        options.verbose = false;
+        options.concurrent = true;
+        setupOutputFiles(options);
+        if (!options.outDir.empty()) {
+            if (std::error_code ec = llvm::sys::fs::create_directories(options.outDir)) {
+                response.err = "[-]Error: Cannot create output directory " + options.outDir + ": " + ec.message() + "\n";
+                return response;
+            }
+        }
         
-        // 声明运行时库函数
-        irGen.declareLibraryFunctions();
+        RISCVBackend& backend = *backends[worker][options.optLevel];
+        backend.setPassPipeline(options.passPipeline);
+        backend.setPrintPipeline(false);
+        backend.setCodegenThreads(static_cast<unsigned>(options.codegenThreads));
+        response.exitCode = compileFile(options, backend, out, err, cache.get());
+        if (response.exitCode == 0) {
+            response.asmFile = primaryOutputFile(options);
+        }
+        response.out = out.str();
+        response.err = err.str();
+        return response;
+    };
+    
+    CompileServer server(serverOptions.serveSocket, workers, handleRequest);
+    return server.run() ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        // 客户端模式：其余参数原样交给编译服务
+        if (argc >= 2 && string(argv[1]).rfind("--connect", 0) == 0) {
+            string arg = argv[1];
+            int first = 2;
+            string socketPath;
+            if (arg.rfind("--connect=", 0) == 0) {
+                socketPath = arg.substr(10);
+            } else if (arg == "--connect" && argc >= 3) {
+                socketPath = argv[2];
+                first = 3;
+            }
+            if (socketPath.empty()) {
+                cerr << "Error: --connect requires a socket path" << endl;
+                return 1;
+            }
+            return CompileServer::runClient(socketPath, vector<string>(argv + first, argv + argc));
+        }
         
-        auto module = irGen.generate(ast.get());
+        CompilerOptions options;
         
-        if (!module) {
-            cerr << "[-]Error: Failed to generate LLVM IR" << endl;
+        // 解析命令行参数
+        if (!parseArguments(argc, argv, options)) {
+            printUsage(argv[0]);
             return 1;
         }
         
-        if (options.verbose) {
-            cout << "[+]LLVM IR generated successfully" << endl << endl;
+        if (options.help) {
+            printUsage(argv[0]);
+            return 0;
         }
         
-        // 输出 IR（如果需要）
-        if (options.dumpIR) {
-            if (options.verbose) {
-                cout << "[+]Writing IR to " << options.irFile << "..." << endl;
-            }
-            
-            std::error_code ec;
-            llvm::raw_fd_ostream irOut(options.irFile, ec);
-            
-            if (ec) {
-                cerr << "[-]Warning: Cannot open IR output file: " << ec.message() << endl;
-            } else {
-                module->print(irOut, nullptr);
-                irOut.close();
-                
-                if (options.verbose) {
-                    cout << "[+]LLVM IR written to " << options.irFile << endl << endl;
-                }
+        if (!options.outDir.empty()) {
+            if (std::error_code ec = llvm::sys::fs::create_directories(options.outDir)) {
+                cerr << "[-]Error: Cannot create output directory " << options.outDir << ": " << ec.message() << endl;
+                return 1;
             }
         }
         
-        // ========================================
-        // Step 4: 生成 RISC-V 64 汇编代码
-        // ========================================
+        if (!options.serveSocket.empty()) {
+            return runServer(options);
+        }
+        
+        if (options.batch) {
+            return runBatch(options);
+        }
+        
+        // 设置输出文件名
+        setupOutputFiles(options);
+        
+        // 打印编译信息
         if (options.verbose) {
-            cout << "[4/4] Generating RISC-V 64 Assembly..." << endl;
+            printHeader(options);
         }
         
         // 初始化 RISC-V 目标
@@ -344,39 +1168,20 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         
-        RISCVBackend backend(options.optLevel);
+        RISCVBackend backend(options.optLevel, options.rvvMode, static_cast<unsigned>(options.vlen));
+        backend.setPassPipeline(options.passPipeline);
+        backend.setPrintPipeline(options.printPipeline);
+        backend.setCodegenThreads(static_cast<unsigned>(options.codegenThreads));
         
-        if (!backend.generateAssembly(module.get(), options.asmFile)) {
-            cerr << "[-]Error: Failed to generate RISC-V assembly" << endl;
-            return 1;
-        }
-        
-        if (options.verbose) {
-            cout << "[+]RISC-V assembly written to " << options.asmFile << endl << endl;
-        }
-        
-        // ========================================
-        // 完成
-        // ========================================
-        if (options.verbose) {
-            cout << "========================================" << endl;
-            cout << "  Compilation Successful!" << endl;
-            cout << "========================================" << endl;
-            cout << endl;
-            cout << "Generated files:" << endl;
-            if (options.dumpAST) {
-                cout << "  - AST:      " << options.astFile << endl;
-            }
-            if (options.dumpIR) {
-                cout << "  - LLVM IR:  " << options.irFile << endl;
+        unique_ptr<CompileCache> cache = createCache(options);
+        int result = compileFile(options, backend, cout, cerr, cache.get());
+        if (cache) {
+            cache->prune();
+            if (options.cacheStats) {
+                cache->printStats(cout);
             }
-            cout << "  - Assembly: " << options.asmFile << endl;
-        } else {
-            // 简洁模式：只输出成功信息
-            cout << "Compiled " << options.inputFile << " -> " << options.asmFile << endl;
         }
-        
-            return 0;
+        return result;
     } catch (const std::exception& e) {
         cerr << "[-]Error: " << e.what() << endl;
         return 1;
@@ -0,0 +1,284 @@
+#include "compile_server.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// 单个请求的大小上限，防止异常客户端耗尽内存
+constexpr size_t MAX_REQUEST_SIZE = 1 << 20;
+
+volatile sig_atomic_t stopRequested = 0;
+
+void handleStopSignal(int) {
+    stopRequested = 1;
+}
+
+bool makeAddress(const std::string& path, sockaddr_un& addr) {
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[-]Error: Socket path too long: " << path << std::endl;
+        return false;
+    }
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    return true;
+}
+
+// 读到对端关闭写端为止；超过 limit 时返回 false
+bool readAll(int fd, std::string& data, size_t limit) {
+    char buffer[4096];
+    while (true) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        data.append(buffer, static_cast<size_t>(n));
+        if (data.size() > limit) {
+            return false;
+        }
+    }
+}
+
+bool writeAll(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        // MSG_NOSIGNAL：客户端提前断开时不触发 SIGPIPE
+        ssize_t n = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string encodeResponse(const CompileResponse& response) {
+    std::string data = std::to_string(response.exitCode) + " " + std::to_string(response.out.size()) +
+                       " " + std::to_string(response.err.size()) + "\n" + response.asmFile + "\n";
+    return data + response.out + response.err;
+}
+
+bool decodeResponse(const std::string& data, CompileResponse& response) {
+    size_t headerEnd = data.find('\n');
+    if (headerEnd == std::string::npos) {
+        return false;
+    }
+    size_t asmEnd = data.find('\n', headerEnd + 1);
+    if (asmEnd == std::string::npos) {
+        return false;
+    }
+    size_t outLen = 0, errLen = 0;
+    if (std::sscanf(data.c_str(), "%d %zu %zu", &response.exitCode, &outLen, &errLen) != 3) {
+        return false;
+    }
+    if (data.size() - (asmEnd + 1) != outLen + errLen) {
+        return false;
+    }
+    response.asmFile = data.substr(headerEnd + 1, asmEnd - headerEnd - 1);
+    response.out = data.substr(asmEnd + 1, outLen);
+    response.err = data.substr(asmEnd + 1 + outLen, errLen);
+    return true;
+}
+
+} // namespace
+
+CompileServer::CompileServer(const std::string& socketPath, size_t workerCount, Handler handler,
+                             size_t queueCapacity)
+    : socketPath(socketPath), workerCount(workerCount > 0 ? workerCount : 1),
+      queueCapacity(queueCapacity > 0 ? queueCapacity : 1), handler(std::move(handler)) {}
+
+CompileServer::~CompileServer() {
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+}
+
+bool CompileServer::run() {
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr)) {
+        return false;
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "[-]Error: Cannot create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // 清理上次异常退出留下的套接字文件
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd, static_cast<int>(queueCapacity)) < 0) {
+        std::cerr << "[-]Error: Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    // 不带 SA_RESTART：收到信号时 accept 返回 EINTR，从而退出循环
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handleStopSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // worker 线程屏蔽停止信号，保证信号只打断主线程的 accept
+    sigset_t stopSignals, oldMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &oldMask);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&CompileServer::workerLoop, this, i);
+    }
+    pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+
+    std::cout << "Listening on " << socketPath << " (" << workerCount << " workers)" << std::endl;
+
+    while (!stopRequested) {
+        {
+            // 队列满时先不 accept，新连接留在内核的 listen 队列里
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueNotFull.wait(lock, [this] { return pending.size() < queueCapacity; });
+        }
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::cerr << "[-]Error: accept failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            pending.push_back(fd);
+        }
+        queueNotEmpty.notify_one();
+    }
+
+    // 处理完已接受的连接后退出
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueNotEmpty.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::cout << "Server stopped" << std::endl;
+    return true;
+}
+
+void CompileServer::workerLoop(size_t index) {
+    while (true) {
+        int fd;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueNotEmpty.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                return;
+            }
+            fd = pending.front();
+            pending.pop_front();
+        }
+        queueNotFull.notify_one();
+        serveConnection(fd, index);
+        close(fd);
+    }
+}
+
+void CompileServer::serveConnection(int fd, size_t index) {
+    std::string data;
+    CompileResponse response;
+    if (!readAll(fd, data, MAX_REQUEST_SIZE)) {
+        response.err = "[-]Error: Malformed or oversized request\n";
+        writeAll(fd, encodeResponse(response));
+        return;
+    }
+
+    // 各字段以 '\0' 结尾，第一个字段是工作目录
+    CompileRequest request;
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] == '\0') {
+            fields.push_back(data.substr(begin, i - begin));
+            begin = i + 1;
+        }
+    }
+    if (fields.empty() || begin != data.size()) {
+        response.err = "[-]Error: Malformed request\n";
+        writeAll(fd, encodeResponse(response));
+        return;
+    }
+    request.cwd = fields[0];
+    request.args.assign(fields.begin() + 1, fields.end());
+
+    try {
+        response = handler(request, index);
+    } catch (const std::exception& e) {
+        response = CompileResponse();
+        response.err = std::string("[-]Error: ") + e.what() + "\n";
+    }
+    writeAll(fd, encodeResponse(response));
+}
+
+int CompileServer::runClient(const std::string& socketPath, const std::vector<std::string>& args) {
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr)) {
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "[-]Error: Cannot connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    // 相对路径由服务端按客户端的工作目录解析
+    char cwd[4096];
+    std::string request = getcwd(cwd, sizeof(cwd)) ? cwd : ".";
+    request.push_back('\0');
+    for (const auto& arg : args) {
+        request += arg;
+        request.push_back('\0');
+    }
+
+    std::string data;
+    CompileResponse response;
+    bool ok = writeAll(fd, request) && shutdown(fd, SHUT_WR) == 0 &&
+              readAll(fd, data, SIZE_MAX) && decodeResponse(data, response);
+    close(fd);
+    if (!ok) {
+        std::cerr << "[-]Error: Invalid response from " << socketPath << std::endl;
+        return 1;
+    }
+
+    std::cout << response.out << std::flush;
+    std::cerr << response.err << std::flush;
+    return response.exitCode;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 编译请求：客户端的工作目录与命令行参数（不含程序名）
+struct CompileRequest {
+    std::string cwd;
+    std::vector<std::string> args;
+};
+
+// 编译结果：退出码、主要输出文件（汇编，-c 时为目标文件），以及原本写到 stdout/stderr 的内容
+struct CompileResponse {
+    int exitCode = 1;
+    std::string asmFile;
+    std::string out;
+    std::string err;
+};
+
+// 常驻编译服务：监听 Unix 域套接字，把请求分发给固定数量的 worker 线程。
+//
+// 协议：客户端发送 "cwd\0arg1\0arg2\0..." 后关闭写端；服务端返回
+// "<exitCode> <outLen> <errLen>\n<asmFile>\n" 加上 out 与 err 的原始字节。
+class CompileServer {
+public:
+    // 处理一个请求，worker 为处理线程编号（0 .. workerCount-1）
+    using Handler = std::function<CompileResponse(const CompileRequest&, size_t worker)>;
+
+private:
+    std::string socketPath;
+    size_t workerCount;
+    size_t queueCapacity;        // 等待处理的连接上限，满时暂停 accept
+    Handler handler;
+    int listenFd = -1;
+
+    std::deque<int> pending;     // 已接受、等待处理的连接
+    std::mutex queueMutex;
+    std::condition_variable queueNotEmpty;
+    std::condition_variable queueNotFull;
+    bool stopping = false;
+
+    void workerLoop(size_t index);
+    void serveConnection(int fd, size_t index);
+
+public:
+    CompileServer(const std::string& socketPath, size_t workerCount, Handler handler,
+                  size_t queueCapacity = 64);
+    ~CompileServer();
+
+    // 开始服务，直到收到 SIGINT/SIGTERM；套接字创建失败返回 false
+    bool run();
+
+    // 客户端：把参数发给服务端，输出其结果并返回编译的退出码
+    static int runClient(const std::string& socketPath, const std::vector<std::string>& args);
+};
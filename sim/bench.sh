@@ -0,0 +1,238 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# 性能测试：按每个优化级别与 VLEN 编译测试集，在 QEMU 中运行，检查输出并统计计时区间的周期数与指令数，
+# 结果写成 CSV/JSON，并给出相对基准级别（第一个优化级别）与基准 VLEN（第一个 VLEN）的加速比。
+#
+# 测试集目录中每个 <name>.sy 可带 <name>.in（标准输入）与 <name>.out（期望输出：程序的标准输出，
+# 最后一行是 main 的返回值）；没有 .out 的用例只统计性能，不检查结果。
+
+usage() {
+  cat >&2 <<EOF
+Usage: $0 [options]
+  --corpus <dir>      Benchmark sources (default: test/examples_final)
+  --levels "<l...>"   Optimization levels (default: "0 1 2 3"; the first is the baseline)
+  --vlens "<v...>"    VLEN settings (default: "128"; the first is the baseline)
+  --out-dir <dir>     Output directory (default: bench_res)
+  --compiler <path>   Compiler executable (default: ./compiler)
+  --timeout <sec>     Per-run timeout in seconds (default: 60)
+  -j <n>              Compile threads (default: number of CPUs)
+EOF
+  exit 1
+}
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+CORPUS="test/examples_final"
+LEVELS="0 1 2 3"
+VLENS="128"
+OUT_DIR="bench_res"
+COMPILER="./compiler"
+TIMEOUT=60
+JOBS=""
+
+while [[ $# -gt 0 ]]; do
+  case "$1" in
+    --corpus|--levels|--vlens|--out-dir|--compiler|--timeout|-j)
+      if [[ $# -lt 2 ]]; then
+        echo "Missing value for $1" >&2
+        exit 1
+      fi
+      case "$1" in
+        --corpus) CORPUS="$2" ;;
+        --levels) LEVELS="$2" ;;
+        --vlens) VLENS="$2" ;;
+        --out-dir) OUT_DIR="$2" ;;
+        --compiler) COMPILER="$2" ;;
+        --timeout) TIMEOUT="$2" ;;
+        -j) JOBS="$2" ;;
+      esac
+      shift 2
+      ;;
+    -h|--help)
+      usage
+      ;;
+    *)
+      echo "Unknown option: $1" >&2
+      usage
+      ;;
+  esac
+done
+
+if [[ ! -x "$COMPILER" ]]; then
+  echo "Compiler not found: $COMPILER (run make first)" >&2
+  exit 1
+fi
+shopt -s nullglob
+SOURCES=("$CORPUS"/*.sy)
+shopt -u nullglob
+if [[ ${#SOURCES[@]} -eq 0 ]]; then
+  echo "No .sy files found in $CORPUS" >&2
+  exit 1
+fi
+read -ra LEVEL_LIST <<< "$LEVELS"
+read -ra VLEN_LIST <<< "$VLENS"
+
+# -icount 让 QEMU 按执行的指令数推进时钟，rdcycle 的结果与宿主机负载无关、可重复
+export QEMU_FLAGS="${QEMU_FLAGS:--icount shift=0}"
+
+mkdir -p "$OUT_DIR"
+RESULTS="$OUT_DIR/results.csv"
+echo "name,opt,vlen,status,exit_code,cycles,instructions" > "$RESULTS"
+
+# 期望输出的比较方式同测试平台：程序输出后接返回值（输出非空且不以换行结尾时先补换行），
+# 忽略行尾空白与末尾空行
+normalize() {
+  sed -e 's/[[:space:]]*$//' "$1" | sed -e ':a' -e '/^\n*$/{$d;N;ba' -e '}'
+}
+
+PASSED=0
+FAILED=0
+for vlen in "${VLEN_LIST[@]}"; do
+  for level in "${LEVEL_LIST[@]}"; do
+    CONFIG_DIR="$OUT_DIR/O$level-vlen$vlen"
+    mkdir -p "$CONFIG_DIR"
+    echo "Compiling ${#SOURCES[@]} files with -O$level --vlen=$vlen..."
+    "$COMPILER" --batch "${SOURCES[@]}" --out-dir="$CONFIG_DIR" -O"$level" --vlen="$vlen" \
+      $([[ -n "$JOBS" ]] && echo "-j $JOBS") 2> "$CONFIG_DIR/compile.log" > /dev/null || true
+
+    for source in "${SOURCES[@]}"; do
+      name="$(basename "$source" .sy)"
+      asm="$CONFIG_DIR/$name.s"
+      input="$CORPUS/$name.in"
+      expected="$CORPUS/$name.out"
+      stdout="$CONFIG_DIR/$name.stdout"
+      stderr="$CONFIG_DIR/$name.stderr"
+      exit_code=""
+      cycles=""
+      instructions=""
+
+      if [[ ! -f "$asm" ]]; then
+        status="CE"
+      else
+        [[ -f "$input" ]] || input="/dev/null"
+        set +e
+        timeout "$TIMEOUT" "$SCRIPT_DIR/run_qemu.sh" "$asm" < "$input" > "$stdout" 2> "$stderr"
+        exit_code=$?
+        set -e
+        if [[ $exit_code -eq 124 ]]; then
+          status="TLE"
+          exit_code=""
+        elif [[ -f "$expected" ]]; then
+          actual="$CONFIG_DIR/$name.actual"
+          cp "$stdout" "$actual"
+          if [[ -s "$actual" && -n "$(tail -c 1 "$actual")" ]]; then
+            echo >> "$actual"
+          fi
+          echo "$exit_code" >> "$actual"
+          if diff -q <(normalize "$actual") <(normalize "$expected") > /dev/null; then
+            status="AC"
+          else
+            status="WA"
+          fi
+        else
+          status="RUN"
+        fi
+        # 运行库在退出时输出计时区间的合计：TOTAL: <周期数> cycles, <指令数> instructions
+        total="$(grep -a '^TOTAL: ' "$stderr" | tail -n 1 || true)"
+        if [[ -n "$total" ]]; then
+          cycles="$(echo "$total" | awk '{print $2}')"
+          instructions="$(echo "$total" | awk '{print $4}')"
+        fi
+      fi
+
+      if [[ "$status" == "AC" || "$status" == "RUN" ]]; then
+        PASSED=$((PASSED + 1))
+      else
+        FAILED=$((FAILED + 1))
+      fi
+      printf "  %-40s O%-2s vlen=%-6s %-4s %s\n" "$name" "$level" "$vlen" "$status" "${cycles:+$cycles cycles}"
+      echo "$name,$level,$vlen,$status,$exit_code,$cycles,$instructions" >> "$RESULTS"
+    done
+  done
+done
+
+# 加速比：同一 VLEN 下相对基准优化级别、同一优化级别下相对基准 VLEN（均按周期数），
+# 只有两边都通过且有计时数据时才计算；最后一行是各用例加速比的几何平均
+SPEEDUP="$OUT_DIR/speedup.csv"
+JSON="$OUT_DIR/results.json"
+awk -F, -v levels="$LEVELS" -v vlens="$VLENS" -v speedup="$SPEEDUP" -v json="$JSON" '
+function ok(key) { return (key in cycles) && cycles[key] > 0 && (status[key] == "AC" || status[key] == "RUN") }
+function ratio(base, key) { return (ok(base) && ok(key)) ? cycles[base] / cycles[key] : "" }
+function fmt(x) { return x == "" ? "" : sprintf("%.3f", x) }
+function jsonValue(x) { return x == "" ? "null" : x }
+NR == 1 { next }
+{
+  key = $1 SUBSEP $2 SUBSEP $3
+  if (!($1 in seen)) { seen[$1] = 1; names[++nameCount] = $1 }
+  status[key] = $4; exitCode[key] = $5
+  if ($6 != "") { cycles[key] = $6 }
+  instructions[key] = $7
+}
+END {
+  levelCount = split(levels, levelList, " ")
+  vlenCount = split(vlens, vlenList, " ")
+
+  header = "name,vlen"
+  for (l = 2; l <= levelCount; l++) { header = header ",O" levelList[l] "/O" levelList[1] }
+  for (v = 2; v <= vlenCount; v++) {
+    for (l = 1; l <= levelCount; l++) { header = header ",O" levelList[l] ":vlen" vlenList[v] "/vlen" vlenList[1] }
+  }
+  print header > speedup
+  for (v = 1; v <= vlenCount; v++) {
+    for (n = 1; n <= nameCount; n++) {
+      name = names[n]
+      line = name "," vlenList[v]
+      for (l = 2; l <= levelCount; l++) {
+        r = ratio(name SUBSEP levelList[1] SUBSEP vlenList[v], name SUBSEP levelList[l] SUBSEP vlenList[v])
+        line = line "," fmt(r)
+        if (r != "") { logSum[v, l] += log(r); logCount[v, l]++ }
+      }
+      for (w = 2; w <= vlenCount; w++) {
+        for (l = 1; l <= levelCount; l++) {
+          r = (v == 1) ? ratio(name SUBSEP levelList[l] SUBSEP vlenList[1], name SUBSEP levelList[l] SUBSEP vlenList[w]) : ""
+          line = line "," fmt(r)
+          if (r != "") { vlenLogSum[w, l] += log(r); vlenLogCount[w, l]++ }
+        }
+      }
+      # VLEN 间的加速比与 vlen 列无关，只写在基准 VLEN 的行中
+      print line > speedup
+    }
+  }
+  for (v = 1; v <= vlenCount; v++) {
+    line = "geomean," vlenList[v]
+    for (l = 2; l <= levelCount; l++) {
+      line = line "," (logCount[v, l] > 0 ? fmt(exp(logSum[v, l] / logCount[v, l])) : "")
+    }
+    for (w = 2; w <= vlenCount; w++) {
+      for (l = 1; l <= levelCount; l++) {
+        line = line "," ((v == 1 && vlenLogCount[w, l] > 0) ? fmt(exp(vlenLogSum[w, l] / vlenLogCount[w, l])) : "")
+      }
+    }
+    print line > speedup
+  }
+
+  printf "{\n  \"baseline\": {\"opt\": %s, \"vlen\": %s},\n  \"results\": [", levelList[1], vlenList[1] > json
+  first = 1
+  for (n = 1; n <= nameCount; n++) {
+    name = names[n]
+    for (v = 1; v <= vlenCount; v++) {
+      for (l = 1; l <= levelCount; l++) {
+        key = name SUBSEP levelList[l] SUBSEP vlenList[v]
+        if (!(key in status)) { continue }
+        printf "%s\n    {\"name\": \"%s\", \"opt\": %s, \"vlen\": %s, \"status\": \"%s\", \"exit_code\": %s, \"cycles\": %s, \"instructions\": %s, \"speedup_vs_opt\": %s, \"speedup_vs_vlen\": %s}", \
+          (first ? "" : ","), name, levelList[l], vlenList[v], status[key], jsonValue(exitCode[key]), \
+          jsonValue(cycles[key]), jsonValue(instructions[key]), \
+          jsonValue(fmt(ratio(name SUBSEP levelList[1] SUBSEP vlenList[v], key))), \
+          jsonValue(fmt(ratio(name SUBSEP levelList[l] SUBSEP vlenList[1], key))) > json
+        first = 0
+      }
+    }
+  }
+  printf "\n  ]\n}\n" > json
+}' "$RESULTS"
+
+echo "Passed: $PASSED, failed: $FAILED"
+echo "Results written to $RESULTS, $SPEEDUP and $JSON"
+# 终端上的表格中空白的加速比显示为 -
+sed -e ':a' -e 's/,,/,-,/' -e 'ta' -e 's/,$/,-/' "$SPEEDUP" | { column -s, -t 2>/dev/null || tr , '\t'; }
+[[ $FAILED -eq 0 ]]
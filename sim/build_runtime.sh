@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# 编译独立环境的 SysY 运行库 sim/sylib.c -> sim/build/sylib.o，供 run_qemu.sh 链接
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+BUILD_DIR="$SCRIPT_DIR/build"
+RUNTIME="$BUILD_DIR/sylib.o"
+mkdir -p "$BUILD_DIR"
+
+source "$SCRIPT_DIR/toolchain.sh"
+
+# 运行库本身不使用向量扩展；-fno-builtin 与 -fno-tree-loop-distribute-patterns
+# 防止编译器把 memset/memcpy 中的循环又识别成对它们自己的调用
+EXTRA_FLAGS=""
+if [[ "$CC" != "clang" ]]; then
+  EXTRA_FLAGS="-fno-tree-loop-distribute-patterns"
+fi
+
+$CC $TARGET_FLAGS -march=rv64gc \
+  -O2 -ffreestanding -fno-builtin -nostdlib -mcmodel=medany $EXTRA_FLAGS \
+  -c "$SCRIPT_DIR/sylib.c" \
+  -o "$RUNTIME"
+
+echo "Built $RUNTIME"
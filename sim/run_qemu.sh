@@ -2,13 +2,14 @@
 set -euo pipefail
 
 if [[ $# -lt 1 ]]; then
-  echo "Usage: $0 <test.s> [--gdb] [--gdb-port <port>]" >&2
+  echo "Usage: $0 <test.s|test.o> [--gdb] [--gdb-port <port>] [--vlen <bits>]" >&2
   exit 1
 fi
 
 INPUT="$1"
 USE_GDB=false
 GDB_PORT=1234
+VLEN=""
 shift
 
 while [[ $# -gt 0 ]]; do
@@ -25,6 +26,14 @@ while [[ $# -gt 0 ]]; do
       GDB_PORT="$2"
       shift 2
       ;;
+    --vlen)
+      if [[ $# -lt 2 ]]; then
+        echo "Missing value for --vlen" >&2
+        exit 1
+      fi
+      VLEN="$2"
+      shift 2
+      ;;
     *)
       echo "Unknown option: $1" >&2
       exit 1
@@ -36,6 +45,13 @@ if [[ ! -f "$INPUT" ]]; then
   exit 1
 fi
 
+# 未指定 VLEN 时从 arch 属性中读取编译器使用的 zvl<N>b，默认 128
+# （汇编的 .attribute arch 与目标文件的 .riscv.attributes 节都以明文保存该字符串）
+if [[ -z "$VLEN" ]]; then
+  VLEN="$(grep -ao 'zvl[0-9]*b' "$INPUT" | tr -dc '0-9\n' | sort -n | tail -n 1 || true)"
+  VLEN="${VLEN:-128}"
+fi
+
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 BUILD_DIR="$SCRIPT_DIR/build"
 mkdir -p "$BUILD_DIR"
@@ -44,18 +60,12 @@ BASE_NAME="$(basename "$INPUT")"
 NAME="${BASE_NAME%.*}"
 ELF_OUT="$BUILD_DIR/${NAME}.elf"
 
-if command -v riscv64-unknown-elf-gcc >/dev/null 2>&1; then
-  CC="riscv64-unknown-elf-gcc"
-  TARGET_FLAGS="-march=rv64gcv -mabi=lp64d"
-elif command -v riscv64-linux-gnu-gcc >/dev/null 2>&1; then
-  CC="riscv64-linux-gnu-gcc"
-  TARGET_FLAGS="-march=rv64gcv -mabi=lp64d"
-elif command -v clang >/dev/null 2>&1; then
-  CC="clang"
-  TARGET_FLAGS="--target=riscv64-unknown-elf -march=rv64gcv -mabi=lp64d -fuse-ld=lld"
-else
-  echo "No RISC-V toolchain found. Please install riscv64-unknown-elf-gcc, riscv64-linux-gnu-gcc, or clang." >&2
-  exit 1
+source "$SCRIPT_DIR/toolchain.sh"
+
+# SysY 运行库只在 sylib.c 更新后重新编译
+RUNTIME="$BUILD_DIR/sylib.o"
+if [[ ! -f "$RUNTIME" || "$SCRIPT_DIR/sylib.c" -nt "$RUNTIME" ]]; then
+  "$SCRIPT_DIR/build_runtime.sh" >/dev/null
 fi
 
 if ! command -v qemu-system-riscv64 >/dev/null 2>&1; then
@@ -69,20 +79,32 @@ $CC $TARGET_FLAGS \
   -T "$SCRIPT_DIR/riscv.ld" \
   "$SCRIPT_DIR/start.S" \
   "$INPUT" \
+  "$RUNTIME" \
   -o "$ELF_OUT"
 
 echo "$ELF_OUT" > "$BUILD_DIR/.last_elf"
 
+# 程序的输入输出都经由 semihosting 控制台：接到 QEMU 的 stdio 上（可以重定向 stdin 输入测试数据），
+# 不再另开串口和监视器
 QEMU_ARGS=(
   -machine virt
-  -cpu rv64,v=true,vlen=128,elen=64
+  -cpu rv64,v=true,vlen=$VLEN,elen=64
   -m 128M
-  -nographic
+  -display none
+  -serial none
+  -monitor none
   -bios none
   -kernel "$ELF_OUT"
-  -semihosting
+  -chardev stdio,id=semihost
+  -semihosting-config enable=on,target=native,chardev=semihost
 )
 
+# 额外的 QEMU 参数（如 bench.sh 使用的 -icount），以空格分隔
+if [[ -n "${QEMU_FLAGS:-}" ]]; then
+  read -ra EXTRA_QEMU_ARGS <<< "$QEMU_FLAGS"
+  QEMU_ARGS+=("${EXTRA_QEMU_ARGS[@]}")
+fi
+
 if [[ "$USE_GDB" == true ]]; then
   if ! command -v gdb-multiarch >/dev/null 2>&1; then
     echo "gdb-multiarch not found. Please install gdb-multiarch." >&2
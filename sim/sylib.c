@@ -0,0 +1,950 @@
+// SysY 运行库（独立环境版）：供 sim/run_qemu.sh 在 qemu-system-riscv64 上链接运行。
+//
+// 不依赖 libc：输入输出通过 RISC-V semihosting 读写宿主的终端（带缓冲，退出时刷新），
+// putf 自带 printf 风格的格式化，starttime/stoptime 读取 rdcycle/rdinstret，
+// 按 (开始行, 结束行) 累计周期数与指令数，程序结束时输出到 stderr。
+// 由 sim/build_runtime.sh 编译为 sim/build/sylib.o（make runtime）。
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------- semihosting ----------
+
+#define SYS_OPEN 0x01
+#define SYS_WRITE 0x05
+#define SYS_READ 0x06
+#define SYS_EXIT 0x18
+#define ADP_STOPPED_APPLICATION_EXIT 0x20026
+
+// 调用约定：a0 为操作号，a1 指向参数块；ebreak 前后必须是这两条固定的 slli/srai（不能压缩）
+static long semihost(long op, void* args) {
+    register long a0 __asm__("a0") = op;
+    register void* a1 __asm__("a1") = args;
+    __asm__ volatile(".option push\n"
+                     ".balign 16\n"
+                     ".option norvc\n"
+                     "slli zero, zero, 0x1f\n"
+                     "ebreak\n"
+                     "srai zero, zero, 0x7\n"
+                     ".option pop\n"
+                     : "+r"(a0)
+                     : "r"(a1)
+                     : "memory");
+    return a0;
+}
+
+// 打开宿主终端 ":tt"：模式 0 为 stdin，4 为 stdout，8 为 stderr
+static long openConsole(long mode) {
+    long args[3] = {(long)":tt", mode, 3};
+    return semihost(SYS_OPEN, args);
+}
+
+// ---------- 带缓冲的输出 ----------
+
+#define BUFFER_SIZE 4096
+
+typedef struct {
+    long mode;
+    long handle;  // 首次使用时打开，-1 表示尚未打开
+    size_t length;
+    char data[BUFFER_SIZE];
+} OutputStream;
+
+static OutputStream stdoutStream = {4, -1, 0, {0}};
+static OutputStream stderrStream = {8, -1, 0, {0}};
+
+static void flushStream(OutputStream* stream) {
+    if (stream->length == 0) {
+        return;
+    }
+    if (stream->handle < 0) {
+        stream->handle = openConsole(stream->mode);
+    }
+    // SYS_WRITE 返回未写出的字节数
+    size_t written = 0;
+    while (written < stream->length) {
+        long args[3] = {stream->handle, (long)(stream->data + written), (long)(stream->length - written)};
+        long remaining = semihost(SYS_WRITE, args);
+        if (remaining < 0 || (size_t)remaining == stream->length - written) {
+            break;
+        }
+        written = stream->length - (size_t)remaining;
+    }
+    stream->length = 0;
+}
+
+static void writeChar(OutputStream* stream, char c) {
+    if (stream->length == BUFFER_SIZE) {
+        flushStream(stream);
+    }
+    stream->data[stream->length++] = c;
+}
+
+static void writeChars(OutputStream* stream, const char* s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        writeChar(stream, s[i]);
+    }
+}
+
+// ---------- 带缓冲的输入 ----------
+
+static long stdinHandle = -1;
+static char inputData[BUFFER_SIZE];
+static size_t inputPos = 0;
+static size_t inputLength = 0;
+static int inputEOF = 0;
+
+// 读一个字符，输入结束时返回 -1；读之前刷新 stdout，交互运行时先看到提示
+static int peekChar(void) {
+    if (inputPos == inputLength) {
+        if (inputEOF) {
+            return -1;
+        }
+        flushStream(&stdoutStream);
+        if (stdinHandle < 0) {
+            stdinHandle = openConsole(0);
+        }
+        // SYS_READ 返回未读入的字节数，一个字节都没读到表示输入结束
+        long args[3] = {stdinHandle, (long)inputData, BUFFER_SIZE};
+        long remaining = semihost(SYS_READ, args);
+        if (remaining < 0 || remaining >= BUFFER_SIZE) {
+            inputEOF = 1;
+            return -1;
+        }
+        inputPos = 0;
+        inputLength = BUFFER_SIZE - (size_t)remaining;
+    }
+    return (unsigned char)inputData[inputPos];
+}
+
+static int readChar(void) {
+    int c = peekChar();
+    if (c >= 0) {
+        inputPos++;
+    }
+    return c;
+}
+
+static int isSpace(int c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+static int isDigit(int c) { return c >= '0' && c <= '9'; }
+
+static int hexValue(int c) {
+    if (isDigit(c)) {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static void skipSpaces(void) {
+    while (isSpace(peekChar())) {
+        readChar();
+    }
+}
+
+// x * 2^exp，逐次乘 2 的幂，不依赖 libm
+static double scaleBy2(double x, int exp) {
+    while (exp > 60) {
+        x *= 1152921504606846976.0;  // 2^60
+        exp -= 60;
+    }
+    while (exp < -60) {
+        x /= 1152921504606846976.0;
+        exp += 60;
+    }
+    return exp >= 0 ? x * (double)(1ULL << exp) : x / (double)(1ULL << -exp);
+}
+
+static double scaleBy10(double x, int exp) {
+    double factor = 10.0;
+    int n = exp < 0 ? -exp : exp;
+    double scale = 1.0;
+    while (n > 0) {
+        if (n & 1) {
+            scale *= factor;
+        }
+        factor *= factor;
+        n >>= 1;
+    }
+    return exp < 0 ? x / scale : x * scale;
+}
+
+// 按 scanf("%a") 的规则读浮点数：十进制（可带小数点和 e 指数）或 0x 开头的十六进制（p 指数）
+static double readFloat(void) {
+    skipSpaces();
+    int negative = 0;
+    if (peekChar() == '-' || peekChar() == '+') {
+        negative = readChar() == '-';
+    }
+    uint64_t mantissa = 0;
+    int exponent = 0;  // 十进制时为 10 的幂，十六进制时为 2 的幂
+    int hex = 0;
+    if (peekChar() == '0') {
+        readChar();
+        if (peekChar() == 'x' || peekChar() == 'X') {
+            readChar();
+            hex = 1;
+        }
+    }
+    int base = hex ? 16 : 10;
+    int seenPoint = 0;
+    for (;;) {
+        int c = peekChar();
+        int digit = hex ? hexValue(c) : (isDigit(c) ? c - '0' : -1);
+        if (c == '.' && !seenPoint) {
+            seenPoint = 1;
+        } else if (digit >= 0) {
+            // 超出 64 位精度的低位数字只记指数
+            if (mantissa < (hex ? (1ULL << 59) : 100000000000000000ULL)) {
+                mantissa = mantissa * base + digit;
+                if (seenPoint) {
+                    exponent -= hex ? 4 : 1;
+                }
+            } else if (!seenPoint) {
+                exponent += hex ? 4 : 1;
+            }
+        } else {
+            break;
+        }
+        readChar();
+    }
+    int c = peekChar();
+    if ((hex && (c == 'p' || c == 'P')) || (!hex && (c == 'e' || c == 'E'))) {
+        readChar();
+        int expNegative = 0;
+        if (peekChar() == '-' || peekChar() == '+') {
+            expNegative = readChar() == '-';
+        }
+        int value = 0;
+        while (isDigit(peekChar())) {
+            if (value < 100000) {
+                value = value * 10 + (readChar() - '0');
+            } else {
+                readChar();
+            }
+        }
+        exponent += expNegative ? -value : value;
+    }
+    double result = hex ? scaleBy2((double)mantissa, exponent) : scaleBy10((double)mantissa, exponent);
+    return negative ? -result : result;
+}
+
+// ---------- 浮点数的十进制展开 ----------
+
+// 以 10^9 为基的大整数（低位在前），足够表示 double 的精确十进制展开（最多约 770 位）
+#define BIGNUM_LIMBS 90
+
+typedef struct {
+    uint32_t limbs[BIGNUM_LIMBS];
+    int size;
+} BigNum;
+
+static void bigMultiply(BigNum* n, uint32_t factor) {
+    uint64_t carry = 0;
+    for (int i = 0; i < n->size; i++) {
+        uint64_t product = (uint64_t)n->limbs[i] * factor + carry;
+        n->limbs[i] = (uint32_t)(product % 1000000000);
+        carry = product / 1000000000;
+    }
+    while (carry > 0 && n->size < BIGNUM_LIMBS) {
+        n->limbs[n->size++] = (uint32_t)(carry % 1000000000);
+        carry /= 1000000000;
+    }
+}
+
+// |value| 的全部有效数字写入 digits（不含前导零，值为 0 时为空），
+// 返回小数点前的位数 pt：|value| = 0.d1d2...dn * 10^pt
+static int decimalDigits(double value, char* digits, int* count) {
+    uint64_t bits;
+    __builtin_memcpy(&bits, &value, sizeof(bits));
+    int biasedExp = (int)((bits >> 52) & 0x7ff);
+    uint64_t mantissa = bits & ((1ULL << 52) - 1);
+    if (biasedExp == 0 && mantissa == 0) {
+        *count = 0;
+        return 1;
+    }
+    int exp2;
+    if (biasedExp == 0) {
+        exp2 = -1074;
+    } else {
+        mantissa |= 1ULL << 52;
+        exp2 = biasedExp - 1075;
+    }
+
+    // |value| = mantissa * 2^exp2；指数为负时写成 mantissa * 5^k / 10^k
+    BigNum n;
+    n.limbs[0] = (uint32_t)(mantissa % 1000000000);
+    n.limbs[1] = (uint32_t)(mantissa / 1000000000 % 1000000000);
+    n.limbs[2] = (uint32_t)(mantissa / 1000000000 / 1000000000);
+    n.size = n.limbs[2] ? 3 : (n.limbs[1] ? 2 : 1);
+    int fractionDigits = 0;
+    if (exp2 >= 0) {
+        for (int e = exp2; e > 0; e -= 29) {
+            bigMultiply(&n, 1U << (e < 29 ? e : 29));
+        }
+    } else {
+        fractionDigits = -exp2;
+        for (int e = -exp2; e > 0; e -= 13) {
+            uint32_t factor = 1;
+            for (int i = 0; i < (e < 13 ? e : 13); i++) {
+                factor *= 5;
+            }
+            bigMultiply(&n, factor);
+        }
+    }
+
+    int length = 0;
+    for (int i = n.size - 1; i >= 0; i--) {
+        uint32_t limb = n.limbs[i];
+        char chunk[9];
+        for (int j = 8; j >= 0; j--) {
+            chunk[j] = (char)('0' + limb % 10);
+            limb /= 10;
+        }
+        for (int j = 0; j < 9; j++) {
+            if (length > 0 || chunk[j] != '0') {
+                digits[length++] = chunk[j];
+            }
+        }
+    }
+    // 去掉末尾的零（只影响小数部分的位数）
+    int pt = length - fractionDigits;
+    while (length > 0 && digits[length - 1] == '0') {
+        length--;
+    }
+    *count = length;
+    return pt;
+}
+
+// 只保留前 keep 位有效数字，按舍入到偶数进位；返回新的 pt
+static int roundDigits(char* digits, int* count, int pt, int keep) {
+    if (keep >= *count) {
+        return pt;
+    }
+    if (keep < 0) {
+        *count = 0;
+        return pt;
+    }
+    int roundUp;
+    char first = digits[keep];
+    if (first != '5') {
+        roundUp = first > '5';
+    } else {
+        roundUp = keep + 1 < *count;  // 末尾零已去掉，5 之后还有数字即大于一半
+        if (!roundUp) {
+            roundUp = keep > 0 && (digits[keep - 1] - '0') % 2 == 1;
+        }
+    }
+    *count = keep;
+    if (!roundUp) {
+        while (*count > 0 && digits[*count - 1] == '0') {
+            (*count)--;
+        }
+        return pt;
+    }
+    int i = keep - 1;
+    while (i >= 0 && digits[i] == '9') {
+        i--;
+    }
+    if (i < 0) {
+        digits[0] = '1';
+        *count = 1;
+        return pt + 1;
+    }
+    digits[i]++;
+    *count = i + 1;
+    return pt;
+}
+
+// ---------- printf 风格的格式化 ----------
+
+typedef struct {
+    int leftAlign;
+    int zeroPad;
+    int plusSign;
+    int spaceSign;
+    int alternate;
+    int width;
+    int precision;  // -1 表示未指定
+} FormatSpec;
+
+#define DIGIT_BUFFER 800
+#define FIELD_BUFFER 1200
+
+static void writePadded(OutputStream* stream, const FormatSpec* spec, const char* prefix, const char* body,
+                        size_t bodyLength, int allowZeroPad) {
+    size_t prefixLength = 0;
+    while (prefix[prefixLength]) {
+        prefixLength++;
+    }
+    size_t total = prefixLength + bodyLength;
+    size_t padding = spec->width > 0 && (size_t)spec->width > total ? (size_t)spec->width - total : 0;
+    if (!spec->leftAlign && !(spec->zeroPad && allowZeroPad)) {
+        for (size_t i = 0; i < padding; i++) {
+            writeChar(stream, ' ');
+        }
+    }
+    writeChars(stream, prefix, prefixLength);
+    if (!spec->leftAlign && spec->zeroPad && allowZeroPad) {
+        for (size_t i = 0; i < padding; i++) {
+            writeChar(stream, '0');
+        }
+    }
+    writeChars(stream, body, bodyLength);
+    if (spec->leftAlign) {
+        for (size_t i = 0; i < padding; i++) {
+            writeChar(stream, ' ');
+        }
+    }
+}
+
+static const char* signPrefix(int negative, const FormatSpec* spec) {
+    if (negative) {
+        return "-";
+    }
+    return spec->plusSign ? "+" : (spec->spaceSign ? " " : "");
+}
+
+static void formatInteger(OutputStream* stream, const FormatSpec* spec, uint64_t value, int negative,
+                          unsigned base, int upper) {
+    const char* digitChars = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char buffer[24];
+    int length = 0;
+    char body[FIELD_BUFFER];
+    size_t bodyLength = 0;
+    while (value > 0) {
+        buffer[length++] = digitChars[value % base];
+        value /= base;
+    }
+    // 精度为最少位数；精度为 0 且值为 0 时不输出数字
+    int minDigits = spec->precision < 0 ? 1 : spec->precision;
+    if (minDigits > FIELD_BUFFER - 24) {
+        minDigits = FIELD_BUFFER - 24;
+    }
+    if (base == 8 && spec->alternate && length >= minDigits) {
+        minDigits = length + 1;
+    }
+    for (int i = length; i < minDigits; i++) {
+        body[bodyLength++] = '0';
+    }
+    while (length > 0) {
+        body[bodyLength++] = buffer[--length];
+    }
+    const char* prefix = signPrefix(negative, spec);
+    if (base == 16 && spec->alternate && bodyLength > 0 && !(bodyLength == 1 && body[0] == '0')) {
+        prefix = upper ? "0X" : "0x";
+    } else if (base != 10) {
+        prefix = "";
+    }
+    writePadded(stream, spec, prefix, body, bodyLength, spec->precision < 0);
+}
+
+// %f/%e/%g 的数字部分（不含符号），返回长度
+static size_t formatDecimal(char* body, double value, char conversion, int precision, int alternate) {
+    char digits[DIGIT_BUFFER];
+    int count;
+    int pt = decimalDigits(value, digits, &count);
+    int upper = conversion == 'E' || conversion == 'G';
+    int strip = 0;
+    size_t length = 0;
+
+    if (conversion == 'g' || conversion == 'G') {
+        // 按 %e 的指数 X 选择：P > X >= -4 时用 %f（精度 P-1-X），否则用 %e（精度 P-1）
+        int p = precision == 0 ? 1 : precision;
+        char rounded[DIGIT_BUFFER];
+        int roundedCount = count;
+        __builtin_memcpy(rounded, digits, (size_t)count);
+        int roundedPt = roundDigits(rounded, &roundedCount, pt, p);
+        int x = roundedCount == 0 ? 0 : roundedPt - 1;
+        if (p > x && x >= -4) {
+            conversion = 'f';
+            precision = p - 1 - x;
+        } else {
+            conversion = 'e';
+            precision = p - 1;
+        }
+        strip = !alternate;
+    }
+    if (precision > FIELD_BUFFER - 360) {
+        precision = FIELD_BUFFER - 360;
+    }
+
+    if (conversion == 'f' || conversion == 'F') {
+        pt = roundDigits(digits, &count, pt, pt + precision);
+        if (count == 0 || pt <= 0) {
+            body[length++] = '0';
+        } else {
+            for (int i = 0; i < pt; i++) {
+                body[length++] = i < count ? digits[i] : '0';
+            }
+        }
+        if (precision > 0 || alternate) {
+            body[length++] = '.';
+        }
+        for (int i = 0; i < precision; i++) {
+            int index = pt + i;
+            body[length++] = index >= 0 && index < count ? digits[index] : '0';
+        }
+    } else {
+        pt = roundDigits(digits, &count, pt, precision + 1);
+        int exp10 = count == 0 ? 0 : pt - 1;
+        body[length++] = count > 0 ? digits[0] : '0';
+        if (precision > 0 || alternate) {
+            body[length++] = '.';
+        }
+        for (int i = 1; i <= precision; i++) {
+            body[length++] = i < count ? digits[i] : '0';
+        }
+        if (strip) {
+            // %g：去掉尾数末尾的零和小数点
+            while (length > 1 && body[length - 1] == '0') {
+                length--;
+            }
+            if (body[length - 1] == '.') {
+                length--;
+            }
+        }
+        char exponent[8];
+        int expLength = 0;
+        int absExp = exp10 < 0 ? -exp10 : exp10;
+        do {
+            exponent[expLength++] = (char)('0' + absExp % 10);
+            absExp /= 10;
+        } while (absExp > 0);
+        if (expLength < 2) {
+            exponent[expLength++] = '0';
+        }
+        body[length++] = upper ? 'E' : 'e';
+        body[length++] = exp10 < 0 ? '-' : '+';
+        while (expLength > 0) {
+            body[length++] = exponent[--expLength];
+        }
+        return length;
+    }
+    if (strip && precision > 0) {
+        while (body[length - 1] == '0') {
+            length--;
+        }
+        if (body[length - 1] == '.') {
+            length--;
+        }
+    }
+    return length;
+}
+
+// %a：十六进制浮点数，默认输出能精确表示该值的最少位数（与 glibc 相同）
+static size_t formatHexFloat(char* body, double value, int precision, int upper) {
+    const char* digitChars = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint64_t bits;
+    __builtin_memcpy(&bits, &value, sizeof(bits));
+    int biasedExp = (int)((bits >> 52) & 0x7ff);
+    uint64_t mantissa = bits & ((1ULL << 52) - 1);
+    int leading;
+    int exp2;
+    if (biasedExp == 0) {
+        leading = 0;
+        exp2 = mantissa == 0 ? 0 : -1022;
+    } else {
+        leading = 1;
+        exp2 = biasedExp - 1023;
+    }
+
+    int nibbles = 13;
+    if (precision >= 0 && precision < 13) {
+        // 舍入到 precision 个十六进制位（舍入到偶数），进位可能使首位变为 2
+        int shift = (13 - precision) * 4;
+        uint64_t full = ((uint64_t)leading << 52) | mantissa;
+        uint64_t rest = full & ((1ULL << shift) - 1);
+        uint64_t half = 1ULL << (shift - 1);
+        full >>= shift;
+        if (rest > half || (rest == half && (full & 1))) {
+            full++;
+        }
+        leading = (int)(full >> (precision * 4));
+        mantissa = precision > 0 ? (full & ((1ULL << (precision * 4)) - 1)) << shift : 0;
+        nibbles = precision;
+    } else if (precision < 0) {
+        while (nibbles > 0 && ((mantissa >> ((13 - nibbles) * 4)) & 0xf) == 0) {
+            nibbles--;
+        }
+    }
+
+    size_t length = 0;
+    body[length++] = '0';
+    body[length++] = upper ? 'X' : 'x';
+    body[length++] = (char)('0' + leading);
+    int totalNibbles = precision > 13 ? precision : nibbles;
+    if (totalNibbles > 0) {
+        body[length++] = '.';
+    }
+    for (int i = 0; i < totalNibbles; i++) {
+        body[length++] = i < 13 ? digitChars[(mantissa >> ((12 - i) * 4)) & 0xf] : '0';
+    }
+    body[length++] = upper ? 'P' : 'p';
+    body[length++] = exp2 < 0 ? '-' : '+';
+    char exponent[8];
+    int expLength = 0;
+    int absExp = exp2 < 0 ? -exp2 : exp2;
+    do {
+        exponent[expLength++] = (char)('0' + absExp % 10);
+        absExp /= 10;
+    } while (absExp > 0);
+    while (expLength > 0) {
+        body[length++] = exponent[--expLength];
+    }
+    return length;
+}
+
+static void formatFloat(OutputStream* stream, const FormatSpec* spec, double value, char conversion) {
+    uint64_t bits;
+    __builtin_memcpy(&bits, &value, sizeof(bits));
+    int negative = (int)(bits >> 63);
+    int upper = conversion >= 'A' && conversion <= 'Z';
+    const char* prefix = signPrefix(negative, spec);
+    char body[FIELD_BUFFER];
+    size_t length;
+    if (((bits >> 52) & 0x7ff) == 0x7ff) {
+        const char* text = (bits & ((1ULL << 52) - 1)) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+        writePadded(stream, spec, prefix, text, 3, 0);
+        return;
+    }
+    bits &= ~(1ULL << 63);
+    __builtin_memcpy(&value, &bits, sizeof(bits));
+    if (conversion == 'a' || conversion == 'A') {
+        length = formatHexFloat(body, value, spec->precision, upper);
+    } else {
+        length = formatDecimal(body, value, conversion, spec->precision < 0 ? 6 : spec->precision, spec->alternate);
+    }
+    writePadded(stream, spec, prefix, body, length, 1);
+}
+
+static void formatTo(OutputStream* stream, const char* format, va_list args) {
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') {
+            writeChar(stream, *p);
+            continue;
+        }
+        FormatSpec spec = {0, 0, 0, 0, 0, 0, -1};
+        for (p++;; p++) {
+            if (*p == '-') {
+                spec.leftAlign = 1;
+            } else if (*p == '0') {
+                spec.zeroPad = 1;
+            } else if (*p == '+') {
+                spec.plusSign = 1;
+            } else if (*p == ' ') {
+                spec.spaceSign = 1;
+            } else if (*p == '#') {
+                spec.alternate = 1;
+            } else {
+                break;
+            }
+        }
+        if (*p == '*') {
+            spec.width = va_arg(args, int);
+            if (spec.width < 0) {
+                spec.leftAlign = 1;
+                spec.width = -spec.width;
+            }
+            p++;
+        } else {
+            while (isDigit(*p)) {
+                spec.width = spec.width * 10 + (*p++ - '0');
+            }
+        }
+        if (*p == '.') {
+            p++;
+            spec.precision = 0;
+            if (*p == '*') {
+                spec.precision = va_arg(args, int);
+                p++;
+            } else {
+                while (isDigit(*p)) {
+                    spec.precision = spec.precision * 10 + (*p++ - '0');
+                }
+            }
+        }
+        int longArg = 0;
+        while (*p == 'l' || *p == 'h' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L') {
+            longArg |= *p == 'l' || *p == 'z' || *p == 'j' || *p == 't';
+            p++;
+        }
+        switch (*p) {
+            case 'd':
+            case 'i': {
+                int64_t value = longArg ? va_arg(args, long) : va_arg(args, int);
+                formatInteger(stream, &spec, value < 0 ? 0 - (uint64_t)value : (uint64_t)value, value < 0, 10, 0);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                uint64_t value = longArg ? va_arg(args, unsigned long) : va_arg(args, unsigned);
+                unsigned base = *p == 'u' ? 10 : (*p == 'o' ? 8 : 16);
+                formatInteger(stream, &spec, value, 0, base, *p == 'X');
+                break;
+            }
+            case 'p': {
+                spec.alternate = 1;
+                formatInteger(stream, &spec, (uint64_t)va_arg(args, void*), 0, 16, 0);
+                break;
+            }
+            case 'c': {
+                char c = (char)va_arg(args, int);
+                writePadded(stream, &spec, "", &c, 1, 0);
+                break;
+            }
+            case 's': {
+                const char* s = va_arg(args, const char*);
+                if (!s) {
+                    s = "(null)";
+                }
+                size_t length = 0;
+                while (s[length] && (spec.precision < 0 || length < (size_t)spec.precision)) {
+                    length++;
+                }
+                writePadded(stream, &spec, "", s, length, 0);
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                formatFloat(stream, &spec, va_arg(args, double), *p);
+                break;
+            case '%':
+                writeChar(stream, '%');
+                break;
+            case '\0':
+                return;
+            default:
+                // 不认识的转换原样输出
+                writeChar(stream, '%');
+                writeChar(stream, *p);
+                break;
+        }
+    }
+}
+
+static void printTo(OutputStream* stream, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    formatTo(stream, format, args);
+    va_end(args);
+}
+
+// ---------- SysY 库函数 ----------
+
+int getint(void) {
+    skipSpaces();
+    int negative = 0;
+    if (peekChar() == '-' || peekChar() == '+') {
+        negative = readChar() == '-';
+    }
+    unsigned value = 0;
+    while (isDigit(peekChar())) {
+        value = value * 10 + (unsigned)(readChar() - '0');
+    }
+    return negative ? (int)(0U - value) : (int)value;
+}
+
+int getch(void) {
+    return readChar();
+}
+
+float getfloat(void) {
+    return (float)readFloat();
+}
+
+int getarray(int a[]) {
+    int n = getint();
+    for (int i = 0; i < n; i++) {
+        a[i] = getint();
+    }
+    return n;
+}
+
+int getfarray(float a[]) {
+    int n = getint();
+    for (int i = 0; i < n; i++) {
+        a[i] = getfloat();
+    }
+    return n;
+}
+
+void putint(int a) {
+    printTo(&stdoutStream, "%d", a);
+}
+
+void putch(int a) {
+    writeChar(&stdoutStream, (char)a);
+}
+
+void putfloat(float a) {
+    printTo(&stdoutStream, "%a", (double)a);
+}
+
+void putarray(int n, int a[]) {
+    printTo(&stdoutStream, "%d:", n);
+    for (int i = 0; i < n; i++) {
+        printTo(&stdoutStream, " %d", a[i]);
+    }
+    writeChar(&stdoutStream, '\n');
+}
+
+void putfarray(int n, float a[]) {
+    printTo(&stdoutStream, "%d:", n);
+    for (int i = 0; i < n; i++) {
+        printTo(&stdoutStream, " %a", (double)a[i]);
+    }
+    writeChar(&stdoutStream, '\n');
+}
+
+void putf(char a[], ...) {
+    va_list args;
+    va_start(args, a);
+    formatTo(&stdoutStream, a, args);
+    va_end(args);
+}
+
+// ---------- 计时 ----------
+
+#define MAX_TIMERS 1024
+
+typedef struct {
+    int startLine;
+    int stopLine;
+    unsigned calls;
+    uint64_t cycles;
+    uint64_t instructions;
+} Timer;
+
+static Timer timers[MAX_TIMERS];
+static int timerCount = 0;
+static int startLine = 0;
+static uint64_t startCycles = 0;
+static uint64_t startInstructions = 0;
+
+static inline uint64_t readCycles(void) {
+    uint64_t value;
+    __asm__ volatile("rdcycle %0" : "=r"(value));
+    return value;
+}
+
+static inline uint64_t readInstructions(void) {
+    uint64_t value;
+    __asm__ volatile("rdinstret %0" : "=r"(value));
+    return value;
+}
+
+void _sysy_starttime(int lineno) {
+    startLine = lineno;
+    startInstructions = readInstructions();
+    startCycles = readCycles();
+}
+
+// 同一对 (starttime 行, stoptime 行) 的多次计时累加到一项
+void _sysy_stoptime(int lineno) {
+    uint64_t cycles = readCycles() - startCycles;
+    uint64_t instructions = readInstructions() - startInstructions;
+    int i = 0;
+    while (i < timerCount && !(timers[i].startLine == startLine && timers[i].stopLine == lineno)) {
+        i++;
+    }
+    if (i == timerCount) {
+        if (timerCount == MAX_TIMERS) {
+            i = MAX_TIMERS - 1;  // 计时位置过多时并入最后一项
+        } else {
+            timers[timerCount++] = (Timer){startLine, lineno, 0, 0, 0};
+        }
+    }
+    timers[i].calls++;
+    timers[i].cycles += cycles;
+    timers[i].instructions += instructions;
+}
+
+// ---------- 内存函数（LLVM 会把 memset/memcpy 内建函数降级为对它们的调用） ----------
+
+void* memset(void* dest, int c, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    while (n > 0 && ((uintptr_t)d & 7)) {
+        *d++ = (unsigned char)c;
+        n--;
+    }
+    uint64_t pattern = (unsigned char)c * 0x0101010101010101ULL;
+    for (; n >= 8; n -= 8, d += 8) {
+        *(uint64_t*)d = pattern;
+    }
+    while (n-- > 0) {
+        *d++ = (unsigned char)c;
+    }
+    return dest;
+}
+
+void* memcpy(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    if ((((uintptr_t)d ^ (uintptr_t)s) & 7) == 0) {
+        while (n > 0 && ((uintptr_t)d & 7)) {
+            *d++ = *s++;
+            n--;
+        }
+        for (; n >= 8; n -= 8, d += 8, s += 8) {
+            *(uint64_t*)d = *(const uint64_t*)s;
+        }
+    }
+    while (n-- > 0) {
+        *d++ = *s++;
+    }
+    return dest;
+}
+
+void* memmove(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    if (d <= s || d >= s + n) {
+        return memcpy(dest, src, n);
+    }
+    while (n-- > 0) {
+        d[n] = s[n];
+    }
+    return dest;
+}
+
+// ---------- 程序结束 ----------
+
+// 由 start.S 在 main 返回后调用：输出计时结果，刷新缓冲区，再通过 semihosting 以 main 的返回值退出
+void _sysy_exit(int code) {
+    if (timerCount > 0) {
+        uint64_t totalCycles = 0;
+        uint64_t totalInstructions = 0;
+        for (int i = 0; i < timerCount; i++) {
+            printTo(&stderrStream, "Timer@%04d-%04d: %lu cycles, %lu instructions (%u calls)\n",
+                    timers[i].startLine, timers[i].stopLine, timers[i].cycles, timers[i].instructions,
+                    timers[i].calls);
+            totalCycles += timers[i].cycles;
+            totalInstructions += timers[i].instructions;
+        }
+        printTo(&stderrStream, "TOTAL: %lu cycles, %lu instructions\n", totalCycles, totalInstructions);
+    }
+    flushStream(&stdoutStream);
+    flushStream(&stderrStream);
+
+    // RV64 的 SYS_EXIT 参数块是两个 64 位字：退出原因与退出码
+    long args[2] = {ADP_STOPPED_APPLICATION_EXIT, code & 0xff};
+    semihost(SYS_EXIT, args);
+    for (;;) {
+    }
+}
@@ -0,0 +1,14 @@
+# 由 run_qemu.sh 与 build_runtime.sh 引入：选择可用的 RISC-V 工具链，设置 CC 与 TARGET_FLAGS
+if command -v riscv64-unknown-elf-gcc >/dev/null 2>&1; then
+  CC="riscv64-unknown-elf-gcc"
+  TARGET_FLAGS="-march=rv64gcv -mabi=lp64d"
+elif command -v riscv64-linux-gnu-gcc >/dev/null 2>&1; then
+  CC="riscv64-linux-gnu-gcc"
+  TARGET_FLAGS="-march=rv64gcv -mabi=lp64d"
+elif command -v clang >/dev/null 2>&1; then
+  CC="clang"
+  TARGET_FLAGS="--target=riscv64-unknown-elf -march=rv64gcv -mabi=lp64d -fuse-ld=lld"
+else
+  echo "No RISC-V toolchain found. Please install riscv64-unknown-elf-gcc, riscv64-linux-gnu-gcc, or clang." >&2
+  exit 1
+fi
@@ -0,0 +1,291 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <utime.h>
+
+// 按内容寻址的编译缓存。
+//
+// 键是源文件内容、影响输出的选项和编译器自身标识的 SHA1；每个条目是一个文件
+// <dir>/<键的前两位>/<键>，依次保存一次编译的各个产物（.s/.o/.ll）。命中时直接写出产物，
+// 跳过整个编译流水线。
+//
+// 条目先写到同目录的临时文件再 rename，多个编译进程同时使用一个缓存目录也只会看到完整的条目；
+// 命中时更新条目的修改时间，总大小超过上限时按修改时间从旧到新淘汰（LRU）。
+class CompileCache {
+public:
+    // 一个产物：种类（asm/obj/ll）与输出路径
+    struct Output {
+        std::string kind;
+        std::string path;
+    };
+
+private:
+    struct EntryInfo {
+        std::string path;
+        uint64_t size;
+        llvm::sys::TimePoint<> modified;
+    };
+
+    static constexpr const char* MAGIC = "SYSYC-CACHE 1\n";
+    static constexpr unsigned PRUNE_INTERVAL = 32;  // 每写入这么多条目检查一次总大小
+
+    std::string dir;
+    uint64_t maxBytes;
+    std::mutex pruneMutex;
+    std::atomic<unsigned> hits{0};
+    std::atomic<unsigned> misses{0};
+    std::atomic<unsigned> stores{0};
+    std::atomic<unsigned> evictions{0};
+    std::atomic<unsigned> storesSincePrune{0};
+
+    std::string entryPath(const std::string& key) const {
+        llvm::SmallString<256> path(dir);
+        llvm::sys::path::append(path, key.substr(0, 2), key);
+        return std::string(path.str());
+    }
+
+    static bool readFile(const std::string& path, std::string& content) {
+        auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if (!buffer) {
+            return false;
+        }
+        content = (*buffer)->getBuffer().str();
+        return true;
+    }
+
+    static bool writeFile(const std::string& path, const std::string& content) {
+        std::error_code ec;
+        llvm::raw_fd_ostream out(path, ec, llvm::sys::fs::OF_None);
+        if (ec) {
+            return false;
+        }
+        out << content;
+        out.close();
+        if (out.has_error()) {
+            out.clear_error();
+            return false;
+        }
+        return true;
+    }
+
+    // 先写到同目录的临时文件再 rename 覆盖目标（rename 是原子的）
+    static bool writeFileAtomically(const std::string& path, const std::string& content) {
+        llvm::SmallString<256> tempPath;
+        int fd;
+        if (llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%%%", fd, tempPath)) {
+            return false;
+        }
+        llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+        out << content;
+        out.close();
+        if (out.has_error()) {
+            out.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return false;
+        }
+        if (llvm::sys::fs::rename(tempPath, path)) {
+            llvm::sys::fs::remove(tempPath);
+            return false;
+        }
+        return true;
+    }
+
+    // 条目格式：MAGIC 之后每个产物为 "<种类> <字节数>\n<内容>"
+    static bool parseEntry(const std::string& entry, std::vector<std::pair<std::string, std::string>>& parts) {
+        size_t magicLength = std::char_traits<char>::length(MAGIC);
+        if (entry.compare(0, magicLength, MAGIC) != 0) {
+            return false;
+        }
+        size_t pos = magicLength;
+        while (pos < entry.size()) {
+            size_t space = entry.find(' ', pos);
+            size_t newline = entry.find('\n', pos);
+            if (space == std::string::npos || newline == std::string::npos || space > newline) {
+                return false;
+            }
+            unsigned long long size;
+            if (llvm::StringRef(entry).slice(space + 1, newline).getAsInteger(10, size) ||
+                size > entry.size() - newline - 1) {
+                return false;
+            }
+            parts.emplace_back(entry.substr(pos, space - pos), entry.substr(newline + 1, size));
+            pos = newline + 1 + size;
+        }
+        return true;
+    }
+
+    // 读出一个条目并刷新它的修改时间（供 LRU 淘汰）
+    bool readEntry(const std::string& key, std::vector<std::pair<std::string, std::string>>& parts) {
+        std::string path = entryPath(key);
+        std::string entry;
+        if (!readFile(path, entry) || !parseEntry(entry, parts)) {
+            return false;
+        }
+        ::utime(path.c_str(), nullptr);
+        return true;
+    }
+
+    // 列出缓存中的全部条目（不含正在写入的临时文件），返回总大小
+    uint64_t scanEntries(std::vector<EntryInfo>& entries) const {
+        uint64_t total = 0;
+        std::error_code ec;
+        for (llvm::sys::fs::recursive_directory_iterator it(dir, ec), end; it != end && !ec; it.increment(ec)) {
+            llvm::sys::fs::file_status status;
+            if (llvm::sys::fs::status(it->path(), status) ||
+                status.type() != llvm::sys::fs::file_type::regular_file ||
+                it->path().find(".tmp-") != std::string::npos) {
+                continue;
+            }
+            entries.push_back({it->path(), status.getSize(), status.getLastModificationTime()});
+            total += status.getSize();
+        }
+        return total;
+    }
+
+public:
+    CompileCache(std::string dir, uint64_t maxBytes) : dir(std::move(dir)), maxBytes(maxBytes) {}
+
+    CompileCache(const CompileCache&) = delete;
+    CompileCache& operator=(const CompileCache&) = delete;
+
+    // 编译器自身的标识：LLVM 版本和可执行文件的大小、修改时间（重新链接后即变化）
+    static std::string compilerID() {
+        std::string id = LLVM_VERSION_STRING;
+        llvm::sys::fs::file_status status;
+        if (!llvm::sys::fs::status("/proc/self/exe", status)) {
+            id += ";" + std::to_string(status.getSize()) + ";" +
+                  std::to_string(status.getLastModificationTime().time_since_epoch().count());
+        }
+        return id;
+    }
+
+    // 缓存键：编译器标识、选项与源文件内容的 SHA1（十六进制）
+    static std::string computeKey(const std::string& source, const std::string& options) {
+        static const std::string id = compilerID();
+        llvm::SHA1 hasher;
+        hasher.update(id);
+        hasher.update(llvm::StringRef("\0", 1));
+        hasher.update(options);
+        hasher.update(llvm::StringRef("\0", 1));
+        hasher.update(source);
+        return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+    }
+
+    const std::string& getDirectory() const { return dir; }
+
+    // 读取 key 对应条目中的全部产物（种类与内容），不写任何文件
+    bool lookupParts(const std::string& key, std::vector<std::pair<std::string, std::string>>& parts) {
+        if (!readEntry(key, parts)) {
+            misses++;
+            return false;
+        }
+        hits++;
+        return true;
+    }
+
+    // 把若干产物（种类与内容）写成一个条目；每写入 PRUNE_INTERVAL 个条目检查一次总大小
+    bool storeParts(const std::string& key, const std::vector<std::pair<std::string, std::string>>& parts) {
+        std::string entry = MAGIC;
+        for (const auto& part : parts) {
+            entry += part.first + " " + std::to_string(part.second.size()) + "\n";
+            entry += part.second;
+        }
+        std::string path = entryPath(key);
+        if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(path)) ||
+            !writeFileAtomically(path, entry)) {
+            return false;
+        }
+        stores++;
+        if (++storesSincePrune >= PRUNE_INTERVAL) {
+            prune();
+        }
+        return true;
+    }
+
+    // 命中且条目包含全部 outputs 时把各产物写到对应路径
+    bool lookup(const std::string& key, const std::vector<Output>& outputs) {
+        std::vector<std::pair<std::string, std::string>> parts;
+        if (!readEntry(key, parts)) {
+            misses++;
+            return false;
+        }
+        for (const auto& output : outputs) {
+            auto it = std::find_if(parts.begin(), parts.end(),
+                                   [&](const auto& part) { return part.first == output.kind; });
+            if (it == parts.end() || !writeFile(output.path, it->second)) {
+                misses++;
+                return false;
+            }
+        }
+        hits++;
+        return true;
+    }
+
+    // 把刚生成的各产物读回并写成一个条目
+    bool store(const std::string& key, const std::vector<Output>& outputs) {
+        std::vector<std::pair<std::string, std::string>> parts;
+        for (const auto& output : outputs) {
+            std::string content;
+            if (!readFile(output.path, content)) {
+                return false;
+            }
+            parts.emplace_back(output.kind, std::move(content));
+        }
+        return storeParts(key, parts);
+    }
+
+    // 总大小超过上限时按修改时间从旧到新删除条目，降到上限的 90% 为止
+    void prune() {
+        std::lock_guard<std::mutex> lock(pruneMutex);
+        storesSincePrune = 0;
+        std::vector<EntryInfo> entries;
+        uint64_t total = scanEntries(entries);
+        if (total <= maxBytes) {
+            return;
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const EntryInfo& a, const EntryInfo& b) { return a.modified < b.modified; });
+        uint64_t target = maxBytes / 10 * 9;
+        for (const auto& entry : entries) {
+            if (total <= target) {
+                break;
+            }
+            // 其他进程可能已经删除了这个条目
+            if (!llvm::sys::fs::remove(entry.path)) {
+                total -= entry.size;
+                evictions++;
+            }
+        }
+    }
+
+    // 本进程的命中/未命中/写入/淘汰次数，以及缓存目录当前的条目数和总大小
+    void printStats(std::ostream& os) const {
+        std::vector<EntryInfo> entries;
+        uint64_t total = scanEntries(entries);
+        unsigned lookups = hits + misses;
+        os << "Cache: " << hits << " hits, " << misses << " misses";
+        if (lookups > 0) {
+            os << " (" << hits * 100 / lookups << "% hit rate)";
+        }
+        os << ", " << stores << " stored, " << evictions << " evicted; " << entries.size() << " entries, "
+           << total / 1024 << " KB of " << maxBytes / (1024 * 1024) << " MB in " << dir << std::endl;
+    }
+};
+
+#endif // COMPILE_CACHE_H
@@ -0,0 +1,174 @@
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+// 编译耗时报告：按编译阶段、AST 优化 pass 和函数记录墙钟时间、CPU 时间
+// 与峰值内存（RSS）增量，可输出为文本表格或 JSON（供 CI 跟踪编译时间回归）
+class TimeReport {
+public:
+    struct Entry {
+        std::string category;   // stage / ast-pass / function
+        std::string name;
+        int count = 0;          // 同名条目的累计次数
+        double wallMs = 0;
+        double cpuMs = 0;
+        long peakRSSDeltaKB = 0;
+    };
+
+    // 计时区间：构造时开始，stop() 或析构时累加到报告；report 为空时什么也不做
+    class Scope {
+    private:
+        TimeReport* report;
+        std::string category;
+        std::string name;
+        double wallStart;
+        double cpuStart;
+        long rssStart;
+
+    public:
+        Scope(TimeReport* report, const std::string& category, const std::string& name)
+            : report(report), category(category), name(name) {
+            if (report) {
+                wallStart = wallMs();
+                cpuStart = threadCPUMs();
+                rssStart = peakRSSKB();
+            }
+        }
+
+        ~Scope() { stop(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void stop() {
+            if (!report) {
+                return;
+            }
+            report->record(category, name, wallMs() - wallStart, threadCPUMs() - cpuStart,
+                           peakRSSKB() - rssStart);
+            report = nullptr;
+        }
+    };
+
+private:
+    bool json;
+    bool llvmTimers = false;     // 是否收集 LLVM 自带的 pass 计时（进程全局，仅单文件编译时开启）
+    std::vector<Entry> entries;
+    std::string llvmTimerText;   // 文本模式下为 LLVM 计时表，JSON 模式下为 "key": value 列表
+
+    static std::string escapeJSON(const std::string& text) {
+        std::string result;
+        for (char c : text) {
+            switch (c) {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                case '\n': result += "\\n"; break;
+                case '\t': result += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buffer[8];
+                        std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                        result += buffer;
+                    } else {
+                        result += c;
+                    }
+            }
+        }
+        return result;
+    }
+
+public:
+    explicit TimeReport(bool json = false) : json(json) {}
+
+    bool isJSON() const { return json; }
+
+    void setLLVMTimers(bool enable) { llvmTimers = enable; }
+    bool hasLLVMTimers() const { return llvmTimers; }
+
+    static double wallMs() {
+        using namespace std::chrono;
+        return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 当前线程的 CPU 时间（批量模式下各线程互不干扰）
+    static double threadCPUMs() {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+    }
+
+    // 进程的峰值 RSS（KB）
+    static long peakRSSKB() {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    // 累加一条记录，同类同名的记录合并
+    void record(const std::string& category, const std::string& name, double wall, double cpu, long rssDelta) {
+        for (auto& entry : entries) {
+            if (entry.category == category && entry.name == name) {
+                entry.count++;
+                entry.wallMs += wall;
+                entry.cpuMs += cpu;
+                entry.peakRSSDeltaKB += rssDelta;
+                return;
+            }
+        }
+        entries.push_back({category, name, 1, wall, cpu, rssDelta});
+    }
+
+    const std::vector<Entry>& getEntries() const { return entries; }
+
+    void appendLLVMTimers(const std::string& text) {
+        if (text.empty()) {
+            return;
+        }
+        if (json && !llvmTimerText.empty()) {
+            llvmTimerText += ",";
+        }
+        llvmTimerText += text;
+    }
+
+    void print(std::ostream& os, const std::string& file) const {
+        os << "===" << std::string(73, '-') << "===" << std::endl;
+        os << "  Compile time report: " << file << std::endl;
+        os << "===" << std::string(73, '-') << "===" << std::endl;
+        os << std::left << std::setw(10) << "Category" << std::setw(32) << "Name" << std::right
+           << std::setw(6) << "Count" << std::setw(12) << "Wall(ms)" << std::setw(12) << "CPU(ms)"
+           << std::setw(14) << "PeakRSS+(KB)" << std::endl;
+        os << std::fixed << std::setprecision(3);
+        for (const auto& entry : entries) {
+            os << std::left << std::setw(10) << entry.category << std::setw(32) << entry.name << std::right
+               << std::setw(6) << entry.count << std::setw(12) << entry.wallMs << std::setw(12) << entry.cpuMs
+               << std::setw(14) << entry.peakRSSDeltaKB << std::endl;
+        }
+        os.unsetf(std::ios::fixed);
+        os << "Peak RSS: " << peakRSSKB() << " KB" << std::endl;
+        if (!llvmTimerText.empty()) {
+            os << llvmTimerText;
+        }
+    }
+
+    void printJSON(std::ostream& os, const std::string& file) const {
+        os << "{\n  \"file\": \"" << escapeJSON(file) << "\",\n  \"entries\": [";
+        for (size_t i = 0; i < entries.size(); i++) {
+            const auto& entry = entries[i];
+            os << (i ? ",\n" : "\n") << "    {\"category\": \"" << entry.category << "\", \"name\": \""
+               << escapeJSON(entry.name) << "\", \"count\": " << entry.count << ", \"wall_ms\": " << entry.wallMs
+               << ", \"cpu_ms\": " << entry.cpuMs << ", \"peak_rss_delta_kb\": " << entry.peakRSSDeltaKB << "}";
+        }
+        os << "\n  ],\n  \"peak_rss_kb\": " << peakRSSKB() << ",\n  \"llvm_timers\": {" << llvmTimerText
+           << "\n  }\n}" << std::endl;
+    }
+};
+
+#endif // TIME_REPORT_H